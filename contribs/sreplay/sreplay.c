@@ -0,0 +1,422 @@
+/*****************************************************************************\
+ *  sreplay.c - replay a workload trace against a test cluster and report
+ *  the scheduler throughput.
+ *
+ *  The trace is the output of:
+ *	sacct -P -n -X -o JobIDRaw,Submit,TimelimitRaw,ElapsedRaw,NNodes,NCPUS
+ *
+ *  Each job is submitted at its trace submit time, divided by the time
+ *  compression factor, as a batch job sleeping for its compressed elapsed
+ *  time. Meant for a dedicated cluster, typically built with
+ *  --enable-multiple-slurmd or --enable-front-end to provide many nodes.
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "slurm/slurm.h"
+#include "slurm/slurm_errno.h"
+
+#include "src/common/macros.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+typedef struct {
+	time_t submit;		/* trace submit time */
+	uint32_t time_limit;	/* trace time limit, minutes or INFINITE */
+	uint32_t elapsed;	/* trace run time, seconds */
+	uint32_t nodes;
+	uint32_t cpus;
+	uint32_t job_id;	/* replayed job, 0 if not submitted */
+	bool started;		/* seen out of the pending state */
+} replay_job_t;
+
+static replay_job_t *jobs = NULL;
+static int job_cnt = 0;
+static replay_job_t **jobs_by_id = NULL;	/* submitted jobs, sorted by
+						 * job_id */
+static int jobs_by_id_cnt = 0;
+
+static double compress = 1.0;
+static int max_jobs = 0;
+static char *partition = NULL;
+static int sample_interval = 5;
+
+static void _usage(void)
+{
+	printf("Usage: sreplay [-c compress] [-i interval] [-n jobs] [-p partition] trace\n"
+	       "  -c, --compress=#   divide all of the trace times by #\n"
+	       "  -i, --interval=#   seconds between utilization samples (5)\n"
+	       "  -n, --jobs=#       replay the first # jobs of the trace\n"
+	       "  -p, --partition=   submit all jobs to this partition\n");
+}
+
+static uint32_t _parse_uint(char *str)
+{
+	if (!str || !isdigit((int) str[0]))
+		return INFINITE;
+	return (uint32_t) strtoul(str, NULL, 10);
+}
+
+static int _sort_by_submit(const void *x, const void *y)
+{
+	const replay_job_t *j1 = x, *j2 = y;
+
+	if (j1->submit < j2->submit)
+		return -1;
+	if (j1->submit > j2->submit)
+		return 1;
+	return 0;
+}
+
+/* Load the trace, sorted by submit time. RET count of jobs */
+static int _read_trace(char *path)
+{
+	FILE *fp;
+	char *line = NULL, *save_ptr, *tok[6];
+	size_t line_size = 0;
+	int alloc_cnt = 0, i, line_num = 0;
+	struct tm tm;
+
+	if (!(fp = fopen(path, "r"))) {
+		perror(path);
+		return -1;
+	}
+
+	while (getline(&line, &line_size, fp) > 0) {
+		replay_job_t *job;
+
+		line_num++;
+		line[strcspn(line, "\n")] = '\0';
+		save_ptr = line;
+		for (i = 0; i < 6; i++)
+			tok[i] = strsep(&save_ptr, "|");
+		if (!tok[5]) {
+			fprintf(stderr, "%s:%d: expected 6 fields\n",
+				path, line_num);
+			continue;
+		}
+
+		memset(&tm, 0, sizeof(tm));
+		tm.tm_isdst = -1;
+		if (!strptime(tok[1], "%Y-%m-%dT%H:%M:%S", &tm))
+			continue;	/* "Unknown" submit time */
+		if ((_parse_uint(tok[3]) == INFINITE) ||
+		    (_parse_uint(tok[5]) == INFINITE))
+			continue;
+
+		if (job_cnt >= alloc_cnt) {
+			alloc_cnt = MAX(1024, alloc_cnt * 2);
+			xrecalloc(jobs, alloc_cnt, sizeof(replay_job_t));
+		}
+		job = &jobs[job_cnt++];
+		job->submit = mktime(&tm);
+		job->time_limit = _parse_uint(tok[2]);
+		job->elapsed = _parse_uint(tok[3]);
+		job->nodes = MAX(_parse_uint(tok[4]), 1);
+		if (job->nodes == INFINITE)
+			job->nodes = 1;
+		job->cpus = MAX(_parse_uint(tok[5]), job->nodes);
+	}
+	free(line);
+	fclose(fp);
+
+	qsort(jobs, job_cnt, sizeof(replay_job_t), _sort_by_submit);
+	if (max_jobs && (job_cnt > max_jobs))
+		job_cnt = max_jobs;
+	jobs_by_id = xcalloc(MAX(job_cnt, 1), sizeof(replay_job_t *));
+
+	return job_cnt;
+}
+
+static int _submit_job(replay_job_t *job)
+{
+	job_desc_msg_t desc;
+	submit_response_msg_t *resp = NULL;
+	char *env[] = { "SLURM_REPLAY=1", NULL };
+	uint32_t run_secs;
+	int rc;
+
+	run_secs = MAX(job->elapsed / compress, 1);
+
+	slurm_init_job_desc_msg(&desc);
+	desc.name = "sreplay";
+	xstrfmtcat(desc.script, "#!/bin/sh\nsleep %u\n", run_secs);
+	desc.environment = env;
+	desc.env_size = 1;
+	desc.user_id = getuid();
+	desc.group_id = getgid();
+	desc.work_dir = "/tmp";
+	desc.std_out = "/dev/null";
+	desc.partition = partition;
+	desc.min_nodes = job->nodes;
+	desc.max_nodes = job->nodes;
+	desc.min_cpus = job->cpus;
+	desc.num_tasks = job->cpus;
+	/* The job sleeps for its elapsed time, keep the limit above it */
+	if (job->time_limit != INFINITE)
+		desc.time_limit = MAX(job->time_limit / compress + 1,
+				      (run_secs / 60) + 1);
+
+	rc = slurm_submit_batch_job(&desc, &resp);
+	if (rc == SLURM_SUCCESS) {
+		int i = jobs_by_id_cnt++;
+
+		/*
+		 * Keep jobs_by_id sorted for bsearch(). Ids usually grow, but
+		 * wrap at MaxJobId or restart from a new FirstJobId.
+		 */
+		job->job_id = resp->job_id;
+		while ((i > 0) && (jobs_by_id[i - 1]->job_id > job->job_id)) {
+			jobs_by_id[i] = jobs_by_id[i - 1];
+			i--;
+		}
+		jobs_by_id[i] = job;
+	} else
+		fprintf(stderr, "sreplay: job submit failed: %s\n",
+			slurm_strerror(slurm_get_errno()));
+	slurm_free_submit_response_response_msg(resp);
+	xfree(desc.script);
+
+	return rc;
+}
+
+static int _find_job(const void *x, const void *y)
+{
+	const uint32_t *job_id = x;
+	const replay_job_t *job = *(replay_job_t **) y;
+
+	if (*job_id < job->job_id)
+		return -1;
+	if (*job_id > job->job_id)
+		return 1;
+	return 0;
+}
+
+/*
+ * Update the state of the replayed jobs
+ * OUT alloc_cpus - CPUs allocated to all of the running jobs
+ * OUT wait_sum - seconds waited by the jobs that just started
+ * RET count of replayed jobs pending or running, -1 on error
+ */
+static int _poll_jobs(uint32_t *alloc_cpus, double *wait_sum)
+{
+	job_info_msg_t *job_msg = NULL;
+	replay_job_t **job_pptr, *job;
+	int i, active = 0;
+
+	*alloc_cpus = 0;
+	if (slurm_load_jobs(0, &job_msg, SHOW_ALL) != SLURM_SUCCESS) {
+		slurm_perror("slurm_load_jobs");
+		return -1;
+	}
+
+	for (i = 0; i < job_msg->record_count; i++) {
+		slurm_job_info_t *job_info = &job_msg->job_array[i];
+		uint32_t state = job_info->job_state & JOB_STATE_BASE;
+
+		if ((state == JOB_RUNNING) || (state == JOB_SUSPENDED))
+			*alloc_cpus += job_info->num_cpus;
+
+		job_pptr = bsearch(&job_info->job_id, jobs_by_id,
+				   jobs_by_id_cnt, sizeof(replay_job_t *),
+				   _find_job);
+		if (!job_pptr)
+			continue;
+		job = *job_pptr;
+		if (!job->started && (state != JOB_PENDING) &&
+		    job_info->start_time) {
+			job->started = true;
+			*wait_sum += job_info->start_time -
+				     job_info->submit_time;
+		}
+		if ((state == JOB_PENDING) || (state == JOB_RUNNING) ||
+		    (state == JOB_SUSPENDED) ||
+		    (job_info->job_state & JOB_COMPLETING))
+			active++;
+	}
+	slurm_free_job_info_msg(job_msg);
+
+	return active;
+}
+
+static uint32_t _total_cpus(void)
+{
+	partition_info_msg_t *part_msg = NULL;
+	uint32_t total = 0;
+	int i;
+
+	if (slurm_load_partitions(0, &part_msg, SHOW_ALL) != SLURM_SUCCESS) {
+		slurm_perror("slurm_load_partitions");
+		return 0;
+	}
+	for (i = 0; i < part_msg->record_count; i++) {
+		partition_info_t *part = &part_msg->partition_array[i];
+
+		if (partition ? !xstrcmp(part->name, partition) :
+				(part->flags & PART_FLAG_DEFAULT)) {
+			total = part->total_cpus;
+			break;
+		}
+	}
+	slurm_free_partition_info_msg(part_msg);
+
+	return total;
+}
+
+static void _report(time_t start, int submit_cnt, int fail_cnt,
+		    double util_sum, int util_samples, double wait_sum)
+{
+	stats_info_request_msg_t req = { .command_id = STAT_COMMAND_GET };
+	stats_info_response_msg_t *stats = NULL;
+	time_t wall = MAX(time(NULL) - start, 1);
+	int started = 0, i;
+
+	for (i = 0; i < submit_cnt; i++) {
+		if (jobs[i].started)
+			started++;
+	}
+
+	printf("Jobs replayed:          %d (%d submit failures)\n",
+	       submit_cnt, fail_cnt);
+	printf("Replay time:            %ld sec, trace span %ld sec, compression %.1f\n",
+	       (long) wall, (long) (jobs[job_cnt - 1].submit - jobs[0].submit),
+	       compress);
+	printf("Mean wait time:         %.1f sec (%.1f trace sec)\n",
+	       started ? (wait_sum / started) : 0.0,
+	       started ? (wait_sum * compress / started) : 0.0);
+	printf("Utilization:            %.1f%%\n",
+	       util_samples ? (util_sum * 100.0 / util_samples) : 0.0);
+
+	if (slurm_get_statistics(&stats, &req) != SLURM_SUCCESS) {
+		slurm_perror("slurm_get_statistics");
+		return;
+	}
+	printf("Jobs started:           %u (%.2f per second)\n",
+	       stats->jobs_started, (double) stats->jobs_started / wall);
+	printf("Main schedule cycles:   %u, mean %u usec, max %u usec\n",
+	       stats->schedule_cycle_counter,
+	       stats->schedule_cycle_counter ?
+	       (stats->schedule_cycle_sum / stats->schedule_cycle_counter) : 0,
+	       stats->schedule_cycle_max);
+	printf("Backfill cycles:        %u, mean %"PRIu64" usec, max %u usec\n",
+	       stats->bf_cycle_counter,
+	       stats->bf_cycle_counter ?
+	       (stats->bf_cycle_sum / stats->bf_cycle_counter) : 0,
+	       stats->bf_cycle_max);
+	printf("Backfilled jobs:        %u\n", stats->bf_backfilled_jobs);
+	slurm_free_stats_response_msg(stats);
+}
+
+int main(int argc, char **argv)
+{
+	static struct option long_options[] = {
+		{"compress",	required_argument, 0, 'c'},
+		{"help",	no_argument,       0, 'h'},
+		{"interval",	required_argument, 0, 'i'},
+		{"jobs",	required_argument, 0, 'n'},
+		{"partition",	required_argument, 0, 'p'},
+		{NULL,		0,		   0, 0}
+	};
+	stats_info_request_msg_t reset = { .command_id = STAT_COMMAND_RESET };
+	int opt_char, option_index, submit_cnt = 0, fail_cnt = 0;
+	int active = 0, polled_cnt = 0, util_samples = 0;
+	double util_sum = 0.0, wait_sum = 0.0;
+	uint32_t alloc_cpus, total_cpus;
+	time_t start, now, last_sample = 0;
+
+	while ((opt_char = getopt_long(argc, argv, "c:hi:n:p:", long_options,
+				       &option_index)) != -1) {
+		switch (opt_char) {
+		case 'c':
+			compress = strtod(optarg, NULL);
+			break;
+		case 'i':
+			sample_interval = atoi(optarg);
+			break;
+		case 'n':
+			max_jobs = atoi(optarg);
+			break;
+		case 'p':
+			partition = optarg;
+			break;
+		case 'h':
+		default:
+			_usage();
+			exit(opt_char == 'h' ? 0 : 1);
+		}
+	}
+	if ((optind != (argc - 1)) || (compress <= 0.0) ||
+	    (sample_interval < 1) || (max_jobs < 0)) {
+		_usage();
+		exit(1);
+	}
+
+	slurm_init(NULL);
+	if (_read_trace(argv[optind]) <= 0) {
+		fprintf(stderr, "sreplay: no jobs in %s\n", argv[optind]);
+		exit(1);
+	}
+	if (!(total_cpus = _total_cpus()))
+		exit(1);
+	if (slurm_reset_statistics(&reset) != SLURM_SUCCESS)
+		slurm_perror("slurm_reset_statistics");
+
+	start = time(NULL);
+	/* Run until all jobs were submitted and seen done by a later poll */
+	while ((submit_cnt < job_cnt) || (polled_cnt < submit_cnt) ||
+	       (active > 0)) {
+		now = time(NULL);
+		while ((submit_cnt < job_cnt) &&
+		       (((jobs[submit_cnt].submit - jobs[0].submit) /
+			 compress) <= (now - start))) {
+			if (_submit_job(&jobs[submit_cnt]) != SLURM_SUCCESS)
+				fail_cnt++;
+			submit_cnt++;
+		}
+
+		if ((now - last_sample) >= sample_interval) {
+			last_sample = now;
+			polled_cnt = submit_cnt;
+			active = _poll_jobs(&alloc_cpus, &wait_sum);
+			if (active < 0)
+				break;
+			util_sum += (double) MIN(alloc_cpus, total_cpus) /
+				    total_cpus;
+			util_samples++;
+		}
+		sleep(1);
+	}
+
+	_report(start, submit_cnt, fail_cnt, util_sum, util_samples, wait_sum);
+	xfree(jobs);
+	xfree(jobs_by_id);
+	slurm_fini();
+
+	return 0;
+}
@@ -623,6 +623,8 @@ struct slurmdb_assoc_usage {
 				 * (DON'T PACK for state file) */
 	uint32_t used_submit_jobs; /* count of jobs pending or running
 				    * (DON'T PACK for state file) */
+	uint64_t usage_gen;	/* stamp of the last change to the usage
+				 * checked by the limits (DON'T PACK) */
 
 	/* Currently FAIR_TREE systems are defining data on
 	 * this struct but instead we could keep a void pointer to system
@@ -849,6 +851,8 @@ typedef struct {
 				 * (DON'T PACK for state file) */
 	List acct_limit_list; /* slurmdb_used_limits_t's (DON'T PACK
 			       * for state file) */
+	void *acct_limit_hash; /* xhash_t of acct_limit_list by account
+				* (DON'T PACK) */
 	List job_list; /* list of job pointers to submitted/running
 			  jobs (DON'T PACK) */
 	bitstr_t *grp_node_bitmap;	/* Bitmap of allocated nodes
@@ -872,8 +876,12 @@ typedef struct {
 	long double usage_raw;	/* measure of resource usage */
 
 	long double *usage_tres_raw; /* measure of each TRES usage */
+	uint64_t usage_gen;	/* stamp of the last change to the usage
+				 * checked by the limits (DON'T PACK) */
 	List user_limit_list; /* slurmdb_used_limits_t's (DON'T PACK
 			       * for state file) */
+	void *user_limit_hash; /* xhash_t of user_limit_list by uid
+				* (DON'T PACK) */
 } slurmdb_qos_usage_t;
 
 typedef struct {
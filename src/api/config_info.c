@@ -2034,6 +2034,18 @@ void slurm_print_slurmd_status (FILE* out,
 		slurmd_status_ptr->slurmd_logfile);
 	fprintf(out, "Version                  = %s\n",
 		slurmd_status_ptr->version);
+
+	if (slurmd_status_ptr->rpc_type_size)
+		fprintf(out, "RPC statistics (microseconds):\n");
+	for (int i = 0; i < slurmd_status_ptr->rpc_type_size; i++) {
+		uint32_t cnt = slurmd_status_ptr->rpc_type_cnt[i];
+		fprintf(out, "\t%-32s count:%-6u ave_time:%-6"PRIu64" max_time:%-6u total_time:%"PRIu64"\n",
+			rpc_num2string(slurmd_status_ptr->rpc_type_id[i]),
+			cnt,
+			cnt ? (slurmd_status_ptr->rpc_type_time[i] / cnt) : 0,
+			slurmd_status_ptr->rpc_type_time_max[i],
+			slurmd_status_ptr->rpc_type_time[i]);
+	}
 	return;
 }
 
@@ -77,6 +77,9 @@ static assoc_init_args_t init_setup;
 static slurmdb_assoc_rec_t **assoc_hash_id = NULL;
 static slurmdb_assoc_rec_t **assoc_hash = NULL;
 static int *assoc_mgr_tres_old_pos = NULL;
+static pthread_mutex_t usage_gen_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t usage_gen = 0;
+static uint64_t usage_gen_all = 0;
 
 static bool _running_cache(void)
 {
@@ -4123,6 +4126,8 @@ extern int assoc_mgr_update_assocs(slurmdb_update_object_t *update, bool locked)
 		slurmdb_sort_hierarchical_assoc_list(
 			assoc_mgr_assoc_list, true);
 
+	assoc_mgr_usage_gen_bump(NULL);
+
 	if (!locked)
 		assoc_mgr_unlock(&locks);
 
@@ -4816,6 +4821,8 @@ extern int assoc_mgr_update_qos(slurmdb_update_object_t *update, bool locked)
 
 	list_iterator_destroy(itr);
 
+	assoc_mgr_usage_gen_bump(NULL);
+
 	if (!locked)
 		assoc_mgr_unlock(&locks);
 
@@ -4990,6 +4997,7 @@ extern int assoc_mgr_update_res(slurmdb_update_object_t *update, bool locked)
 		slurmdb_destroy_res_rec(object);
 	}
 	list_iterator_destroy(itr);
+	assoc_mgr_usage_gen_bump(NULL);
 	if (!locked)
 		assoc_mgr_unlock(&locks);
 	return rc;
@@ -5061,6 +5069,8 @@ extern int assoc_mgr_update_tres(slurmdb_update_object_t *update, bool locked)
 	else
 		assoc_mgr_tres_list = tmp_list;
 
+	assoc_mgr_usage_gen_bump(NULL);
+
 	if (!locked)
 		assoc_mgr_unlock(&locks);
 	return rc;
@@ -5122,6 +5132,7 @@ extern void assoc_mgr_clear_used_info(void)
 		list_iterator_destroy(itr);
 	}
 
+	assoc_mgr_usage_gen_bump(NULL);
 	assoc_mgr_unlock(&locks);
 }
 
@@ -6106,6 +6117,8 @@ extern int assoc_mgr_refresh_lists(void *db_conn, uint16_t cache_level)
 	if (!partial_list && _running_cache())
 		*init_setup.running_cache = RUNNING_CACHE_STATE_LISTS_REFRESHED;
 
+	assoc_mgr_usage_gen_bump(NULL);
+
 	return SLURM_SUCCESS;
 }
 
@@ -6598,3 +6611,25 @@ extern int assoc_mgr_get_old_tres_pos(int cur_pos)
 		return -1;
 	return assoc_mgr_tres_old_pos[cur_pos];
 }
+
+extern void assoc_mgr_usage_gen_bump(uint64_t *gen)
+{
+	slurm_mutex_lock(&usage_gen_lock);
+	usage_gen++;
+	if (gen)
+		*gen = usage_gen;
+	else
+		usage_gen_all = usage_gen;
+	slurm_mutex_unlock(&usage_gen_lock);
+}
+
+extern uint64_t assoc_mgr_usage_gen_all(void)
+{
+	uint64_t gen;
+
+	slurm_mutex_lock(&usage_gen_lock);
+	gen = usage_gen_all;
+	slurm_mutex_unlock(&usage_gen_lock);
+
+	return gen;
+}
@@ -542,4 +542,16 @@ extern int assoc_mgr_get_old_tres_pos(int cur_pos);
  */
 extern int assoc_mgr_tres_pos_changed();
 
+/*
+ * Stamp a change of the usage or limits checked by the accounting policy.
+ * Every stamp is larger than all the previous ones, so the largest stamp of
+ * the records a pending job depends on changes whenever any of them does.
+ * IN usage_gen - usage_gen of the association or QOS usage that changed,
+ *		  NULL if the change affects every association and QOS.
+ */
+extern void assoc_mgr_usage_gen_bump(uint64_t *usage_gen);
+
+/* Return the stamp of the last change affecting every association and QOS */
+extern uint64_t assoc_mgr_usage_gen_all(void);
+
 #endif /* _SLURM_ASSOC_MGR_H */
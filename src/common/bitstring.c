@@ -74,8 +74,7 @@
 #define _bitstr_magic(name) 	((name)[0])
 
 /* words in a bitstring of nbits bits */
-#define	_bitstr_words(nbits)	\
-	((((nbits) + BITSTR_MAXPOS) >> BITSTR_SHIFT) + BITSTR_OVERHEAD)
+#define	_bitstr_words(nbits)	BITSTR_WORDS(nbits)
 
 /* check signature */
 #define _assert_bitstr_valid(name) do { \
@@ -111,6 +110,8 @@ strong_alias(bit_clear_all,	slurm_bit_clear_all);
 strong_alias(bit_ffc,		slurm_bit_ffc);
 strong_alias(bit_ffs,		slurm_bit_ffs);
 strong_alias(bit_free,		slurm_bit_free);
+strong_alias(bit_init,	slurm_bit_init);
+strong_alias(bit_alloc_count,	slurm_bit_alloc_count);
 strong_alias(bit_realloc,	slurm_bit_realloc);
 strong_alias(bit_size,		slurm_bit_size);
 strong_alias(bit_and,		slurm_bit_and);
@@ -146,6 +147,580 @@ strong_alias(bit_nffs,		slurm_bit_nffs);
 strong_alias(bit_copybits,	slurm_bit_copybits);
 strong_alias(bit_get_bit_num,	slurm_bit_get_bit_num);
 strong_alias(bit_get_pos_num,	slurm_bit_get_pos_num);
+strong_alias(bit_kernels_name,	slurm_bit_kernels_name);
+strong_alias(bit_kernels_select, slurm_bit_kernels_select);
+
+#ifdef HAVE___BUILTIN_POPCOUNTLL
+#define hweight __builtin_popcountll
+#else
+/*
+ * Returns the hamming weight (i.e. the number of bits set) in a word.
+ * NOTE: This routine borrowed from Linux 4.9 <tools/lib/hweight.c>.
+ */
+static uint64_t
+hweight(uint64_t w)
+{
+        w -= (w >> 1) & 0x5555555555555555ul;
+        w =  (w & 0x3333333333333333ul) + ((w >> 2) & 0x3333333333333333ul);
+        w =  (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0ful;
+        return (w * 0x0101010101010101ul) >> 56;
+}
+#endif
+
+/*
+ * Word kernels for the bulk operations (and, or, counts, overlaps, first set
+ * word). They work on the words of the bitstrings past BITSTR_OVERHEAD. The
+ * set used is picked from the CPU features the first time it is needed.
+ * Bitstrings shorter than BITSTR_KERNEL_MIN_WORDS words use the plain loops
+ * as the indirect call is not worth it for them.
+ */
+#define BITSTR_KERNEL_MIN_WORDS	8
+
+#if defined(__x86_64__) && defined(__GNUC__) && \
+    ((__GNUC__ >= 8) || defined(__clang__))
+#define BITSTR_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+typedef struct {
+	char *name;
+	void (*and_words)(bitstr_t *dst, const bitstr_t *src, int32_t cnt);
+	void (*and_not_words)(bitstr_t *dst, const bitstr_t *src, int32_t cnt);
+	void (*or_words)(bitstr_t *dst, const bitstr_t *src, int32_t cnt);
+	int32_t (*count)(const bitstr_t *src, int32_t cnt);
+	int32_t (*and_count)(const bitstr_t *b1, const bitstr_t *b2,
+			     int32_t cnt);
+	bool (*and_any)(const bitstr_t *b1, const bitstr_t *b2, int32_t cnt);
+	bool (*and_not_any)(const bitstr_t *b1, const bitstr_t *b2,
+			    int32_t cnt);
+	int32_t (*first_set_word)(const bitstr_t *src, int32_t cnt);
+} bit_kernels_t;
+
+static void _and_words(bitstr_t *dst, const bitstr_t *src, int32_t cnt)
+{
+	for (int32_t i = 0; i < cnt; i++)
+		dst[i] &= src[i];
+}
+
+static void _and_not_words(bitstr_t *dst, const bitstr_t *src, int32_t cnt)
+{
+	for (int32_t i = 0; i < cnt; i++)
+		dst[i] &= ~src[i];
+}
+
+static void _or_words(bitstr_t *dst, const bitstr_t *src, int32_t cnt)
+{
+	for (int32_t i = 0; i < cnt; i++)
+		dst[i] |= src[i];
+}
+
+static int32_t _count_words(const bitstr_t *src, int32_t cnt)
+{
+	int32_t count = 0;
+
+	for (int32_t i = 0; i < cnt; i++)
+		count += hweight(src[i]);
+	return count;
+}
+
+static int32_t _and_count_words(const bitstr_t *b1, const bitstr_t *b2,
+				int32_t cnt)
+{
+	int32_t count = 0;
+
+	for (int32_t i = 0; i < cnt; i++)
+		count += hweight(b1[i] & b2[i]);
+	return count;
+}
+
+static bool _and_any_words(const bitstr_t *b1, const bitstr_t *b2,
+			   int32_t cnt)
+{
+	for (int32_t i = 0; i < cnt; i++) {
+		if (b1[i] & b2[i])
+			return true;
+	}
+	return false;
+}
+
+static bool _and_not_any_words(const bitstr_t *b1, const bitstr_t *b2,
+			       int32_t cnt)
+{
+	for (int32_t i = 0; i < cnt; i++) {
+		if (b1[i] & ~b2[i])
+			return true;
+	}
+	return false;
+}
+
+static int32_t _first_set_word(const bitstr_t *src, int32_t cnt)
+{
+	int32_t i;
+
+	for (i = 0; i < cnt; i++) {
+		if (src[i])
+			break;
+	}
+	return i;
+}
+
+static const bit_kernels_t kernels_generic = {
+	.name = "generic",
+	.and_words = _and_words,
+	.and_not_words = _and_not_words,
+	.or_words = _or_words,
+	.count = _count_words,
+	.and_count = _and_count_words,
+	.and_any = _and_any_words,
+	.and_not_any = _and_not_any_words,
+	.first_set_word = _first_set_word,
+};
+
+#ifdef BITSTR_X86_KERNELS
+/*
+ * Without -mpopcnt __builtin_popcountll() is a libgcc call, so the counting
+ * loops are built again for CPUs with the POPCNT instruction.
+ */
+__attribute__((target("popcnt")))
+static int32_t _count_words_popcnt(const bitstr_t *src, int32_t cnt)
+{
+	int32_t count = 0;
+
+	for (int32_t i = 0; i < cnt; i++)
+		count += __builtin_popcountll(src[i]);
+	return count;
+}
+
+__attribute__((target("popcnt")))
+static int32_t _and_count_words_popcnt(const bitstr_t *b1, const bitstr_t *b2,
+				       int32_t cnt)
+{
+	int32_t count = 0;
+
+	for (int32_t i = 0; i < cnt; i++)
+		count += __builtin_popcountll(b1[i] & b2[i]);
+	return count;
+}
+
+static const bit_kernels_t kernels_popcnt = {
+	.name = "popcnt",
+	.and_words = _and_words,
+	.and_not_words = _and_not_words,
+	.or_words = _or_words,
+	.count = _count_words_popcnt,
+	.and_count = _and_count_words_popcnt,
+	.and_any = _and_any_words,
+	.and_not_any = _and_not_any_words,
+	.first_set_word = _first_set_word,
+};
+
+/* 4 words per vector, unaligned loads as bitstrings are xmalloc()ed */
+#define AVX2_WORDS 4
+
+__attribute__((target("avx2")))
+static void _and_words_avx2(bitstr_t *dst, const bitstr_t *src, int32_t cnt)
+{
+	int32_t i;
+
+	for (i = 0; (i + AVX2_WORDS) <= cnt; i += AVX2_WORDS) {
+		__m256i a = _mm256_loadu_si256((__m256i *) (dst + i));
+		__m256i b = _mm256_loadu_si256((__m256i *) (src + i));
+		_mm256_storeu_si256((__m256i *) (dst + i),
+				    _mm256_and_si256(a, b));
+	}
+	for ( ; i < cnt; i++)
+		dst[i] &= src[i];
+}
+
+__attribute__((target("avx2")))
+static void _and_not_words_avx2(bitstr_t *dst, const bitstr_t *src,
+				int32_t cnt)
+{
+	int32_t i;
+
+	for (i = 0; (i + AVX2_WORDS) <= cnt; i += AVX2_WORDS) {
+		__m256i a = _mm256_loadu_si256((__m256i *) (dst + i));
+		__m256i b = _mm256_loadu_si256((__m256i *) (src + i));
+		_mm256_storeu_si256((__m256i *) (dst + i),
+				    _mm256_andnot_si256(b, a));
+	}
+	for ( ; i < cnt; i++)
+		dst[i] &= ~src[i];
+}
+
+__attribute__((target("avx2")))
+static void _or_words_avx2(bitstr_t *dst, const bitstr_t *src, int32_t cnt)
+{
+	int32_t i;
+
+	for (i = 0; (i + AVX2_WORDS) <= cnt; i += AVX2_WORDS) {
+		__m256i a = _mm256_loadu_si256((__m256i *) (dst + i));
+		__m256i b = _mm256_loadu_si256((__m256i *) (src + i));
+		_mm256_storeu_si256((__m256i *) (dst + i),
+				    _mm256_or_si256(a, b));
+	}
+	for ( ; i < cnt; i++)
+		dst[i] |= src[i];
+}
+
+/*
+ * Per 64-bit lane population count, looking up each nibble in a 16 entry
+ * table (W. Mula, "Faster population counts using AVX2 instructions").
+ */
+__attribute__((target("avx2")))
+static inline __m256i _popcnt_avx2(__m256i v)
+{
+	const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+					     1, 2, 2, 3, 2, 3, 3, 4,
+					     0, 1, 1, 2, 1, 2, 2, 3,
+					     1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low_mask = _mm256_set1_epi8(0x0f);
+	__m256i lo = _mm256_and_si256(v, low_mask);
+	__m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+	__m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lut, lo),
+				      _mm256_shuffle_epi8(lut, hi));
+
+	return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2")))
+static inline int32_t _sum_avx2(__m256i acc)
+{
+	return _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) +
+	       _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3);
+}
+
+__attribute__((target("avx2,popcnt")))
+static int32_t _count_words_avx2(const bitstr_t *src, int32_t cnt)
+{
+	__m256i acc = _mm256_setzero_si256();
+	int32_t i, count;
+
+	for (i = 0; (i + AVX2_WORDS) <= cnt; i += AVX2_WORDS) {
+		__m256i a = _mm256_loadu_si256((__m256i *) (src + i));
+		acc = _mm256_add_epi64(acc, _popcnt_avx2(a));
+	}
+	count = _sum_avx2(acc);
+	for ( ; i < cnt; i++)
+		count += __builtin_popcountll(src[i]);
+	return count;
+}
+
+__attribute__((target("avx2,popcnt")))
+static int32_t _and_count_words_avx2(const bitstr_t *b1, const bitstr_t *b2,
+				     int32_t cnt)
+{
+	__m256i acc = _mm256_setzero_si256();
+	int32_t i, count;
+
+	for (i = 0; (i + AVX2_WORDS) <= cnt; i += AVX2_WORDS) {
+		__m256i a = _mm256_loadu_si256((__m256i *) (b1 + i));
+		__m256i b = _mm256_loadu_si256((__m256i *) (b2 + i));
+		acc = _mm256_add_epi64(acc,
+				       _popcnt_avx2(_mm256_and_si256(a, b)));
+	}
+	count = _sum_avx2(acc);
+	for ( ; i < cnt; i++)
+		count += __builtin_popcountll(b1[i] & b2[i]);
+	return count;
+}
+
+__attribute__((target("avx2")))
+static bool _and_any_words_avx2(const bitstr_t *b1, const bitstr_t *b2,
+				int32_t cnt)
+{
+	int32_t i;
+
+	for (i = 0; (i + AVX2_WORDS) <= cnt; i += AVX2_WORDS) {
+		__m256i a = _mm256_loadu_si256((__m256i *) (b1 + i));
+		__m256i b = _mm256_loadu_si256((__m256i *) (b2 + i));
+		if (!_mm256_testz_si256(a, b))
+			return true;
+	}
+	for ( ; i < cnt; i++) {
+		if (b1[i] & b2[i])
+			return true;
+	}
+	return false;
+}
+
+__attribute__((target("avx2")))
+static bool _and_not_any_words_avx2(const bitstr_t *b1, const bitstr_t *b2,
+				    int32_t cnt)
+{
+	int32_t i;
+
+	for (i = 0; (i + AVX2_WORDS) <= cnt; i += AVX2_WORDS) {
+		__m256i a = _mm256_loadu_si256((__m256i *) (b1 + i));
+		__m256i b = _mm256_loadu_si256((__m256i *) (b2 + i));
+		/* testc is set when (~b & a) == 0 */
+		if (!_mm256_testc_si256(b, a))
+			return true;
+	}
+	for ( ; i < cnt; i++) {
+		if (b1[i] & ~b2[i])
+			return true;
+	}
+	return false;
+}
+
+__attribute__((target("avx2")))
+static int32_t _first_set_word_avx2(const bitstr_t *src, int32_t cnt)
+{
+	int32_t i;
+
+	for (i = 0; (i + AVX2_WORDS) <= cnt; i += AVX2_WORDS) {
+		__m256i a = _mm256_loadu_si256((__m256i *) (src + i));
+		if (!_mm256_testz_si256(a, a))
+			break;
+	}
+	for ( ; i < cnt; i++) {
+		if (src[i])
+			break;
+	}
+	return i;
+}
+
+static const bit_kernels_t kernels_avx2 = {
+	.name = "avx2",
+	.and_words = _and_words_avx2,
+	.and_not_words = _and_not_words_avx2,
+	.or_words = _or_words_avx2,
+	.count = _count_words_avx2,
+	.and_count = _and_count_words_avx2,
+	.and_any = _and_any_words_avx2,
+	.and_not_any = _and_not_any_words_avx2,
+	.first_set_word = _first_set_word_avx2,
+};
+
+#define AVX512_WORDS 8
+#define AVX512_TARGET "avx512f,avx512vpopcntdq,popcnt"
+
+__attribute__((target(AVX512_TARGET)))
+static void _and_words_avx512(bitstr_t *dst, const bitstr_t *src, int32_t cnt)
+{
+	int32_t i;
+
+	for (i = 0; (i + AVX512_WORDS) <= cnt; i += AVX512_WORDS) {
+		__m512i a = _mm512_loadu_si512(dst + i);
+		__m512i b = _mm512_loadu_si512(src + i);
+		_mm512_storeu_si512(dst + i, _mm512_and_si512(a, b));
+	}
+	for ( ; i < cnt; i++)
+		dst[i] &= src[i];
+}
+
+__attribute__((target(AVX512_TARGET)))
+static void _and_not_words_avx512(bitstr_t *dst, const bitstr_t *src,
+				  int32_t cnt)
+{
+	int32_t i;
+
+	for (i = 0; (i + AVX512_WORDS) <= cnt; i += AVX512_WORDS) {
+		__m512i a = _mm512_loadu_si512(dst + i);
+		__m512i b = _mm512_loadu_si512(src + i);
+		_mm512_storeu_si512(dst + i, _mm512_andnot_si512(b, a));
+	}
+	for ( ; i < cnt; i++)
+		dst[i] &= ~src[i];
+}
+
+__attribute__((target(AVX512_TARGET)))
+static void _or_words_avx512(bitstr_t *dst, const bitstr_t *src, int32_t cnt)
+{
+	int32_t i;
+
+	for (i = 0; (i + AVX512_WORDS) <= cnt; i += AVX512_WORDS) {
+		__m512i a = _mm512_loadu_si512(dst + i);
+		__m512i b = _mm512_loadu_si512(src + i);
+		_mm512_storeu_si512(dst + i, _mm512_or_si512(a, b));
+	}
+	for ( ; i < cnt; i++)
+		dst[i] |= src[i];
+}
+
+__attribute__((target(AVX512_TARGET)))
+static int32_t _count_words_avx512(const bitstr_t *src, int32_t cnt)
+{
+	__m512i acc = _mm512_setzero_si512();
+	int32_t i, count;
+
+	for (i = 0; (i + AVX512_WORDS) <= cnt; i += AVX512_WORDS) {
+		__m512i a = _mm512_loadu_si512(src + i);
+		acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(a));
+	}
+	count = _mm512_reduce_add_epi64(acc);
+	for ( ; i < cnt; i++)
+		count += __builtin_popcountll(src[i]);
+	return count;
+}
+
+__attribute__((target(AVX512_TARGET)))
+static int32_t _and_count_words_avx512(const bitstr_t *b1, const bitstr_t *b2,
+				       int32_t cnt)
+{
+	__m512i acc = _mm512_setzero_si512();
+	int32_t i, count;
+
+	for (i = 0; (i + AVX512_WORDS) <= cnt; i += AVX512_WORDS) {
+		__m512i a = _mm512_loadu_si512(b1 + i);
+		__m512i b = _mm512_loadu_si512(b2 + i);
+		acc = _mm512_add_epi64(acc,
+				       _mm512_popcnt_epi64(
+					       _mm512_and_si512(a, b)));
+	}
+	count = _mm512_reduce_add_epi64(acc);
+	for ( ; i < cnt; i++)
+		count += __builtin_popcountll(b1[i] & b2[i]);
+	return count;
+}
+
+__attribute__((target(AVX512_TARGET)))
+static bool _and_any_words_avx512(const bitstr_t *b1, const bitstr_t *b2,
+				  int32_t cnt)
+{
+	int32_t i;
+
+	for (i = 0; (i + AVX512_WORDS) <= cnt; i += AVX512_WORDS) {
+		__m512i a = _mm512_loadu_si512(b1 + i);
+		__m512i b = _mm512_loadu_si512(b2 + i);
+		if (_mm512_test_epi64_mask(a, b))
+			return true;
+	}
+	for ( ; i < cnt; i++) {
+		if (b1[i] & b2[i])
+			return true;
+	}
+	return false;
+}
+
+__attribute__((target(AVX512_TARGET)))
+static bool _and_not_any_words_avx512(const bitstr_t *b1, const bitstr_t *b2,
+				      int32_t cnt)
+{
+	int32_t i;
+
+	for (i = 0; (i + AVX512_WORDS) <= cnt; i += AVX512_WORDS) {
+		__m512i a = _mm512_loadu_si512(b1 + i);
+		__m512i b = _mm512_loadu_si512(b2 + i);
+		__m512i a_not_b = _mm512_andnot_si512(b, a);
+		if (_mm512_test_epi64_mask(a_not_b, a_not_b))
+			return true;
+	}
+	for ( ; i < cnt; i++) {
+		if (b1[i] & ~b2[i])
+			return true;
+	}
+	return false;
+}
+
+__attribute__((target(AVX512_TARGET)))
+static int32_t _first_set_word_avx512(const bitstr_t *src, int32_t cnt)
+{
+	int32_t i;
+
+	for (i = 0; (i + AVX512_WORDS) <= cnt; i += AVX512_WORDS) {
+		__m512i a = _mm512_loadu_si512(src + i);
+		__mmask8 set = _mm512_test_epi64_mask(a, a);
+		if (set)
+			return i + __builtin_ctz(set);
+	}
+	for ( ; i < cnt; i++) {
+		if (src[i])
+			break;
+	}
+	return i;
+}
+
+static const bit_kernels_t kernels_avx512 = {
+	.name = "avx512",
+	.and_words = _and_words_avx512,
+	.and_not_words = _and_not_words_avx512,
+	.or_words = _or_words_avx512,
+	.count = _count_words_avx512,
+	.and_count = _and_count_words_avx512,
+	.and_any = _and_any_words_avx512,
+	.and_not_any = _and_not_any_words_avx512,
+	.first_set_word = _first_set_word_avx512,
+};
+#endif
+
+static const bit_kernels_t *kernels = NULL;
+
+static const bit_kernels_t *_detect_kernels(void)
+{
+#ifdef BITSTR_X86_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f") &&
+	    __builtin_cpu_supports("avx512vpopcntdq"))
+		return &kernels_avx512;
+	if (__builtin_cpu_supports("avx2") &&
+	    __builtin_cpu_supports("popcnt"))
+		return &kernels_avx2;
+	if (__builtin_cpu_supports("popcnt"))
+		return &kernels_popcnt;
+#endif
+	return &kernels_generic;
+}
+
+/*
+ * Every thread picks the same set, so a race on the first call only stores
+ * the same pointer twice.
+ */
+static inline const bit_kernels_t *_kernels(void)
+{
+	if (!kernels)
+		kernels = _detect_kernels();
+	return kernels;
+}
+
+/*
+ * Return the name of the word kernels in use ("avx512", "avx2", "popcnt" or
+ * "generic").
+ */
+extern const char *bit_kernels_name(void)
+{
+	return _kernels()->name;
+}
+
+/*
+ * Use the named word kernels, for testing and benchmarking. A NULL name
+ * restores the best set for this CPU.
+ * RET SLURM_SUCCESS or SLURM_ERROR if the CPU does not support the set
+ */
+extern int bit_kernels_select(const char *name)
+{
+	const bit_kernels_t *best = _detect_kernels();
+	const bit_kernels_t *all[] = {
+#ifdef BITSTR_X86_KERNELS
+		&kernels_avx512, &kernels_avx2, &kernels_popcnt,
+#endif
+		&kernels_generic, NULL
+	};
+	bool supported = false;
+
+	if (!name) {
+		kernels = best;
+		return SLURM_SUCCESS;
+	}
+
+	/* The sets are listed from the best one down */
+	for (int i = 0; all[i]; i++) {
+		if (all[i] == best)
+			supported = true;
+		if (supported && !xstrcmp(all[i]->name, name)) {
+			kernels = all[i];
+			return SLURM_SUCCESS;
+		}
+	}
+	return SLURM_ERROR;
+}
+
+/* Number of words holding the bits of b, the last one may be partial */
+#define _bitstr_data_words(b) (_bitstr_words(_bitstr_bits(b)) - BITSTR_OVERHEAD)
+
+/* Bitstrings allocated or resized by this thread, see bit_alloc_count() */
+static __thread uint64_t alloc_count = 0;
 
 /*
  * Allocate a bitstring.
@@ -158,12 +733,41 @@ bitstr_t *bit_alloc(bitoff_t nbits)
 
 	_assert_valid_size(nbits);
 	new = xmalloc(_bitstr_words(nbits) * sizeof(bitstr_t));
+	alloc_count++;
 
 	_bitstr_magic(new) = BITSTR_MAGIC;
 	_bitstr_bits(new) = nbits;
 	return new;
 }
 
+/*
+ * Initialize a bitstring in caller provided storage, typically an automatic
+ * array of BITSTR_WORDS(nbits) words. The result must not be passed to
+ * bit_free() or bit_realloc().
+ *   words (IN)		storage for the bitstring
+ *   nbits (IN)		valid bits in new bitstring, initialized to all clear
+ *   RETURN		words, as a bitstring
+ */
+bitstr_t *bit_init(bitstr_t *words, bitoff_t nbits)
+{
+	_assert_valid_size(nbits);
+	memset(words, 0, _bitstr_words(nbits) * sizeof(bitstr_t));
+
+	_bitstr_magic(words) = BITSTR_MAGIC;
+	_bitstr_bits(words) = nbits;
+	return words;
+}
+
+/*
+ * Return the number of bitstrings allocated or reallocated by the calling
+ * thread, bit_copy() included. Compare two readings to count the
+ * allocations made by a code path.
+ */
+uint64_t bit_alloc_count(void)
+{
+	return alloc_count;
+}
+
 /*
  * Reallocate a bitstring (expand or contract size).
  *   b (IN)		pointer to old bitstring
@@ -177,6 +781,7 @@ bitstr_t *bit_realloc(bitstr_t *b, bitoff_t nbits)
 	_assert_bitstr_valid(b);
 	_assert_valid_size(nbits);
 	new = xrealloc(b, _bitstr_words(nbits) * sizeof(bitstr_t));
+	alloc_count++;
 
 	_assert_bitstr_valid(new);
 	_bitstr_bits(new) = nbits;
@@ -467,6 +1072,13 @@ bit_ffs(bitstr_t *b)
 
 	_assert_bitstr_valid(b);
 
+	if (_bitstr_data_words(b) >= BITSTR_KERNEL_MIN_WORDS) {
+		/* Skip the leading clear words */
+		bit = _kernels()->first_set_word(b + BITSTR_OVERHEAD,
+						 _bitstr_data_words(b));
+		bit *= sizeof(bitstr_t) * 8;
+	}
+
 	while (bit < _bitstr_bits(b) && value == -1) {
 		int32_t word = _bit_word(bit);
 
@@ -576,6 +1188,12 @@ bit_super_set(bitstr_t *b1, bitstr_t *b2)
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
+	if (_bitstr_data_words(b1) >= BITSTR_KERNEL_MIN_WORDS) {
+		return !_kernels()->and_not_any(b1 + BITSTR_OVERHEAD,
+						b2 + BITSTR_OVERHEAD,
+						_bitstr_data_words(b1));
+	}
+
 	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8) {
 		if (b1[_bit_word(bit)] != (b1[_bit_word(bit)] &
 		                           b2[_bit_word(bit)]))
@@ -618,11 +1236,18 @@ void
 bit_and(bitstr_t *b1, bitstr_t *b2)
 {
 	bitoff_t bit, bit_cnt;
+	int32_t word_cnt;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 
 	bit_cnt = MIN(_bitstr_bits(b1), _bitstr_bits(b2));
+	word_cnt = _bitstr_words(bit_cnt) - BITSTR_OVERHEAD;
+	if (word_cnt >= BITSTR_KERNEL_MIN_WORDS) {
+		_kernels()->and_words(b1 + BITSTR_OVERHEAD, b2 + BITSTR_OVERHEAD,
+				word_cnt);
+		return;
+	}
 	for (bit = 0; bit < bit_cnt; bit += sizeof(bitstr_t)*8)
 		b1[_bit_word(bit)] &= b2[_bit_word(bit)];
 }
@@ -635,11 +1260,18 @@ bit_and(bitstr_t *b1, bitstr_t *b2)
 void bit_and_not(bitstr_t *b1, bitstr_t *b2)
 {
 	bitoff_t bit, bit_cnt;
+	int32_t word_cnt;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 
 	bit_cnt = MIN(_bitstr_bits(b1), _bitstr_bits(b2));
+	word_cnt = _bitstr_words(bit_cnt) - BITSTR_OVERHEAD;
+	if (word_cnt >= BITSTR_KERNEL_MIN_WORDS) {
+		_kernels()->and_not_words(b1 + BITSTR_OVERHEAD,
+					  b2 + BITSTR_OVERHEAD, word_cnt);
+		return;
+	}
 	for (bit = 0; bit < bit_cnt; bit += sizeof(bitstr_t)*8)
 		b1[_bit_word(bit)] &= ~b2[_bit_word(bit)];
 }
@@ -668,11 +1300,18 @@ void
 bit_or(bitstr_t *b1, bitstr_t *b2)
 {
 	bitoff_t bit, bit_cnt;
+	int32_t word_cnt;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 
 	bit_cnt = MIN(_bitstr_bits(b1), _bitstr_bits(b2));
+	word_cnt = _bitstr_words(bit_cnt) - BITSTR_OVERHEAD;
+	if (word_cnt >= BITSTR_KERNEL_MIN_WORDS) {
+		_kernels()->or_words(b1 + BITSTR_OVERHEAD, b2 + BITSTR_OVERHEAD,
+				word_cnt);
+		return;
+	}
 	for (bit = 0; bit < bit_cnt; bit += sizeof(bitstr_t)*8)
 		b1[_bit_word(bit)] |= b2[_bit_word(bit)];
 }
@@ -728,23 +1367,6 @@ bit_copybits(bitstr_t *dest, bitstr_t *src)
 	memcpy(&dest[BITSTR_OVERHEAD], &src[BITSTR_OVERHEAD], len);
 }
 
-#ifdef HAVE___BUILTIN_POPCOUNTLL
-#define hweight __builtin_popcountll
-#else
-/*
- * Returns the hamming weight (i.e. the number of bits set) in a word.
- * NOTE: This routine borrowed from Linux 4.9 <tools/lib/hweight.c>.
- */
-static uint64_t
-hweight(uint64_t w)
-{
-        w -= (w >> 1) & 0x5555555555555555ul;
-        w =  (w & 0x3333333333333333ul) + ((w >> 2) & 0x3333333333333333ul);
-        w =  (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0ful;
-        return (w * 0x0101010101010101ul) >> 56;
-}
-#endif
-
 /*
  * Count the number of bits set in bitstring.
  *   b (IN)		bitstring to check
@@ -760,8 +1382,13 @@ bit_set_count(bitstr_t *b)
 	_assert_bitstr_valid(b);
 
 	bit_cnt = _bitstr_bits(b);
-	for (bit = 0; (bit + word_size) <= bit_cnt; bit += word_size) {
-		count += hweight(b[_bit_word(bit)]);
+	bit = (bit_cnt / word_size) * word_size;
+	if ((bit / word_size) >= BITSTR_KERNEL_MIN_WORDS) {
+		count = _kernels()->count(b + BITSTR_OVERHEAD,
+					  bit / word_size);
+	} else {
+		for (bit = 0; (bit + word_size) <= bit_cnt; bit += word_size)
+			count += hweight(b[_bit_word(bit)]);
 	}
 	for ( ; bit < bit_cnt; bit++) {
 		if (bit_test(b, bit))
@@ -793,6 +1420,11 @@ bit_set_count_range(bitstr_t *b, int32_t start, int32_t end)
 		if (bit_test(b, bit))
 			count++;
 	}
+	if (((end - bit) / word_size) >= BITSTR_KERNEL_MIN_WORDS) {
+		int32_t word_cnt = (end - bit) / word_size;
+		count += _kernels()->count(b + _bit_word(bit), word_cnt);
+		bit += word_cnt * word_size;
+	}
 	for (; (bit + word_size) <= end ; bit += word_size) {
 		count += hweight(b[_bit_word(bit)]);
 	}
@@ -816,7 +1448,21 @@ static int32_t _bit_overlap_internal(bitstr_t *b1, bitstr_t *b2, bool count_it)
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
 	bit_cnt = _bitstr_bits(b1);
-	for (bit = 0; bit < bit_cnt; bit += word_size) {
+	bit = 0;
+	if ((bit_cnt / word_size) >= BITSTR_KERNEL_MIN_WORDS) {
+		int32_t word_cnt = bit_cnt / word_size;
+		if (count_it) {
+			count = _kernels()->and_count(b1 + BITSTR_OVERHEAD,
+						      b2 + BITSTR_OVERHEAD,
+						      word_cnt);
+		} else if (_kernels()->and_any(b1 + BITSTR_OVERHEAD,
+					       b2 + BITSTR_OVERHEAD,
+					       word_cnt)) {
+			return 1;
+		}
+		bit = word_cnt * word_size;
+	}
+	for ( ; bit < bit_cnt; bit += word_size) {
 		if ((bit + word_size - 1) >= bit_cnt)
 			break;
 		anded = b1[_bit_word(bit)] & b2[_bit_word(bit)];
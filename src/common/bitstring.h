@@ -90,6 +90,10 @@ typedef bitstr_t bitoff_t;
 /* max bit position in word */
 #define BITSTR_MAXPOS		(sizeof(bitstr_t)*8 - 1)
 
+/* words needed to hold a bitstring of nbits, see bit_init() */
+#define BITSTR_WORDS(nbits)	\
+	((((nbits) + BITSTR_MAXPOS) >> BITSTR_SHIFT) + BITSTR_OVERHEAD)
+
 /* compat with Vixie macros */
 bitstr_t *bit_alloc(bitoff_t nbits);
 int bit_test(bitstr_t *b, bitoff_t bit);
@@ -110,6 +114,8 @@ bitoff_t bit_nffc(bitstr_t *b, int32_t n);
 bitoff_t bit_noc(bitstr_t *b, int32_t n, int32_t seed);
 void	bit_free(bitstr_t *b);
 bitstr_t *bit_realloc(bitstr_t *b, bitoff_t nbits);
+bitstr_t *bit_init(bitstr_t *words, bitoff_t nbits);
+uint64_t bit_alloc_count(void);
 bitoff_t bit_size(bitstr_t *b);
 void	bit_and(bitstr_t *b1, bitstr_t *b2);
 void	bit_and_not(bitstr_t *b1, bitstr_t *b2);
@@ -148,6 +154,10 @@ bitstr_t *bit_pick_cnt(bitstr_t *b, bitoff_t nbits);
 bitoff_t bit_get_bit_num(bitstr_t *b, int32_t pos);
 int32_t	bit_get_pos_num(bitstr_t *b, bitoff_t pos);
 
+/* Word kernels (SIMD or scalar) used by the bulk operations */
+const char *bit_kernels_name(void);
+int	bit_kernels_select(const char *name);
+
 #define FREE_NULL_BITMAP(_X)	\
 do {				\
 	if (_X)			\
@@ -128,6 +128,13 @@ typedef struct {
 	uint64_t ssec;
 	uint64_t total_rss;
 	uint64_t total_pgmajfault;
+	/* Only available with cgroup/v2, NO_VAL64 otherwise */
+	uint64_t cpu_pressure_usec;	/* cpu.pressure "some" total */
+	uint64_t mem_pressure_usec;	/* memory.pressure "some" total */
+	uint64_t io_pressure_usec;	/* io.pressure "some" total */
+	uint64_t mem_high_events;	/* memory.events "high" */
+	uint64_t mem_max_events;	/* memory.events "max" */
+	uint64_t oom_kill_cnt;		/* memory.events "oom_kill" */
 } cgroup_acct_t;
 
 /* Slurm cgroup plugins configuration parameters */
@@ -378,6 +378,17 @@ extern int write_one_config(void *x, void *arg)
 extern int write_configs_to_conf_cache(config_response_msg_t *msg,
 				       char *dir)
 {
+	char *snapshot = NULL;
+
+	/*
+	 * The slurm.conf snapshot (SlurmdParameters=conf_snapshot) describes
+	 * the files being replaced. slurmd writes a new one once it has
+	 * parsed them.
+	 */
+	xstrfmtcat(snapshot, "%s/slurm.conf.snapshot", dir);
+	(void) unlink(snapshot);
+	xfree(snapshot);
+
 	if (list_for_each(msg->config_files, write_one_config, dir) < 0) {
 		return SLURM_ERROR;
 	}
@@ -2449,10 +2449,84 @@ static void _gres_state_delete_members(void *x)
 	xfree(gres_ptr);
 }
 
+/*
+ * Return a bitmap of the sockets on which core_bitmap has at least one core
+ * set, or NULL if it has cores set on every socket.
+ */
+static bitstr_t *_topo_core2sock(bitstr_t *core_bitmap, uint16_t sockets,
+				 uint16_t cores_per_sock)
+{
+	bitstr_t *sock_bitmap = bit_alloc(sockets);
+	int s, first_core;
+
+	for (s = 0; s < sockets; s++) {
+		first_core = s * cores_per_sock;
+		if (bit_set_count_range(core_bitmap, first_core,
+					first_core + cores_per_sock))
+			bit_set(sock_bitmap, s);
+	}
+	if (bit_set_count(sock_bitmap) == sockets)
+		FREE_NULL_BITMAP(sock_bitmap);
+
+	return sock_bitmap;
+}
+
+static void _gres_node_state_clear_topo_sock(gres_node_state_t *gres_node_ptr)
+{
+	int i;
+
+	if (!gres_node_ptr->topo_sock_bitmap)
+		return;
+
+	for (i = 0; i < gres_node_ptr->topo_sock_recs; i++)
+		FREE_NULL_BITMAP(gres_node_ptr->topo_sock_bitmap[i]);
+	xfree(gres_node_ptr->topo_sock_bitmap);
+	gres_node_ptr->topo_sock_cnt = 0;
+	gres_node_ptr->topo_sock_cores = 0;
+	gres_node_ptr->topo_sock_recs = 0;
+}
+
+/*
+ * Build the socket table of every topo record so that selecting GRES by
+ * socket does not need to scan the core bitmaps of the node.
+ */
+static void _gres_node_state_build_topo_sock(gres_node_state_t *gres_node_ptr,
+					     uint16_t sockets,
+					     uint16_t cores_per_sock)
+{
+	int i, core_cnt = sockets * cores_per_sock;
+
+	_gres_node_state_clear_topo_sock(gres_node_ptr);
+	if (!gres_node_ptr->topo_cnt || !gres_node_ptr->topo_core_bitmap ||
+	    !sockets || !cores_per_sock)
+		return;
+
+	for (i = 0; i < gres_node_ptr->topo_cnt; i++) {
+		if (gres_node_ptr->topo_core_bitmap[i] &&
+		    (bit_size(gres_node_ptr->topo_core_bitmap[i]) != core_cnt))
+			return;	/* Rebuilt by gres_validate_node_cores() */
+	}
+
+	gres_node_ptr->topo_sock_bitmap = xcalloc(gres_node_ptr->topo_cnt,
+						  sizeof(bitstr_t *));
+	for (i = 0; i < gres_node_ptr->topo_cnt; i++) {
+		if (!gres_node_ptr->topo_core_bitmap[i])
+			continue;
+		gres_node_ptr->topo_sock_bitmap[i] = _topo_core2sock(
+			gres_node_ptr->topo_core_bitmap[i], sockets,
+			cores_per_sock);
+	}
+	gres_node_ptr->topo_sock_cnt = sockets;
+	gres_node_ptr->topo_sock_cores = cores_per_sock;
+	gres_node_ptr->topo_sock_recs = gres_node_ptr->topo_cnt;
+}
+
 static void _gres_node_state_delete_topo(gres_node_state_t *gres_node_ptr)
 {
 	int i;
 
+	_gres_node_state_clear_topo_sock(gres_node_ptr);
+
 	for (i = 0; i < gres_node_ptr->topo_cnt; i++) {
 		if (gres_node_ptr->topo_gres_bitmap)
 			FREE_NULL_BITMAP(gres_node_ptr->topo_gres_bitmap[i]);
@@ -3354,6 +3428,17 @@ extern int gres_node_config_validate(char *node_name,
 			gres_mps_ptr = gres_ptr;
 	}
 	_sync_node_mps_to_gpu(gres_mps_ptr, gres_gpu_ptr);
+	if (*gres_list) {
+		ListIterator iter = list_iterator_create(*gres_list);
+		while ((gres_ptr = list_next(iter))) {
+			if (!gres_ptr->gres_data)
+				continue;
+			_gres_node_state_build_topo_sock(gres_ptr->gres_data,
+							 sock_cnt,
+							 cores_per_sock);
+		}
+		list_iterator_destroy(iter);
+	}
 	_build_node_gres_str(gres_list, new_config, cores_per_sock, sock_cnt);
 	slurm_mutex_unlock(&gres_context_lock);
 
@@ -4127,6 +4212,20 @@ static void *_node_state_dup(void *gres_data)
 		}
 	}
 
+	if (gres_ptr->topo_sock_bitmap) {
+		new_gres->topo_sock_bitmap = xcalloc(gres_ptr->topo_sock_recs,
+						     sizeof(bitstr_t *));
+		for (i = 0; i < gres_ptr->topo_sock_recs; i++) {
+			if (gres_ptr->topo_sock_bitmap[i]) {
+				new_gres->topo_sock_bitmap[i] =
+					bit_copy(gres_ptr->topo_sock_bitmap[i]);
+			}
+		}
+		new_gres->topo_sock_cnt   = gres_ptr->topo_sock_cnt;
+		new_gres->topo_sock_cores = gres_ptr->topo_sock_cores;
+		new_gres->topo_sock_recs  = gres_ptr->topo_sock_recs;
+	}
+
 	if (gres_ptr->type_cnt) {
 		new_gres->type_cnt       = gres_ptr->type_cnt;
 		new_gres->type_cnt_alloc = xcalloc(gres_ptr->type_cnt,
@@ -6741,6 +6840,15 @@ extern void gres_validate_node_cores(gres_node_state_t *node_gres_ptr,
 		FREE_NULL_BITMAP(node_gres_ptr->topo_core_bitmap[i]);
 		node_gres_ptr->topo_core_bitmap[i] = new_core_bitmap;
 	}
+
+	if (!log_mismatch) {
+		uint16_t sockets = node_gres_ptr->topo_sock_cnt;
+		if (sockets && ((cores_ctld % sockets) == 0))
+			_gres_node_state_build_topo_sock(node_gres_ptr, sockets,
+							 cores_ctld / sockets);
+		else
+			_gres_node_state_clear_topo_sock(node_gres_ptr);
+	}
 }
 
 static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
@@ -7220,10 +7328,20 @@ static sock_gres_t *_build_sock_gres_by_topo(
 	uint64_t avail_gres, min_gres = 0;
 	bool match = false;
 	bool use_busy_dev = false;
+	bool use_sock_table;
+	bitstr_t *sock_bitmap, *tmp_sock_bitmap = NULL;
+	bitstr_t *avail_sock_bitmap = NULL;
 
 	if (node_gres_ptr->gres_cnt_avail == 0)
 		return NULL;
 
+	/* Use the socket table built at registration if it fits this node */
+	use_sock_table = node_gres_ptr->topo_sock_bitmap &&
+			 (node_gres_ptr->topo_sock_recs ==
+			  node_gres_ptr->topo_cnt) &&
+			 (node_gres_ptr->topo_sock_cnt == sockets) &&
+			 (node_gres_ptr->topo_sock_cores == cores_per_sock);
+
 	if (!use_total_gres &&
 	    gres_id_shared(main_plugin_id) &&
 	    (node_gres_ptr->gres_cnt_alloc != 0)) {
@@ -7236,7 +7354,6 @@ static sock_gres_t *_build_sock_gres_by_topo(
 	sock_gres->bits_by_sock = xcalloc(sockets, sizeof(bitstr_t *));
 	sock_gres->cnt_by_sock = xcalloc(sockets, sizeof(uint64_t));
 	for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
-		bool use_all_sockets = false;
 		if (job_gres_ptr->type_name &&
 		    (job_gres_ptr->type_id != node_gres_ptr->topo_type_id[i]))
 			continue;	/* Wrong type_model */
@@ -7293,29 +7410,21 @@ static sock_gres_t *_build_sock_gres_by_topo(
 		 * If some GRES is available on every socket,
 		 * treat like no topo_core_bitmap is specified
 		 */
+		sock_bitmap = NULL;
 		if (node_gres_ptr->topo_core_bitmap &&
 		    node_gres_ptr->topo_core_bitmap[i]) {
-			use_all_sockets = true;
-			for (s = 0; s < sockets; s++) {
-				bool use_this_socket = false;
-				for (c = 0; c < cores_per_sock; c++) {
-					j = (s * cores_per_sock) + c;
-					if (bit_test(node_gres_ptr->
-						     topo_core_bitmap[i], j)) {
-						use_this_socket = true;
-						break;
-					}
-				}
-				if (!use_this_socket) {
-					use_all_sockets = false;
-					break;
-				}
+			if (use_sock_table) {
+				sock_bitmap = node_gres_ptr->topo_sock_bitmap[i];
+			} else {
+				FREE_NULL_BITMAP(tmp_sock_bitmap);
+				tmp_sock_bitmap = _topo_core2sock(
+					node_gres_ptr->topo_core_bitmap[i],
+					sockets, cores_per_sock);
+				sock_bitmap = tmp_sock_bitmap;
 			}
 		}
 
-		if (!node_gres_ptr->topo_core_bitmap ||
-		    !node_gres_ptr->topo_core_bitmap[i] ||
-		    use_all_sockets) {
+		if (!sock_bitmap) {
 			/*
 			 * Not constrained by core, but only specific
 			 * GRES may be available (save their bitmap)
@@ -7335,45 +7444,45 @@ static sock_gres_t *_build_sock_gres_by_topo(
 		}
 
 		/* Constrained by core */
-		for (s = 0; ((s < sockets) && avail_gres); s++) {
-			if (enforce_binding && core_bitmap) {
-				for (c = 0; c < cores_per_sock; c++) {
-					j = (s * cores_per_sock) + c;
-					if (bit_test(core_bitmap, j))
-						break;
-				}
-				if (c >= cores_per_sock) {
-					/* No available cores on this socket */
-					continue;
-				}
+		if (!node_gres_ptr->topo_gres_bitmap[i]) {
+			error("%s: topo_gres_bitmap NULL on node %s",
+			      __func__, node_name);
+			continue;
+		}
+		if (enforce_binding && core_bitmap && !avail_sock_bitmap) {
+			/* Sockets with available cores, built once per node */
+			avail_sock_bitmap = bit_alloc(sockets);
+			for (s = 0; s < sockets; s++) {
+				j = s * cores_per_sock;
+				if (bit_set_count_range(core_bitmap, j,
+							j + cores_per_sock))
+					bit_set(avail_sock_bitmap, s);
 			}
-			for (c = 0; c < cores_per_sock; c++) {
-				j = (s * cores_per_sock) + c;
-				if (node_gres_ptr->topo_core_bitmap[i] &&
-				    !bit_test(node_gres_ptr->topo_core_bitmap[i],
-					      j))
-					continue;
-				if (!node_gres_ptr->topo_gres_bitmap[i]) {
-					error("%s: topo_gres_bitmap NULL on node %s",
-					      __func__, node_name);
-					continue;
-				}
-				if (!sock_gres->bits_by_sock[s]) {
-					sock_gres->bits_by_sock[s] =
-						bit_copy(node_gres_ptr->
-							 topo_gres_bitmap[i]);
-				} else {
-					bit_or(sock_gres->bits_by_sock[s],
-					       node_gres_ptr->topo_gres_bitmap[i]);
-				}
-				sock_gres->cnt_by_sock[s] += avail_gres;
-				sock_gres->total_cnt += avail_gres;
-				avail_gres = 0;
-				match = true;
-				break;
+		}
+		for (s = 0; s < sockets; s++) {
+			if (!bit_test(sock_bitmap, s))
+				continue;
+			if (avail_sock_bitmap &&
+			    !bit_test(avail_sock_bitmap, s)) {
+				/* No available cores on this socket */
+				continue;
 			}
+			if (!sock_gres->bits_by_sock[s]) {
+				sock_gres->bits_by_sock[s] =
+					bit_copy(node_gres_ptr->
+						 topo_gres_bitmap[i]);
+			} else {
+				bit_or(sock_gres->bits_by_sock[s],
+				       node_gres_ptr->topo_gres_bitmap[i]);
+			}
+			sock_gres->cnt_by_sock[s] += avail_gres;
+			sock_gres->total_cnt += avail_gres;
+			match = true;
+			break;
 		}
 	}
+	FREE_NULL_BITMAP(tmp_sock_bitmap);
+	FREE_NULL_BITMAP(avail_sock_bitmap);
 
 	/* Process per-GRES limits */
 	if (match && job_gres_ptr->gres_per_socket) {
@@ -9192,8 +9301,8 @@ static bitstr_t *_get_usable_gres_cpu_affinity(int context_inx,
 #else
 	cpu_set_t mask;
 #endif
-	bitstr_t *usable_gres = NULL;
-	int i, i_last, rc;
+	bitstr_t *usable_gres = NULL, *task_cpus = NULL;
+	int i, cpu_cnt, rc;
 	ListIterator iter;
 	gres_slurmd_conf_t *gres_slurmd_conf;
 	int gres_inx = 0;
@@ -9232,21 +9341,30 @@ static bitstr_t *_get_usable_gres_cpu_affinity(int context_inx,
 		if (!gres_slurmd_conf->cpus_bitmap) {
 			bit_nset(usable_gres, gres_inx,
 				 gres_inx + gres_slurmd_conf->count - 1);
-		} else {
-			i_last = bit_fls(gres_slurmd_conf->cpus_bitmap);
-			for (i = 0; i <= i_last; i++) {
-				if (!bit_test(gres_slurmd_conf->cpus_bitmap, i))
-					continue;
-				if (!CPU_ISSET(i, &mask))
-					continue;
-				bit_nset(usable_gres, gres_inx,
-					 gres_inx + gres_slurmd_conf->count -1);
-				break;
+			gres_inx += gres_slurmd_conf->count;
+			continue;
+		}
+		/*
+		 * Translate the task's affinity mask once, then each GRES
+		 * record is a single word-wise overlap test.
+		 */
+		cpu_cnt = bit_size(gres_slurmd_conf->cpus_bitmap);
+		if (!task_cpus || (bit_size(task_cpus) != cpu_cnt)) {
+			FREE_NULL_BITMAP(task_cpus);
+			task_cpus = bit_alloc(cpu_cnt);
+			for (i = 0; i < cpu_cnt; i++) {
+				if (CPU_ISSET(i, &mask))
+					bit_set(task_cpus, i);
 			}
 		}
+		if (bit_overlap_any(gres_slurmd_conf->cpus_bitmap, task_cpus)) {
+			bit_nset(usable_gres, gres_inx,
+				 gres_inx + gres_slurmd_conf->count - 1);
+		}
 		gres_inx += gres_slurmd_conf->count;
 	}
 	list_iterator_destroy(iter);
+	FREE_NULL_BITMAP(task_cpus);
 
 #ifdef __NetBSD__
 	cpuset_destroy(mask);
@@ -185,6 +185,17 @@ typedef struct gres_node_state {
 	uint32_t *topo_type_id;		/* GRES type (e.g. model ID) */
 	char **topo_type_name;		/* GRES type (e.g. model name) */
 
+	/*
+	 * Sockets holding the cores of each topo_core_bitmap[#], built when
+	 * the node registers for topo_sock_cnt sockets of topo_sock_cores
+	 * cores each. A NULL entry means the GRES can be reached from every
+	 * socket. Rebuilt or cleared whenever topo_core_bitmap changes.
+	 */
+	bitstr_t **topo_sock_bitmap;
+	uint16_t topo_sock_cnt;		/* Sockets in topo_sock_bitmap[#] */
+	uint16_t topo_sock_cores;	/* Cores per socket */
+	uint16_t topo_sock_recs;	/* Size of topo_sock_bitmap */
+
 	/*
 	 * GRES type specific information (if gres.conf contains type option)
 	 *
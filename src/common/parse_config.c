@@ -104,12 +104,15 @@ struct s_p_values {
 		       const char *key, const char *value,
 		       const char *line, char **leftover);
 	void (*destroy)(void *data);
+	void (*pack)(void *data, uint16_t protocol_version, buf_t *buffer);
+	int (*unpack)(void **data, uint16_t protocol_version, buf_t *buffer);
 	s_p_values_t *next;
 };
 
 struct s_p_hashtbl {
 	regex_t keyvalue_re;
 	s_p_values_t *hash[CONF_HASH_LEN];
+	bool has_include;	/* values were parsed from an Include file */
 };
 
 typedef struct _expline_values_st {
@@ -183,6 +186,8 @@ s_p_hashtbl_t *s_p_hashtbl_create(const s_p_options_t options[])
 		value->next = NULL;
 		value->handler = op->handler;
 		value->destroy = op->destroy;
+		value->pack = op->pack;
+		value->unpack = op->unpack;
 		if (op->type == S_P_LINE || op->type == S_P_EXPLINE) {
 			/* line_options mandatory for S_P_*LINE */
 			_expline_values_t *expdata = xmalloc(sizeof(*expdata));
@@ -499,6 +504,8 @@ s_p_hashtbl_t *_hashtbl_copy_keys(const s_p_hashtbl_t *from_tbl)
 			val_copy->type = val_ptr->type;
 			val_copy->handler = val_ptr->handler;
 			val_copy->destroy = val_ptr->destroy;
+			val_copy->pack = val_ptr->pack;
+			val_copy->unpack = val_ptr->unpack;
 			_conf_hashtbl_insert(to_tbl, val_copy);
 		}
 	}
@@ -1132,6 +1139,7 @@ static int _parse_include_directive(s_p_hashtbl_t *hashtbl, uint32_t *hash_val,
 			ptr++;
 		fn_stop = *leftover = ptr;
 
+		hashtbl->has_include = true;
 		file_with_mod = xstrndup(fn_start, fn_stop-fn_start);
 		file_name = _parse_for_format(hashtbl, file_with_mod);//
 		xfree(file_with_mod);
@@ -2151,6 +2159,193 @@ void s_p_dump_values(const s_p_hashtbl_t *hashtbl,
 	}
 }
 
+/* Pack the data of one hashtbl value of the given type */
+static void _pack_value(s_p_values_t *p, slurm_parser_enum_t type,
+			buf_t *buffer)
+{
+	void **ptr_array;
+
+	switch (type) {
+	case S_P_STRING:
+	case S_P_PLAIN_STRING:
+		packstr((char *)p->data, buffer);
+		break;
+	case S_P_UINT32:
+	case S_P_LONG:
+		pack32(*(uint32_t *)p->data, buffer);
+		break;
+	case S_P_UINT16:
+		pack16(*(uint16_t *)p->data, buffer);
+		break;
+	case S_P_UINT64:
+		pack64(*(uint64_t *)p->data, buffer);
+		break;
+	case S_P_BOOLEAN:
+		packbool(*(bool *)p->data, buffer);
+		break;
+	case S_P_FLOAT:
+		packfloat(*(float *)p->data, buffer);
+		break;
+	case S_P_DOUBLE:
+		packdouble(*(double *)p->data, buffer);
+		break;
+	case S_P_LONG_DOUBLE:
+		packlongdouble(*(long double *)p->data, buffer);
+		break;
+	case S_P_POINTER:
+		if (p->pack)
+			(p->pack)(p->data, SLURM_PROTOCOL_VERSION, buffer);
+		else if (!p->handler)
+			packstr((char *)p->data, buffer);
+		else
+			fatal("%s: no pack function for %s", __func__, p->key);
+		break;
+	case S_P_ARRAY:
+		ptr_array = (void **)p->data;
+		for (int i = 0; i < p->data_count; i++) {
+			if (p->pack)
+				(p->pack)(ptr_array[i], SLURM_PROTOCOL_VERSION,
+					  buffer);
+			else if (!p->handler)
+				packstr((char *)ptr_array[i], buffer);
+			else
+				fatal("%s: no pack function for %s",
+				      __func__, p->key);
+		}
+		break;
+	case S_P_IGNORE:
+		break;
+	default:
+		fatal("%s: unsupported pack type %d", __func__, type);
+		break;
+	}
+}
+
+static int _unpack_value(s_p_values_t *value, buf_t *buffer)
+{
+	bool bool_tmp;
+	uint16_t uint16_tmp;
+	uint32_t uint32_tmp;
+	uint64_t uint64_tmp;
+	float float_tmp;
+	double double_tmp;
+	long double ldouble_tmp;
+	char *tmp_char;
+	void **ptr_array;
+
+	switch (value->type) {
+	case S_P_STRING:
+	case S_P_PLAIN_STRING:
+		safe_unpackstr_xmalloc(&tmp_char, &uint32_tmp, buffer);
+		value->data = tmp_char;
+		break;
+	case S_P_UINT32:
+		safe_unpack32(&uint32_tmp, buffer);
+		value->data = xmalloc(sizeof(uint32_t));
+		*(uint32_t *)value->data = uint32_tmp;
+		break;
+	case S_P_LONG:
+		safe_unpack32(&uint32_tmp, buffer);
+		value->data = xmalloc(sizeof(long));
+		*(long *)value->data = (long)uint32_tmp;
+		break;
+	case S_P_UINT16:
+		safe_unpack16(&uint16_tmp, buffer);
+		value->data = xmalloc(sizeof(uint16_t));
+		*(uint16_t *)value->data = uint16_tmp;
+		break;
+	case S_P_UINT64:
+		safe_unpack64(&uint64_tmp, buffer);
+		value->data = xmalloc(sizeof(uint64_t));
+		*(uint64_t *)value->data = uint64_tmp;
+		break;
+	case S_P_BOOLEAN:
+		safe_unpackbool(&bool_tmp, buffer);
+		value->data = xmalloc(sizeof(bool));
+		*(bool *)value->data = bool_tmp;
+		break;
+	case S_P_FLOAT:
+		safe_unpackfloat(&float_tmp, buffer);
+		value->data = xmalloc(sizeof(float));
+		*(float *)value->data = float_tmp;
+		break;
+	case S_P_DOUBLE:
+		safe_unpackdouble(&double_tmp, buffer);
+		value->data = xmalloc(sizeof(double));
+		*(double *)value->data = double_tmp;
+		break;
+	case S_P_LONG_DOUBLE:
+		safe_unpacklongdouble(&ldouble_tmp, buffer);
+		value->data = xmalloc(sizeof(long double));
+		*(long double *)value->data = ldouble_tmp;
+		break;
+	case S_P_POINTER:
+		if (value->unpack) {
+			if ((value->unpack)(&value->data,
+					    SLURM_PROTOCOL_VERSION, buffer))
+				goto unpack_error;
+		} else if (!value->handler) {
+			safe_unpackstr_xmalloc(&tmp_char, &uint32_tmp, buffer);
+			value->data = tmp_char;
+		} else
+			goto unpack_error;
+		break;
+	case S_P_ARRAY:
+		if (value->data_count > (remaining_buf(buffer) /
+					 sizeof(uint32_t)))
+			goto unpack_error;
+		ptr_array = xcalloc(value->data_count, sizeof(void *));
+		value->data = ptr_array;
+		for (int i = 0; i < value->data_count; i++) {
+			if (value->unpack) {
+				if ((value->unpack)(&ptr_array[i],
+						    SLURM_PROTOCOL_VERSION,
+						    buffer))
+					goto unpack_error;
+			} else if (!value->handler) {
+				safe_unpackstr_xmalloc(&tmp_char, &uint32_tmp,
+						       buffer);
+				ptr_array[i] = tmp_char;
+			} else
+				goto unpack_error;
+		}
+		break;
+	case S_P_IGNORE:
+		break;
+	default:
+		error("%s: unsupported pack type %d", __func__, value->type);
+		value->data_count = 0;
+		return SLURM_ERROR;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	/* Leave nothing that s_p_hashtbl_destroy() could trip over */
+	if (value->type == S_P_ARRAY) {
+		ptr_array = (void **)value->data;
+		for (int i = 0; ptr_array && (i < value->data_count); i++) {
+			if (!ptr_array[i])
+				continue;
+			if (value->destroy)
+				value->destroy(ptr_array[i]);
+			else
+				xfree(ptr_array[i]);
+		}
+		xfree(value->data);
+	}
+	value->data = NULL;
+	value->data_count = 0;
+	return SLURM_ERROR;
+}
+
+extern bool s_p_has_include(const s_p_hashtbl_t *hashtbl)
+{
+	xassert(hashtbl);
+
+	return hashtbl->has_include;
+}
+
 /*
  * Given an "options" array, pack the key, type of options along with values and
  * op of the hashtbl.
@@ -2184,40 +2379,7 @@ extern buf_t *s_p_pack_hashtbl(const s_p_hashtbl_t *hashtbl,
 		if (!p->data_count)
 			continue;
 
-		switch (options[i].type) {
-		case S_P_STRING:
-		case S_P_PLAIN_STRING:
-			packstr((char *)p->data, buffer);
-			break;
-		case S_P_UINT32:
-		case S_P_LONG:
-			pack32(*(uint32_t *)p->data, buffer);
-			break;
-		case S_P_UINT16:
-			pack16(*(uint16_t *)p->data, buffer);
-			break;
-		case S_P_UINT64:
-			pack64(*(uint64_t *)p->data, buffer);
-			break;
-		case S_P_BOOLEAN:
-			packbool(*(bool *)p->data, buffer);
-			break;
-		case S_P_FLOAT:
-			packfloat(*(float *)p->data, buffer);
-			break;
-		case S_P_DOUBLE:
-			packdouble(*(double *)p->data, buffer);
-			break;
-		case S_P_LONG_DOUBLE:
-			packlongdouble(*(long double *)p->data, buffer);
-			break;
-		case S_P_IGNORE:
-			break;
-		default:
-			fatal("%s: unsupported pack type %d",
-			      __func__, options[i].type);
-			break;
-		}
+		_pack_value(p, options[i].type, buffer);
 	}
 
 	return buffer;
@@ -2231,14 +2393,8 @@ extern s_p_hashtbl_t *s_p_unpack_hashtbl(buf_t *buffer)
 	s_p_values_t *value = NULL;
 	s_p_hashtbl_t *hashtbl = NULL;
 	int i;
-	bool bool_tmp;
 	uint16_t uint16_tmp;
 	uint32_t cnt, uint32_tmp;
-	uint64_t uint64_tmp;
-	float float_tmp;
-	double double_tmp;
-	long double ldouble_tmp;
-	char *tmp_char;
 
 	safe_unpack32(&cnt, buffer);
 
@@ -2260,63 +2416,56 @@ extern s_p_hashtbl_t *s_p_unpack_hashtbl(buf_t *buffer)
 		if (!value->data_count)
 			continue;
 
-		switch (value->type) {
-		case S_P_STRING:
-		case S_P_PLAIN_STRING:
-			safe_unpackstr_xmalloc(&tmp_char, &uint32_tmp, buffer);
-			value->data = tmp_char;
-			break;
-		case S_P_UINT32:
-			safe_unpack32(&uint32_tmp, buffer);
-			value->data = xmalloc(sizeof(uint32_t));
-			*(uint32_t *)value->data = uint32_tmp;
-			break;
-		case S_P_LONG:
-			safe_unpack32(&uint32_tmp, buffer);
-			value->data = xmalloc(sizeof(long));
-			*(long *)value->data = (long)uint32_tmp;
-			break;
-		case S_P_UINT16:
-			safe_unpack16(&uint16_tmp, buffer);
-			value->data = xmalloc(sizeof(uint16_t));
-			*(uint16_t *)value->data = uint16_tmp;
-			break;
-		case S_P_UINT64:
-			safe_unpack64(&uint64_tmp, buffer);
-			value->data = xmalloc(sizeof(uint64_t));
-			*(uint64_t *)value->data = uint64_tmp;
-			break;
-		case S_P_BOOLEAN:
-			safe_unpackbool(&bool_tmp, buffer);
-			value->data = xmalloc(sizeof(bool));
-			*(bool *)value->data = bool_tmp;
-			break;
-		case S_P_FLOAT:
-			safe_unpackfloat(&float_tmp, buffer);
-			value->data = xmalloc(sizeof(float));
-			*(float *)value->data = float_tmp;
-			break;
-		case S_P_DOUBLE:
-			safe_unpackdouble(&double_tmp, buffer);
-			value->data = xmalloc(sizeof(double));
-			*(double *)value->data = double_tmp;
-			break;
-		case S_P_LONG_DOUBLE:
-			safe_unpacklongdouble(&ldouble_tmp, buffer);
-			value->data = xmalloc(sizeof(long double));
-			*(long double *)value->data = ldouble_tmp;
-			break;
-		case S_P_IGNORE:
-			break;
-		default:
-			fatal("%s: unsupported pack type %d",
-			      __func__, value->type);
-			break;
+		if (_unpack_value(value, buffer))
+			goto unpack_error;
+	}
+
+	return hashtbl;
+unpack_error:
+	s_p_hashtbl_destroy(hashtbl);
+	error("%s: failed", __func__);
+	return NULL;
+}
+
+extern s_p_hashtbl_t *s_p_unpack_hashtbl_full(buf_t *buffer,
+					      const s_p_options_t options[])
+{
+	s_p_values_t *value = NULL;
+	s_p_hashtbl_t *hashtbl = NULL;
+	int i;
+	uint16_t type, operator;
+	uint32_t cnt, data_count, uint32_tmp;
+	char *key = NULL;
+
+	hashtbl = s_p_hashtbl_create(options);
+
+	safe_unpack32(&cnt, buffer);
+
+	for (i = 0; i < cnt; i++) {
+		safe_unpack16(&type, buffer);
+		safe_unpackstr_xmalloc(&key, &uint32_tmp, buffer);
+		safe_unpack16(&operator, buffer);
+		safe_unpack32(&data_count, buffer);
+
+		if (!(value = _conf_hashtbl_lookup(hashtbl, key)) ||
+		    (value->type != type)) {
+			error("%s: unexpected key %s", __func__, key);
+			goto unpack_error;
 		}
+		xfree(key);
+
+		value->operator = operator;
+		value->data_count = data_count;
+		if (!value->data_count)
+			continue;
+
+		if (_unpack_value(value, buffer))
+			goto unpack_error;
 	}
 
 	return hashtbl;
 unpack_error:
+	xfree(key);
 	s_p_hashtbl_destroy(hashtbl);
 	error("%s: failed", __func__);
 	return NULL;
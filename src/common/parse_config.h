@@ -295,6 +295,12 @@ typedef struct conf_file_options {
 		       const char *line, char **leftover);
 	void (*destroy)(void *data);
 	struct conf_file_options* line_options;
+	/*
+	 * Used by s_p_pack_hashtbl() and s_p_unpack_hashtbl_full() for the
+	 * values of S_P_POINTER and S_P_ARRAY options set by a handler.
+	 */
+	void (*pack)(void *data, uint16_t protocol_version, buf_t *buffer);
+	int (*unpack)(void **data, uint16_t protocol_version, buf_t *buffer);
 } s_p_options_t;
 
 
@@ -621,6 +627,11 @@ int s_p_get_boolean(bool *flag, const char *key, const s_p_hashtbl_t *hashtbl);
 void s_p_dump_values(const s_p_hashtbl_t *hashtbl,
 		     const s_p_options_t options[]);
 
+/*
+ * Return true if any value of the hashtbl was parsed from a file named by an
+ * Include directive
+ */
+extern bool s_p_has_include(const s_p_hashtbl_t *hashtbl);
 
 /*
  * Given an "options" array, pack the key, type of options along with values and
@@ -638,6 +649,14 @@ extern buf_t *s_p_pack_hashtbl(const s_p_hashtbl_t *hashtbl,
  */
 extern s_p_hashtbl_t *s_p_unpack_hashtbl(buf_t *buffer);
 
+/*
+ * Given a buffer from s_p_pack_hashtbl(), unpack the values into a new
+ * hashtbl created from "options", so the handlers' destroy functions are
+ * kept. Keys not found in "options" are an error.
+ */
+extern s_p_hashtbl_t *s_p_unpack_hashtbl_full(buf_t *buffer,
+					      const s_p_options_t options[]);
+
 /*
  * copy options onto the end of full_options
  * IN/OUT full_options
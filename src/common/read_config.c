@@ -48,6 +48,7 @@
 #include <arpa/inet.h>
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <netdb.h>
 #include <netinet/in.h>
@@ -65,6 +66,7 @@
 #include "slurm/slurm.h"
 
 #include "src/common/cpu_frequency.h"
+#include "src/common/fd.h"
 #include "src/common/fetch_config.h"
 #include "src/common/hostlist.h"
 #include "src/common/list.h"
@@ -76,9 +78,11 @@
 #include "src/common/parse_time.h"
 #include "src/common/proc_args.h"
 #include "src/common/read_config.h"
+#include "src/common/run_in_daemon.h"
 #include "src/common/slurm_accounting_storage.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_protocol_defs.h"
+#include "src/common/slurm_protocol_pack.h"
 #include "src/common/slurm_resource_info.h"
 #include "src/common/slurm_resolv.h"
 #include "src/common/slurm_rlimits_info.h"
@@ -160,6 +164,14 @@ typedef struct slurm_conf_server {
 } slurm_conf_server_t;
 
 static void _destroy_nodename(void *ptr);
+static void _pack_nodename(void *ptr, uint16_t protocol_version,
+			   buf_t *buffer);
+static int _unpack_nodename(void **dest, uint16_t protocol_version,
+			    buf_t *buffer);
+static void _pack_frontend(void *ptr, uint16_t protocol_version,
+			   buf_t *buffer);
+static int _unpack_frontend(void **dest, uint16_t protocol_version,
+			    buf_t *buffer);
 static int _parse_frontend(void **dest, slurm_parser_enum_t type,
 			   const char *key, const char *value,
 			   const char *line, char **leftover);
@@ -171,20 +183,35 @@ static int _parse_partitionname(void **dest, slurm_parser_enum_t type,
 				const char *key, const char *value,
 				const char *line, char **leftover);
 static void _destroy_partitionname(void *ptr);
+static void _pack_partitionname(void *ptr, uint16_t protocol_version,
+				buf_t *buffer);
+static int _unpack_partitionname(void **dest, uint16_t protocol_version,
+				 buf_t *buffer);
 static int _parse_downnodes(void **dest, slurm_parser_enum_t type,
 			    const char *key, const char *value,
 			    const char *line, char **leftover);
 static void _destroy_downnodes(void *ptr);
+static void _pack_downnodes(void *ptr, uint16_t protocol_version,
+			    buf_t *buffer);
+static int _unpack_downnodes(void **dest, uint16_t protocol_version,
+			     buf_t *buffer);
 static int _parse_nodeset(void **dest, slurm_parser_enum_t type,
 			  const char *key, const char *value,
 			  const char *line, char **leftover);
 static void _destroy_nodeset(void *ptr);
+static void _pack_nodeset(void *ptr, uint16_t protocol_version, buf_t *buffer);
+static int _unpack_nodeset(void **dest, uint16_t protocol_version,
+			   buf_t *buffer);
 
 static int _load_slurmctld_host(slurm_conf_t *conf);
 static int _parse_slurmctld_host(void **dest, slurm_parser_enum_t type,
 				 const char *key, const char *value,
 				 const char *line, char **leftover);
 static void _destroy_slurmctld_host(void *ptr);
+static void _pack_slurmctld_host(void *ptr, uint16_t protocol_version,
+				 buf_t *buffer);
+static int _unpack_slurmctld_host(void **dest, uint16_t protocol_version,
+				  buf_t *buffer);
 
 static int _defunct_option(void **dest, slurm_parser_enum_t type,
 			   const char *key, const char *value,
@@ -415,14 +442,20 @@ s_p_options_t slurm_conf_options[] = {
 	{"WaitTime", S_P_UINT16},
 	{"X11Parameters", S_P_STRING},
 
-	{"DownNodes", S_P_ARRAY, _parse_downnodes, _destroy_downnodes},
-	{"FrontendName", S_P_ARRAY, _parse_frontend, destroy_frontend},
-	{"NodeName", S_P_ARRAY, _parse_nodename, _destroy_nodename},
-	{"NodeSet", S_P_ARRAY, _parse_nodeset, _destroy_nodeset},
+	{"DownNodes", S_P_ARRAY, _parse_downnodes, _destroy_downnodes, NULL,
+	 _pack_downnodes, _unpack_downnodes},
+	{"FrontendName", S_P_ARRAY, _parse_frontend, destroy_frontend, NULL,
+	 _pack_frontend, _unpack_frontend},
+	{"NodeName", S_P_ARRAY, _parse_nodename, _destroy_nodename, NULL,
+	 _pack_nodename, _unpack_nodename},
+	{"NodeSet", S_P_ARRAY, _parse_nodeset, _destroy_nodeset, NULL,
+	 _pack_nodeset, _unpack_nodeset},
 	{"PartitionName", S_P_ARRAY, _parse_partitionname,
-	 _destroy_partitionname},
+	 _destroy_partitionname, NULL, _pack_partitionname,
+	 _unpack_partitionname},
 	{"SlurmctldHost", S_P_ARRAY, _parse_slurmctld_host,
-	 _destroy_slurmctld_host},
+	 _destroy_slurmctld_host, NULL, _pack_slurmctld_host,
+	 _unpack_slurmctld_host},
 
 	{NULL}
 };
@@ -936,6 +969,47 @@ extern void destroy_frontend(void *ptr)
 	xfree(ptr);
 }
 
+static void _pack_frontend(void *ptr, uint16_t protocol_version,
+			   buf_t *buffer)
+{
+	slurm_conf_frontend_t *n = (slurm_conf_frontend_t *) ptr;
+
+	packstr(n->addresses, buffer);
+	packstr(n->allow_groups, buffer);
+	packstr(n->allow_users, buffer);
+	packstr(n->deny_groups, buffer);
+	packstr(n->deny_users, buffer);
+	packstr(n->frontends, buffer);
+	pack16(n->node_state, buffer);
+	pack16(n->port, buffer);
+	packstr(n->reason, buffer);
+}
+
+static int _unpack_frontend(void **dest, uint16_t protocol_version,
+			    buf_t *buffer)
+{
+	uint32_t uint32_tmp;
+	slurm_conf_frontend_t *n = xmalloc(sizeof(slurm_conf_frontend_t));
+
+	safe_unpackstr_xmalloc(&n->addresses, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&n->allow_groups, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&n->allow_users, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&n->deny_groups, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&n->deny_users, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&n->frontends, &uint32_tmp, buffer);
+	safe_unpack16(&n->node_state, buffer);
+	safe_unpack16(&n->port, buffer);
+	safe_unpackstr_xmalloc(&n->reason, &uint32_tmp, buffer);
+
+	*dest = n;
+	return SLURM_SUCCESS;
+
+unpack_error:
+	destroy_frontend(n);
+	*dest = NULL;
+	return SLURM_ERROR;
+}
+
 /*
  * _list_find_frontend - find an entry in the front_end list, see list.h for
  *	documentation
@@ -971,6 +1045,78 @@ static void _destroy_nodename(void *ptr)
 	xfree(ptr);
 }
 
+static void _pack_nodename(void *ptr, uint16_t protocol_version,
+			   buf_t *buffer)
+{
+	slurm_conf_node_t *n = (slurm_conf_node_t *)ptr;
+
+	packstr(n->addresses, buffer);
+	packstr(n->bcast_addresses, buffer);
+	pack16(n->boards, buffer);
+	pack16(n->core_spec_cnt, buffer);
+	pack16(n->cores, buffer);
+	pack32(n->cpu_bind, buffer);
+	packstr(n->cpu_spec_list, buffer);
+	pack16(n->cpus, buffer);
+	packstr(n->feature, buffer);
+	packstr(n->gres, buffer);
+	packstr(n->hostnames, buffer);
+	pack64(n->mem_spec_limit, buffer);
+	packstr(n->nodenames, buffer);
+	packstr(n->port_str, buffer);
+	pack64(n->real_memory, buffer);
+	packstr(n->reason, buffer);
+	packstr(n->state, buffer);
+	pack16(n->threads, buffer);
+	pack32(n->tmp_disk, buffer);
+	pack16(n->tot_sockets, buffer);
+	packstr(n->tres_weights_str, buffer);
+	pack32(n->weight, buffer);
+}
+
+static int _unpack_nodename(void **dest, uint16_t protocol_version,
+			    buf_t *buffer)
+{
+	uint32_t uint32_tmp;
+	slurm_conf_node_t *n = xmalloc(sizeof(slurm_conf_node_t));
+
+	safe_unpackstr_xmalloc(&n->addresses, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&n->bcast_addresses, &uint32_tmp, buffer);
+	safe_unpack16(&n->boards, buffer);
+	safe_unpack16(&n->core_spec_cnt, buffer);
+	safe_unpack16(&n->cores, buffer);
+	safe_unpack32(&n->cpu_bind, buffer);
+	safe_unpackstr_xmalloc(&n->cpu_spec_list, &uint32_tmp, buffer);
+	safe_unpack16(&n->cpus, buffer);
+	safe_unpackstr_xmalloc(&n->feature, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&n->gres, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&n->hostnames, &uint32_tmp, buffer);
+	safe_unpack64(&n->mem_spec_limit, buffer);
+	safe_unpackstr_xmalloc(&n->nodenames, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&n->port_str, &uint32_tmp, buffer);
+	safe_unpack64(&n->real_memory, buffer);
+	safe_unpackstr_xmalloc(&n->reason, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&n->state, &uint32_tmp, buffer);
+	safe_unpack16(&n->threads, buffer);
+	safe_unpack32(&n->tmp_disk, buffer);
+	safe_unpack16(&n->tot_sockets, buffer);
+	safe_unpackstr_xmalloc(&n->tres_weights_str, &uint32_tmp, buffer);
+	safe_unpack32(&n->weight, buffer);
+
+	/* Same as done by _parse_nodename() */
+	if ((slurmdb_setup_cluster_name_dims() > 1)
+	    && conf_ptr->node_prefix == NULL)
+		_set_node_prefix(n->nodenames);
+
+	*dest = n;
+	return SLURM_SUCCESS;
+
+unpack_error:
+	_destroy_nodename(n);
+	*dest = NULL;
+	return SLURM_ERROR;
+}
+
 /* _parse_srun_ports()
  *
  * Parse the srun port range specified like min-max.
@@ -1713,6 +1859,112 @@ static void _destroy_partitionname(void *ptr)
 	xfree(ptr);
 }
 
+static void _pack_partitionname(void *ptr, uint16_t protocol_version,
+				buf_t *buffer)
+{
+	slurm_conf_partition_t *p = (slurm_conf_partition_t *)ptr;
+
+	packstr(p->allow_alloc_nodes, buffer);
+	packstr(p->allow_accounts, buffer);
+	packstr(p->allow_groups, buffer);
+	packstr(p->allow_qos, buffer);
+	packstr(p->alternate, buffer);
+	packstr(p->billing_weights_str, buffer);
+	pack32(p->cpu_bind, buffer);
+	pack16(p->cr_type, buffer);
+	pack64(p->def_mem_per_cpu, buffer);
+	packbool(p->default_flag, buffer);
+	pack32(p->default_time, buffer);
+	packstr(p->deny_accounts, buffer);
+	packstr(p->deny_qos, buffer);
+	pack16(p->disable_root_jobs, buffer);
+	pack16(p->exclusive_user, buffer);
+	pack32(p->grace_time, buffer);
+	packbool(p->hidden_flag, buffer);
+	(void) slurm_pack_list(p->job_defaults_list, job_defaults_pack,
+			       buffer, protocol_version);
+	packbool(p->lln_flag, buffer);
+	pack32(p->max_cpus_per_node, buffer);
+	pack64(p->max_mem_per_cpu, buffer);
+	pack32(p->max_nodes, buffer);
+	pack16(p->max_share, buffer);
+	pack32(p->max_time, buffer);
+	pack32(p->min_nodes, buffer);
+	packstr(p->name, buffer);
+	packstr(p->nodes, buffer);
+	pack16(p->over_time_limit, buffer);
+	pack16(p->preempt_mode, buffer);
+	pack16(p->priority_job_factor, buffer);
+	pack16(p->priority_tier, buffer);
+	packstr(p->qos_char, buffer);
+	packbool(p->req_resv_flag, buffer);
+	pack16(p->resume_timeout, buffer);
+	packbool(p->root_only_flag, buffer);
+	pack16(p->state_up, buffer);
+	pack32(p->suspend_time, buffer);
+	pack16(p->suspend_timeout, buffer);
+	pack32(p->total_cpus, buffer);
+	pack32(p->total_nodes, buffer);
+}
+
+static int _unpack_partitionname(void **dest, uint16_t protocol_version,
+				 buf_t *buffer)
+{
+	uint32_t uint32_tmp;
+	slurm_conf_partition_t *p = xmalloc(sizeof(slurm_conf_partition_t));
+
+	safe_unpackstr_xmalloc(&p->allow_alloc_nodes, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&p->allow_accounts, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&p->allow_groups, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&p->allow_qos, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&p->alternate, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&p->billing_weights_str, &uint32_tmp, buffer);
+	safe_unpack32(&p->cpu_bind, buffer);
+	safe_unpack16(&p->cr_type, buffer);
+	safe_unpack64(&p->def_mem_per_cpu, buffer);
+	safe_unpackbool(&p->default_flag, buffer);
+	safe_unpack32(&p->default_time, buffer);
+	safe_unpackstr_xmalloc(&p->deny_accounts, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&p->deny_qos, &uint32_tmp, buffer);
+	safe_unpack16(&p->disable_root_jobs, buffer);
+	safe_unpack16(&p->exclusive_user, buffer);
+	safe_unpack32(&p->grace_time, buffer);
+	safe_unpackbool(&p->hidden_flag, buffer);
+	if (slurm_unpack_list(&p->job_defaults_list, job_defaults_unpack,
+			      xfree_ptr, buffer, protocol_version))
+		goto unpack_error;
+	safe_unpackbool(&p->lln_flag, buffer);
+	safe_unpack32(&p->max_cpus_per_node, buffer);
+	safe_unpack64(&p->max_mem_per_cpu, buffer);
+	safe_unpack32(&p->max_nodes, buffer);
+	safe_unpack16(&p->max_share, buffer);
+	safe_unpack32(&p->max_time, buffer);
+	safe_unpack32(&p->min_nodes, buffer);
+	safe_unpackstr_xmalloc(&p->name, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&p->nodes, &uint32_tmp, buffer);
+	safe_unpack16(&p->over_time_limit, buffer);
+	safe_unpack16(&p->preempt_mode, buffer);
+	safe_unpack16(&p->priority_job_factor, buffer);
+	safe_unpack16(&p->priority_tier, buffer);
+	safe_unpackstr_xmalloc(&p->qos_char, &uint32_tmp, buffer);
+	safe_unpackbool(&p->req_resv_flag, buffer);
+	safe_unpack16(&p->resume_timeout, buffer);
+	safe_unpackbool(&p->root_only_flag, buffer);
+	safe_unpack16(&p->state_up, buffer);
+	safe_unpack32(&p->suspend_time, buffer);
+	safe_unpack16(&p->suspend_timeout, buffer);
+	safe_unpack32(&p->total_cpus, buffer);
+	safe_unpack32(&p->total_nodes, buffer);
+
+	*dest = p;
+	return SLURM_SUCCESS;
+
+unpack_error:
+	_destroy_partitionname(p);
+	*dest = NULL;
+	return SLURM_ERROR;
+}
+
 static int _load_slurmctld_host(slurm_conf_t *conf)
 {
 	int count = 0, i, j;
@@ -1896,6 +2148,33 @@ static void _destroy_slurmctld_host(void *ptr)
 	xfree(ptr);
 }
 
+static void _pack_slurmctld_host(void *ptr, uint16_t protocol_version,
+				 buf_t *buffer)
+{
+	slurm_conf_server_t *p = (slurm_conf_server_t *) ptr;
+
+	packstr(p->addr, buffer);
+	packstr(p->hostname, buffer);
+}
+
+static int _unpack_slurmctld_host(void **dest, uint16_t protocol_version,
+				  buf_t *buffer)
+{
+	uint32_t uint32_tmp;
+	slurm_conf_server_t *p = xmalloc(sizeof(slurm_conf_server_t));
+
+	safe_unpackstr_xmalloc(&p->addr, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&p->hostname, &uint32_tmp, buffer);
+
+	*dest = p;
+	return SLURM_SUCCESS;
+
+unpack_error:
+	_destroy_slurmctld_host(p);
+	*dest = NULL;
+	return SLURM_ERROR;
+}
+
 int slurm_conf_partition_array(slurm_conf_partition_t **ptr_array[])
 {
 	int count = 0;
@@ -1952,6 +2231,35 @@ static void _destroy_downnodes(void *ptr)
 	xfree(ptr);
 }
 
+static void _pack_downnodes(void *ptr, uint16_t protocol_version,
+			    buf_t *buffer)
+{
+	slurm_conf_downnodes_t *n = (slurm_conf_downnodes_t *)ptr;
+
+	packstr(n->nodenames, buffer);
+	packstr(n->reason, buffer);
+	packstr(n->state, buffer);
+}
+
+static int _unpack_downnodes(void **dest, uint16_t protocol_version,
+			     buf_t *buffer)
+{
+	uint32_t uint32_tmp;
+	slurm_conf_downnodes_t *n = xmalloc(sizeof(slurm_conf_downnodes_t));
+
+	safe_unpackstr_xmalloc(&n->nodenames, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&n->reason, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&n->state, &uint32_tmp, buffer);
+
+	*dest = n;
+	return SLURM_SUCCESS;
+
+unpack_error:
+	_destroy_downnodes(n);
+	*dest = NULL;
+	return SLURM_ERROR;
+}
+
 extern int slurm_conf_downnodes_array(slurm_conf_downnodes_t **ptr_array[])
 {
 	int count = 0;
@@ -2004,6 +2312,34 @@ static void _destroy_nodeset(void *ptr)
 	xfree(ptr);
 }
 
+static void _pack_nodeset(void *ptr, uint16_t protocol_version, buf_t *buffer)
+{
+	slurm_conf_nodeset_t *n = (slurm_conf_nodeset_t *)ptr;
+
+	packstr(n->feature, buffer);
+	packstr(n->name, buffer);
+	packstr(n->nodes, buffer);
+}
+
+static int _unpack_nodeset(void **dest, uint16_t protocol_version,
+			   buf_t *buffer)
+{
+	uint32_t uint32_tmp;
+	slurm_conf_nodeset_t *n = xmalloc(sizeof(slurm_conf_nodeset_t));
+
+	safe_unpackstr_xmalloc(&n->feature, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&n->name, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&n->nodes, &uint32_tmp, buffer);
+
+	*dest = n;
+	return SLURM_SUCCESS;
+
+unpack_error:
+	_destroy_nodeset(n);
+	*dest = NULL;
+	return SLURM_ERROR;
+}
+
 extern int slurm_conf_nodeset_array(slurm_conf_nodeset_t **ptr_array[])
 {
 	int count = 0;
@@ -3114,6 +3450,152 @@ void init_slurm_conf(slurm_conf_t *ctl_conf_ptr)
 	return;
 }
 
+/*
+ * Load conf_hashtbl from a snapshot written by slurm_conf_snapshot_write()
+ * instead of parsing file_name. The snapshot is only used if it was written
+ * by this Slurm version from the file_name currently on disk. Only file_name
+ * is checked, which is enough since no snapshot is written when it uses
+ * Include.
+ * caller must lock conf_lock
+ */
+static int _load_conf_snapshot(const char *file_name)
+{
+	static bool run = false, set = false;
+	struct stat stat_buf;
+	char *snapshot, *ver_str = NULL;
+	buf_t *buffer = NULL;
+	s_p_hashtbl_t *tbl;
+	uint16_t protocol_version;
+	uint32_t hash_val, uint32_tmp;
+	uint64_t snap_dev, snap_ino, snap_size;
+	time_t snap_mtime;
+	int rc = SLURM_ERROR;
+
+	/* The daemons always read the files they are authoritative for */
+	if (run_in_daemon(&run, &set, "slurmctld,slurmd,slurmdbd"))
+		return SLURM_ERROR;
+
+	if (!(snapshot = xstrdup(getenv("SLURM_CONF_SNAPSHOT"))))
+		snapshot = xstrdup_printf("%s.snapshot", file_name);
+	if (stat(snapshot, &stat_buf) || stat(file_name, &stat_buf) ||
+	    !(buffer = create_mmap_buf(snapshot)))
+		goto fini;
+
+	safe_unpackstr_xmalloc(&ver_str, &uint32_tmp, buffer);
+	safe_unpack16(&protocol_version, buffer);
+	if (xstrcmp(ver_str, SLURM_VERSION_STRING) ||
+	    (protocol_version != SLURM_PROTOCOL_VERSION)) {
+		debug("%s: %s was written by Slurm %s, ignoring it",
+		      __func__, snapshot, ver_str);
+		goto fini;
+	}
+
+	safe_unpack64(&snap_dev, buffer);
+	safe_unpack64(&snap_ino, buffer);
+	safe_unpack64(&snap_size, buffer);
+	safe_unpack_time(&snap_mtime, buffer);
+	safe_unpack32(&hash_val, buffer);
+	if ((snap_dev != stat_buf.st_dev) || (snap_ino != stat_buf.st_ino) ||
+	    (snap_size != stat_buf.st_size) ||
+	    (snap_mtime != stat_buf.st_mtime)) {
+		debug("%s: %s is out of date with %s, ignoring it",
+		      __func__, snapshot, file_name);
+		goto fini;
+	}
+
+	if (!(tbl = s_p_unpack_hashtbl_full(buffer, slurm_conf_options)))
+		goto unpack_error;
+
+	s_p_hashtbl_destroy(conf_hashtbl);
+	conf_hashtbl = tbl;
+	conf_ptr->hash_val = hash_val;
+	debug("Loaded slurm.conf snapshot: %s", snapshot);
+	rc = SLURM_SUCCESS;
+	goto fini;
+
+unpack_error:
+	error("%s: Incomplete snapshot file %s", __func__, snapshot);
+fini:
+	free_buf(buffer);
+	xfree(ver_str);
+	xfree(snapshot);
+	return rc;
+}
+
+extern int slurm_conf_snapshot_write(const char *file)
+{
+	struct stat stat_buf;
+	buf_t *buffer, *tbl_buf;
+	char *new_file = NULL;
+	int cnt = 0, fd, rc = SLURM_SUCCESS;
+
+	slurm_mutex_lock(&conf_lock);
+	if (!conf_initialized || !conf_hashtbl ||
+	    stat(conf_ptr->slurm_conf, &stat_buf)) {
+		slurm_mutex_unlock(&conf_lock);
+		return SLURM_ERROR;
+	}
+	if (s_p_has_include(conf_hashtbl)) {
+		/* A change to an included file would go unnoticed */
+		info("%s: %s uses Include, not writing %s",
+		     __func__, conf_ptr->slurm_conf, file);
+		slurm_mutex_unlock(&conf_lock);
+		return SLURM_ERROR;
+	}
+
+	for (s_p_options_t *op = slurm_conf_options; op->key; op++)
+		cnt++;
+
+	buffer = init_buf(BUF_SIZE);
+	packstr(SLURM_VERSION_STRING, buffer);
+	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack64(stat_buf.st_dev, buffer);
+	pack64(stat_buf.st_ino, buffer);
+	pack64(stat_buf.st_size, buffer);
+	pack_time(stat_buf.st_mtime, buffer);
+	pack32(conf_ptr->hash_val, buffer);
+	tbl_buf = s_p_pack_hashtbl(conf_hashtbl, slurm_conf_options, cnt);
+	slurm_mutex_unlock(&conf_lock);
+
+	/*
+	 * Readers may have the old file mapped, replace it atomically. The
+	 * temporary file gets a unique name in case the directory is shared.
+	 */
+	new_file = xstrdup_printf("%s.XXXXXX", file);
+	if ((fd = mkstemp(new_file)) < 0) {
+		error("%s: Can't create %s: %m", __func__, new_file);
+		xfree(new_file);
+		rc = SLURM_ERROR;
+		goto fini;
+	}
+	fd_set_close_on_exec(fd);
+	/* Commands run by any user load it */
+	if (fchmod(fd, 0644) < 0)
+		error("%s: fchmod(%s): %m", __func__, new_file);
+	safe_write(fd, get_buf_data(buffer), get_buf_offset(buffer));
+	safe_write(fd, get_buf_data(tbl_buf), get_buf_offset(tbl_buf));
+	if ((rc = fsync_and_close(fd, "slurm.conf snapshot")))
+		goto fini;
+	if (rename(new_file, file)) {
+		error("%s: Can't rename %s to %s: %m",
+		      __func__, new_file, file);
+		rc = SLURM_ERROR;
+	}
+	goto fini;
+
+rwfail:
+	error("%s: Can't write %s: %m", __func__, new_file);
+	(void) close(fd);
+	rc = SLURM_ERROR;
+fini:
+	if ((rc != SLURM_SUCCESS) && new_file)
+		(void) unlink(new_file);
+	xfree(new_file);
+	free_buf(tbl_buf);
+	free_buf(buffer);
+	return rc;
+}
+
 /* caller must lock conf_lock */
 static int _init_slurm_conf(const char *file_name)
 {
@@ -3133,7 +3615,9 @@ static int _init_slurm_conf(const char *file_name)
 
 	/* init hash to 0 */
 	conf_ptr->hash_val = 0;
-	rc = s_p_parse_file(conf_hashtbl, &conf_ptr->hash_val, name, false);
+	if (_load_conf_snapshot(name) != SLURM_SUCCESS)
+		rc = s_p_parse_file(conf_hashtbl, &conf_ptr->hash_val, name,
+				    false);
 	/* s_p_dump_values(conf_hashtbl, slurm_conf_options); */
 
 	if (_validate_and_set_defaults(conf_ptr, conf_hashtbl) == SLURM_ERROR)
@@ -374,6 +374,19 @@ extern int list_find_frontend (void *front_end_entry, void *key);
  */
 extern int slurm_conf_init(const char *file_name);
 
+/*
+ * slurm_conf_snapshot_write - save the parsed slurm configuration to a file.
+ *	slurm_conf_init() in other processes (not slurmctld, slurmd or slurmdbd)
+ *	loads it instead of parsing the configuration file, as long as the
+ *	configuration file itself has not changed. The file is found through
+ *	the SLURM_CONF_SNAPSHOT environment variable, or else as
+ *	"<configuration file>.snapshot". No snapshot is written if the
+ *	configuration uses Include, whose files are not checked when loading.
+ * IN file - name of the snapshot file to write
+ * RET SLURM_SUCCESS or SLURM_ERROR
+ */
+extern int slurm_conf_snapshot_write(const char *file);
+
 /*
  * slurm_conf_reinit - reload the slurm configuration from a file.
  * IN file_name - name of the slurm configuration file to be read
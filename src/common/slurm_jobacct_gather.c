@@ -88,7 +88,7 @@ strong_alias(jobacctinfo_destroy, slurm_jobacctinfo_destroy);
 
 typedef struct slurm_jobacct_gather_ops {
 	void (*poll_data) (List task_list, bool pgid_plugin, uint64_t cont_id,
-			   bool profile);
+			   bool profile, bool final);
 	int (*endpoll)    ();
 	int (*add_task)   (pid_t pid, jobacct_id_t *jobacct_id);
 } slurm_jobacct_gather_ops_t;
@@ -316,12 +316,13 @@ static bool _jobacct_shutdown_test(void)
 	return rc;
 }
 
-static void _poll_data(bool profile)
+static void _poll_data(bool profile, bool final)
 {
 	/* Update the data */
 	slurm_mutex_lock(&task_list_lock);
 	if (task_list)
-		(*(ops.poll_data))(task_list, pgid_plugin, cont_id, profile);
+		(*(ops.poll_data))(task_list, pgid_plugin, cont_id, profile,
+				   final);
 	slurm_mutex_unlock(&task_list_lock);
 }
 
@@ -359,7 +360,7 @@ static void *_watch_tasks(void *arg)
 
 		slurm_mutex_lock(&g_context_lock);
 		/* The initial poll is done after the last task is added */
-		_poll_data(1);
+		_poll_data(1, 0);
 		slurm_mutex_unlock(&g_context_lock);
 
 	}
@@ -692,7 +693,7 @@ extern int jobacct_gather_add_task(pid_t pid, jobacct_id_t *jobacct_id,
 	slurm_mutex_unlock(&task_list_lock);
 
 	if (poll == 1)
-		_poll_data(1);
+		_poll_data(1, 0);
 
 	return SLURM_SUCCESS;
 error:
@@ -706,7 +707,7 @@ extern jobacctinfo_t *jobacct_gather_stat_task(pid_t pid)
 	if (!plugin_polling || _jobacct_shutdown_test())
 		return NULL;
 
-	_poll_data(0);
+	_poll_data(0, 0);
 
 	if (pid) {
 		struct jobacctinfo *jobacct = NULL;
@@ -748,7 +749,7 @@ extern jobacctinfo_t *jobacct_gather_remove_task(pid_t pid)
 
 	/* poll data one last time before removing task
 	 * mainly for updating energy consumption */
-	_poll_data(1);
+	_poll_data(1, 1);
 
 	if (_jobacct_shutdown_test())
 		return NULL;
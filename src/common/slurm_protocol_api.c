@@ -72,6 +72,7 @@
 #include "src/common/slurm_protocol_pack.h"
 #include "src/common/slurm_route.h"
 #include "src/common/strlcpy.h"
+#include "src/common/timers.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 #include "src/slurmdbd/read_config.h"
@@ -895,6 +896,7 @@ extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, buf_t *buffer)
 	header_t header;
 	int rc;
 	void *auth_cred = NULL;
+	struct timeval auth_tv = { 0, 0 };
 
 	if (unpack_header(&header, buffer) == SLURM_ERROR) {
 		rc = SLURM_COMMUNICATIONS_RECEIVE_ERROR;
@@ -939,11 +941,13 @@ extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, buf_t *buffer)
 		goto total_return;
 	}
 	msg->auth_index = slurm_auth_index(auth_cred);
+	(void) slurm_delta_tv(&auth_tv);
 	if (header.flags & SLURM_GLOBAL_AUTH_KEY) {
 		rc = auth_g_verify(auth_cred, _global_auth_key());
 	} else {
 		rc = auth_g_verify(auth_cred, slurm_conf.authinfo);
 	}
+	msg->auth_time = slurm_delta_tv(&auth_tv);
 
 	if (rc != SLURM_SUCCESS) {
 		error("%s: auth_g_verify: %s has authentication error: %s",
@@ -1321,16 +1325,18 @@ static int _unpack_msg_uid(buf_t *buffer, uint16_t protocol_version)
  * IN open_fd	- file descriptor to receive msg on
  * IN/OUT msg	- a slurm_msg struct to be filled in by the function
  *		  we use the orig_addr from this var for forwarding.
+ * IN timeout	- how long to wait in milliseconds, MessageTimeout if zero
  * RET int	- returns 0 on success, -1 on failure and sets errno
  */
 int slurm_receive_msg_and_forward(int fd, slurm_addr_t *orig_addr,
-				  slurm_msg_t *msg)
+				  slurm_msg_t *msg, int timeout)
 {
 	char *buf = NULL;
 	size_t buflen = 0;
 	header_t header;
 	int rc;
 	void *auth_cred = NULL;
+	struct timeval auth_tv = { 0, 0 };
 	buf_t *buffer;
 
 	xassert(fd >= 0);
@@ -1356,8 +1362,9 @@ int slurm_receive_msg_and_forward(int fd, slurm_addr_t *orig_addr,
 	 *  length and allocate space on the heap for a buffer containing
 	 *  the message.
 	 */
-	if (slurm_msg_recvfrom_timeout(fd, &buf, &buflen, 0,
-				       (slurm_conf.msg_timeout * 1000)) < 0) {
+	if (timeout <= 0)
+		timeout = slurm_conf.msg_timeout * MSEC_IN_SEC;
+	if (slurm_msg_recvfrom_timeout(fd, &buf, &buflen, 0, timeout) < 0) {
 		forward_init(&header.forward);
 		rc = errno;
 		goto total_return;
@@ -1447,11 +1454,13 @@ int slurm_receive_msg_and_forward(int fd, slurm_addr_t *orig_addr,
 		goto total_return;
 	}
 	msg->auth_index = slurm_auth_index(auth_cred);
+	(void) slurm_delta_tv(&auth_tv);
 	if (header.flags & SLURM_GLOBAL_AUTH_KEY) {
 		rc = auth_g_verify(auth_cred, _global_auth_key());
 	} else {
 		rc = auth_g_verify(auth_cred, slurm_conf.authinfo);
 	}
+	msg->auth_time = slurm_delta_tv(&auth_tv);
 
 	if (rc != SLURM_SUCCESS) {
 		error("%s: auth_g_verify: %s has authentication error: %m",
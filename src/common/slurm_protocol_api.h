@@ -294,10 +294,11 @@ List slurm_receive_msgs(int fd, int steps, int timeout);
  *
  * IN open_fd	- file descriptor to receive msg on
  * OUT resp	- a slurm_msg struct to be filled in by the function
+ * IN timeout	- how long to wait in milliseconds, MessageTimeout if zero
  * RET int	- returns 0 on success, -1 on failure and sets errno
  */
 int slurm_receive_msg_and_forward(int fd, slurm_addr_t *orig_addr,
-				  slurm_msg_t *resp);
+				  slurm_msg_t *resp, int timeout);
 
 /**********************************************************************\
  * send message functions
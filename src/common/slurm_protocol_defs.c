@@ -1799,9 +1799,13 @@ extern void slurm_free_stats_response_msg(stats_info_response_msg_t *msg)
 {
 	int i;
 	if (msg) {
+		xfree(msg->sched_cost_job_id);
+		xfree(msg->sched_cost_tests);
+		xfree(msg->sched_cost_usec);
 		xfree(msg->rpc_type_id);
 		xfree(msg->rpc_type_cnt);
 		xfree(msg->rpc_type_time);
+		xfree(msg->rpc_type_auth_time);
 		xfree(msg->rpc_user_id);
 		xfree(msg->rpc_user_cnt);
 		xfree(msg->rpc_user_time);
@@ -4416,6 +4420,10 @@ extern void slurm_free_slurmd_status(slurmd_status_t* slurmd_status_ptr)
 		xfree(slurmd_status_ptr->slurmd_logfile);
 		xfree(slurmd_status_ptr->step_list);
 		xfree(slurmd_status_ptr->version);
+		xfree(slurmd_status_ptr->rpc_type_id);
+		xfree(slurmd_status_ptr->rpc_type_cnt);
+		xfree(slurmd_status_ptr->rpc_type_time);
+		xfree(slurmd_status_ptr->rpc_type_time_max);
 		xfree(slurmd_status_ptr);
 	}
 }
@@ -12310,7 +12310,32 @@ static void _pack_slurmd_status(slurmd_status_t *msg, buf_t *buffer,
 {
 	xassert(msg);
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		pack_time(msg->booted, buffer);
+		pack_time(msg->last_slurmctld_msg, buffer);
+
+		pack16(msg->slurmd_debug, buffer);
+		pack16(msg->actual_cpus, buffer);
+		pack16(msg->actual_boards, buffer);
+		pack16(msg->actual_sockets, buffer);
+		pack16(msg->actual_cores, buffer);
+		pack16(msg->actual_threads, buffer);
+
+		pack64(msg->actual_real_mem, buffer);
+		pack32(msg->actual_tmp_disk, buffer);
+		pack32(msg->pid, buffer);
+
+		packstr(msg->hostname, buffer);
+		packstr(msg->slurmd_logfile, buffer);
+		packstr(msg->step_list, buffer);
+		packstr(msg->version, buffer);
+
+		pack16_array(msg->rpc_type_id, msg->rpc_type_size, buffer);
+		pack32_array(msg->rpc_type_cnt, msg->rpc_type_size, buffer);
+		pack64_array(msg->rpc_type_time, msg->rpc_type_size, buffer);
+		pack32_array(msg->rpc_type_time_max, msg->rpc_type_size,
+			     buffer);
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		pack_time(msg->booted, buffer);
 		pack_time(msg->last_slurmctld_msg, buffer);
 
@@ -12342,7 +12367,43 @@ static int _unpack_slurmd_status(slurmd_status_t **msg_ptr, buf_t *buffer,
 
 	msg = xmalloc(sizeof(slurmd_status_t));
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpack_time(&msg->booted, buffer);
+		safe_unpack_time(&msg->last_slurmctld_msg, buffer);
+
+		safe_unpack16(&msg->slurmd_debug, buffer);
+		safe_unpack16(&msg->actual_cpus, buffer);
+		safe_unpack16(&msg->actual_boards, buffer);
+		safe_unpack16(&msg->actual_sockets, buffer);
+		safe_unpack16(&msg->actual_cores, buffer);
+		safe_unpack16(&msg->actual_threads, buffer);
+
+		safe_unpack64(&msg->actual_real_mem, buffer);
+		safe_unpack32(&msg->actual_tmp_disk, buffer);
+		safe_unpack32(&msg->pid, buffer);
+
+		safe_unpackstr_xmalloc(&msg->hostname,
+				       &uint32_tmp, buffer);
+		safe_unpackstr_xmalloc(&msg->slurmd_logfile,
+				       &uint32_tmp, buffer);
+		safe_unpackstr_xmalloc(&msg->step_list,
+				       &uint32_tmp, buffer);
+		safe_unpackstr_xmalloc(&msg->version,
+				       &uint32_tmp, buffer);
+
+		safe_unpack16_array(&msg->rpc_type_id, &msg->rpc_type_size,
+				    buffer);
+		safe_unpack32_array(&msg->rpc_type_cnt, &uint32_tmp, buffer);
+		if (uint32_tmp != msg->rpc_type_size)
+			goto unpack_error;
+		safe_unpack64_array(&msg->rpc_type_time, &uint32_tmp, buffer);
+		if (uint32_tmp != msg->rpc_type_size)
+			goto unpack_error;
+		safe_unpack32_array(&msg->rpc_type_time_max, &uint32_tmp,
+				    buffer);
+		if (uint32_tmp != msg->rpc_type_size)
+			goto unpack_error;
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack_time(&msg->booted, buffer);
 		safe_unpack_time(&msg->last_slurmctld_msg, buffer);
 
@@ -12716,7 +12777,100 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 	msg = xmalloc ( sizeof (stats_info_response_msg_t) );
 	*msg_ptr = msg ;
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpack32(&msg->parts_packed,	buffer);
+		if (msg->parts_packed) {
+			safe_unpack_time(&msg->req_time,	buffer);
+			safe_unpack_time(&msg->req_time_start,	buffer);
+			safe_unpack32(&msg->server_thread_count,buffer);
+			safe_unpack32(&msg->agent_queue_size,	buffer);
+			safe_unpack32(&msg->agent_count,	buffer);
+			safe_unpack32(&msg->agent_thread_count,	buffer);
+			safe_unpack32(&msg->dbd_agent_queue_size, buffer);
+			safe_unpack32(&msg->gettimeofday_latency, buffer);
+			safe_unpack32(&msg->jobs_submitted,	buffer);
+			safe_unpack32(&msg->jobs_started,	buffer);
+			safe_unpack32(&msg->jobs_completed,	buffer);
+			safe_unpack32(&msg->jobs_canceled,	buffer);
+			safe_unpack32(&msg->jobs_failed,	buffer);
+
+			safe_unpack32(&msg->jobs_pending,	buffer);
+			safe_unpack32(&msg->jobs_running,	buffer);
+			safe_unpack_time(&msg->job_states_ts,	buffer);
+
+			safe_unpack32(&msg->schedule_cycle_max,	buffer);
+			safe_unpack32(&msg->schedule_cycle_last,buffer);
+			safe_unpack32(&msg->schedule_cycle_sum,	buffer);
+			safe_unpack32(&msg->schedule_cycle_counter, buffer);
+			safe_unpack32(&msg->schedule_cycle_depth, buffer);
+			safe_unpack32(&msg->schedule_queue_len,	buffer);
+
+			safe_unpack32(&msg->bf_backfilled_jobs,	buffer);
+			safe_unpack32(&msg->bf_last_backfilled_jobs, buffer);
+			safe_unpack32(&msg->bf_cycle_counter,	buffer);
+			safe_unpack64(&msg->bf_cycle_sum,	buffer);
+			safe_unpack32(&msg->bf_cycle_last,	buffer);
+			safe_unpack32(&msg->bf_last_depth,	buffer);
+			safe_unpack32(&msg->bf_last_depth_try,	buffer);
+
+			safe_unpack32(&msg->bf_queue_len,	buffer);
+			safe_unpack32(&msg->bf_cycle_max,	buffer);
+			safe_unpack_time(&msg->bf_when_last_cycle, buffer);
+			safe_unpack32(&msg->bf_depth_sum,	buffer);
+			safe_unpack32(&msg->bf_depth_try_sum,	buffer);
+			safe_unpack32(&msg->bf_queue_len_sum,	buffer);
+			safe_unpack32(&msg->bf_table_size,	buffer);
+			safe_unpack32(&msg->bf_table_size_sum,	buffer);
+
+			safe_unpack32(&msg->bf_active,		buffer);
+			safe_unpack32(&msg->bf_backfilled_het_jobs, buffer);
+
+			safe_unpack32(&msg->node_reg_cnt,	buffer);
+			safe_unpack32(&msg->node_reg_time_max,	buffer);
+			safe_unpack64(&msg->node_reg_time_sum,	buffer);
+
+			safe_unpack64(&msg->acct_policy_cnt,	buffer);
+			safe_unpack32(&msg->acct_policy_time_max, buffer);
+			safe_unpack64(&msg->acct_policy_time_sum, buffer);
+
+			safe_unpack32(&msg->sched_cost_cnt,	buffer);
+			safe_unpack32_array(&msg->sched_cost_job_id,
+					    &uint32_tmp, buffer);
+			safe_unpack32_array(&msg->sched_cost_tests,
+					    &uint32_tmp, buffer);
+			safe_unpack64_array(&msg->sched_cost_usec,
+					    &uint32_tmp, buffer);
+		}
+
+		safe_unpack32(&msg->rpc_type_size,		buffer);
+		safe_unpack16_array(&msg->rpc_type_id,   &uint32_tmp, buffer);
+		safe_unpack32_array(&msg->rpc_type_cnt,  &uint32_tmp, buffer);
+		safe_unpack64_array(&msg->rpc_type_time, &uint32_tmp, buffer);
+		safe_unpack64_array(&msg->rpc_type_auth_time, &uint32_tmp,
+				    buffer);
+
+		safe_unpack32(&msg->rpc_user_size,		buffer);
+		safe_unpack32_array(&msg->rpc_user_id,   &uint32_tmp, buffer);
+		safe_unpack32_array(&msg->rpc_user_cnt,  &uint32_tmp, buffer);
+		safe_unpack64_array(&msg->rpc_user_time, &uint32_tmp, buffer);
+
+		safe_unpack32_array(&msg->rpc_queue_type_id,
+				    &msg->rpc_queue_type_count,
+				    buffer);
+		safe_unpack32_array(&msg->rpc_queue_count,
+				    &uint32_tmp, buffer);
+		if (uint32_tmp != msg->rpc_queue_type_count)
+			goto unpack_error;
+
+		safe_unpack32_array(&msg->rpc_dump_types,
+				    &msg->rpc_dump_count,
+				    buffer);
+		safe_unpackstr_array(&msg->rpc_dump_hostlist,
+				     &uint32_tmp,
+				     buffer);
+		if (uint32_tmp != msg->rpc_dump_count)
+			goto unpack_error;
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack32(&msg->parts_packed,	buffer);
 		if (msg->parts_packed) {
 			safe_unpack_time(&msg->req_time,	buffer);
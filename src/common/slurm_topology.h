@@ -59,6 +59,8 @@ typedef struct {
 	char *switches;			/* name of direct descendant switches */
 	uint32_t *switches_dist;
 	uint16_t *switch_index;		/* indexes of child switches */
+	bool disjoint_children;		/* no node is under more than one of
+					 * the child switches */
 } switch_record_t;
 
 extern switch_record_t *switch_record_table;  /* ptr to switch records */
@@ -83,6 +83,8 @@
 #define	bit_ffs			slurm_bit_ffs
 #define	bit_free		slurm_bit_free
 #define	bit_realloc		slurm_bit_realloc
+#define	bit_init		slurm_bit_init
+#define	bit_alloc_count		slurm_bit_alloc_count
 #define	bit_size		slurm_bit_size
 #define	bit_and			slurm_bit_and
 #define	bit_not			slurm_bit_not
@@ -114,6 +116,8 @@
 #define bit_copybits		slurm_bit_copybits
 #define	bit_get_bit_num		slurm_bit_get_bit_num
 #define	bit_get_pos_num		slurm_bit_get_pos_num
+#define	bit_kernels_name	slurm_bit_kernels_name
+#define	bit_kernels_select	slurm_bit_kernels_select
 
 /* fd.[ch] functions */
 #define closeall		slurm_closeall
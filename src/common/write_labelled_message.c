@@ -51,7 +51,7 @@
 static char *_build_label(int task_id, int task_id_width,
 			  uint32_t het_job_offset,
 			  uint32_t het_job_task_offset);
-static int _write_line(int fd, char *prefix, char *suffix, void *buf, int len);
+static int _write_buf(int fd, void *buf, int len);
 
 /*
  * fd             is the file descriptor to write to
@@ -78,48 +78,54 @@ extern int write_labelled_message(int fd, void *buf, int len, int task_id,
 				  bool label, int task_id_width)
 {
 	void *start, *end;
-	char *prefix = NULL, *suffix = NULL;
-	int remaining = len;
-	int written = 0;
-	int line_len;
-	int rc = -1;
-
-	if (label) {
-		prefix = _build_label(task_id, task_id_width, het_job_offset,
-				      het_job_task_offset);
+	char *prefix, *out, *ptr;
+	int pre, lines = 0, line_len, remaining = len;
+	int rc;
+
+	if (len <= 0)
+		return -1;
+
+	if (!label)
+		return _write_buf(fd, buf, len);
+
+	/*
+	 * Label all the lines into a single buffer to write the whole
+	 * message at once rather than issuing a write() per line.
+	 */
+	for (start = buf; (end = memchr(start, '\n', remaining)); lines++) {
+		remaining -= (end - start) + 1;
+		start = end + 1;
 	}
+	if (remaining)
+		lines++;
 
-	while (remaining > 0) {
-		start = buf + written;
-		end = memchr(start, '\n', remaining);
-		if (end == NULL) { /* no newline found */
-			if (label)
-				suffix = "\n";
-			rc = _write_line(fd, prefix, suffix, start, remaining);
-			if (rc <= 0) {
-				goto done;
-			} else {
-				remaining -= rc;
-				written += rc;
-			}
-		} else {
-			line_len = (int)(end - start) + 1;
-			rc = _write_line(fd, prefix, suffix, start, line_len);
-			if (rc <= 0) {
-				goto done;
-			} else {
-				remaining -= rc;
-				written += rc;
-			}
-		}
+	prefix = _build_label(task_id, task_id_width, het_job_offset,
+			      het_job_task_offset);
+	pre = strlen(prefix);
+	ptr = out = xmalloc((pre * lines) + len + 1);
 
+	for (start = buf, remaining = len; remaining > 0;) {
+		if ((end = memchr(start, '\n', remaining)))
+			line_len = (int)(end - start) + 1;
+		else
+			line_len = remaining;
+		memcpy(ptr, prefix, pre);
+		ptr += pre;
+		memcpy(ptr, start, line_len);
+		ptr += line_len;
+		start += line_len;
+		remaining -= line_len;
 	}
-done:
+	/* Terminate a partial line */
+	if (*(ptr - 1) != '\n')
+		*ptr++ = '\n';
+
+	if ((rc = _write_buf(fd, out, (ptr - out))) >= 0)
+		rc = len;
+	xfree(out);
 	xfree(prefix);
-	if (written > 0)
-		return written;
-	else
-		return rc;
+
+	return rc;
 }
 
 /*
@@ -149,32 +155,14 @@ static char *_build_label(int task_id, int task_id_width,
 /*
  * Blocks until write is complete, regardless of the file descriptor being in
  * non-blocking mode.
- * I/O from multiple hetjob components may be present, so add prefix/suffix to
- * buffer before issuing write to avoid interleaved output from multiple
- * components.
+ * I/O from multiple hetjob components may be present, so the labelled lines
+ * of a message are written with a single write() call to avoid interleaved
+ * output from multiple components.
  */
-static int _write_line(int fd, char *prefix, char *suffix, void *buf, int len)
+static int _write_buf(int fd, void *buf, int len)
 {
-	int left, n, pre = 0, post = 0;
-	void *ptr, *tmp = NULL;
-
-	if (prefix || suffix) {
-		if (prefix)
-			pre = strlen(prefix);
-		if (suffix)
-			post = strlen(suffix);
-		tmp = xmalloc(pre + len + post);
-		if (prefix)
-			memcpy(tmp, prefix, pre);
-		memcpy(tmp + pre, buf, len);
-		if (suffix)
-			memcpy(tmp + pre + len, suffix, post);
-		ptr = tmp;
-		left = pre + len + post;
-	} else {
-		ptr = buf;
-		left = len;
-	}
+	int left = len, n;
+	void *ptr = buf;
 
 	while (left > 0) {
 	again:
@@ -182,7 +170,7 @@ static int _write_line(int fd, char *prefix, char *suffix, void *buf, int len)
 			if (errno == EINTR)
 				goto again;
 			if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
-				debug3("  got EAGAIN in _write_line");
+				debug3("  got EAGAIN in _write_buf");
 				goto again;
 			}
 			len = -1;
@@ -191,7 +179,6 @@ static int _write_line(int fd, char *prefix, char *suffix, void *buf, int len)
 		left -= n;
 		ptr += n;
 	}
-	xfree(tmp);
 
 	return len;
 }
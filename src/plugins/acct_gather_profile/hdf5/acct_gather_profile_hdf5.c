@@ -64,11 +64,12 @@
 #include "src/slurmd/common/proctrack.h"
 #include "hdf5_api.h"
 
+/* Default number of records per chunk, see ProfileHDF5ChunkSize */
 #define HDF5_CHUNK_SIZE 10
 /* Compression level, a value of 0 through 9. Level 0 is faster but offers the
  * least compression; level 9 is slower but offers maximum compression.
- * A setting of -1 indicates that no compression is desired. */
-/* TODO: Make this configurable with a parameter */
+ * A setting of -1 indicates that no compression is desired.
+ * Default for ProfileHDF5Compress. */
 #define HDF5_COMPRESS 0
 
 /*
@@ -101,13 +102,18 @@ const char plugin_type[] = "acct_gather_profile/hdf5";
 const uint32_t plugin_version = SLURM_VERSION_NUMBER;
 
 typedef struct {
+	uint32_t chunk_size;
+	int compress;
 	char *dir;
 	uint32_t def;
+	uint32_t flush_interval;
 } slurm_hdf5_conf_t;
 
 typedef struct {
 	hid_t  table_id;
 	size_t type_size;
+	uint8_t *buf;		/* records not appended yet */
+	size_t buf_cnt;
 } table_t;
 
 // Global HDF5 Variables
@@ -131,11 +137,45 @@ static size_t groups_len = 0;
 static table_t *tables = NULL;
 static size_t   tables_max_len = 0;
 static size_t   tables_cur_len = 0;
+static time_t   last_flush = 0;
 
 static void _reset_slurm_profile_conf(void)
 {
 	xfree(hdf5_conf.dir);
 	hdf5_conf.def = ACCT_GATHER_PROFILE_NONE;
+	hdf5_conf.chunk_size = HDF5_CHUNK_SIZE;
+	hdf5_conf.compress = HDF5_COMPRESS;
+	hdf5_conf.flush_interval = 0;
+}
+
+/* Append the buffered records of a table with a single H5PTappend() */
+static int _flush_table(table_t *ds)
+{
+	int rc = SLURM_SUCCESS;
+
+	if (!ds->buf_cnt)
+		return rc;
+
+	if (H5PTappend(ds->table_id, ds->buf_cnt, ds->buf) < 0) {
+		error("PROFILE: Impossible to add %zu records to table %"PRId64,
+		      ds->buf_cnt, (int64_t) ds->table_id);
+		rc = SLURM_ERROR;
+	}
+	ds->buf_cnt = 0;
+
+	return rc;
+}
+
+static void _flush_tables(void)
+{
+	size_t i;
+
+	for (i = 0; i < tables_cur_len; ++i)
+		(void) _flush_table(&tables[i]);
+
+	if (file_id > 0)
+		H5Fflush(file_id, H5F_SCOPE_LOCAL);
+	last_flush = time(NULL);
 }
 
 static uint32_t _determine_profile(void)
@@ -209,8 +249,11 @@ extern void acct_gather_profile_p_conf_options(s_p_options_t **full_options,
 					       int *full_options_cnt)
 {
 	s_p_options_t options[] = {
+		{"ProfileHDF5ChunkSize", S_P_UINT32},
+		{"ProfileHDF5Compress", S_P_STRING},
 		{"ProfileHDF5Dir", S_P_STRING},
 		{"ProfileHDF5Default", S_P_STRING},
+		{"ProfileHDF5FlushInterval", S_P_UINT32},
 		{NULL} };
 
 	transfer_s_p_options(full_options, options, full_options_cnt);
@@ -233,6 +276,27 @@ extern void acct_gather_profile_p_conf_set(s_p_hashtbl_t *tbl)
 			}
 			xfree(tmp);
 		}
+
+		if (s_p_get_uint32(&hdf5_conf.chunk_size,
+				   "ProfileHDF5ChunkSize", tbl) &&
+		    !hdf5_conf.chunk_size)
+			fatal("ProfileHDF5ChunkSize must be greater than 0");
+
+		if (s_p_get_string(&tmp, "ProfileHDF5Compress", tbl)) {
+			char *end = NULL;
+
+			if (!xstrcasecmp(tmp, "none"))
+				hdf5_conf.compress = -1;
+			else if (((hdf5_conf.compress =
+				   strtol(tmp, &end, 10)) < 0) ||
+				 (hdf5_conf.compress > 9) || (end && *end))
+				fatal("ProfileHDF5Compress can not be set to %s, please specify none or a level between 0 and 9",
+				      tmp);
+			xfree(tmp);
+		}
+
+		s_p_get_uint32(&hdf5_conf.flush_interval,
+			       "ProfileHDF5FlushInterval", tbl);
 	}
 
 	if (!hdf5_conf.dir)
@@ -383,9 +447,12 @@ extern int acct_gather_profile_p_node_step_end(void)
 
 	log_flag(PROFILE, "PROFILE: node_step_end (shutdown)");
 
+	_flush_tables();
+
 	/* close tables */
 	for (i = 0; i < tables_cur_len; ++i) {
 		H5PTclose(tables[i].table_id);
+		xfree(tables[i].buf);
 	}
 	/* close groups */
 	for (i = 0; i < groups_len; ++i) {
@@ -521,8 +588,8 @@ extern int acct_gather_profile_p_create_dataset(
 	/* create the table */
 	if (parent < 0)
 		parent = gid_node; /* default parent is the node group */
-	table_id = H5PTcreate_fl(parent, name, dtype_id, HDF5_CHUNK_SIZE,
-	                         HDF5_COMPRESS);
+	table_id = H5PTcreate_fl(parent, name, dtype_id, hdf5_conf.chunk_size,
+				 hdf5_conf.compress);
 	if (table_id < 0) {
 		error("PROFILE: Impossible to create the table %s", name);
 		H5Tclose(dtype_id);
@@ -541,6 +608,11 @@ extern int acct_gather_profile_p_create_dataset(
 	/* reserve a new table */
 	tables[tables_cur_len].table_id  = table_id;
 	tables[tables_cur_len].type_size = type_size;
+	tables[tables_cur_len].buf = NULL;
+	tables[tables_cur_len].buf_cnt = 0;
+	if (hdf5_conf.flush_interval)
+		tables[tables_cur_len].buf =
+			xcalloc(hdf5_conf.chunk_size, type_size);
 	++tables_cur_len;
 
 	return tables_cur_len - 1;
@@ -549,8 +621,8 @@ extern int acct_gather_profile_p_create_dataset(
 extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 						 time_t sample_time)
 {
-	table_t *ds = &tables[table_id];
-	uint8_t send_data[ds->type_size];
+	table_t *ds;
+	uint8_t *send_data;
 	int header_size = 0;
 	debug("acct_gather_profile_p_add_sample_data %d", table_id);
 
@@ -564,6 +636,7 @@ extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 		      table_id);
 		return SLURM_ERROR;
 	}
+	ds = &tables[table_id];
 
 	/* ensure that we have to record something */
 	xassert(running_in_slurmstepd());
@@ -573,6 +646,15 @@ extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 	if (g_profile_running <= ACCT_GATHER_PROFILE_NONE)
 		return SLURM_ERROR;
 
+	/*
+	 * With ProfileHDF5FlushInterval the records are built directly in the
+	 * table buffer and appended a whole chunk at a time.
+	 */
+	if (ds->buf)
+		send_data = ds->buf + (ds->buf_cnt * ds->type_size);
+	else
+		send_data = xmalloc(ds->type_size);
+
 	/* prepend timestampe and relative time */
 	((uint64_t *)send_data)[0] = difftime(sample_time, step_start_time);
 	header_size += sizeof(uint64_t);
@@ -581,12 +663,27 @@ extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 
 	memcpy(send_data + header_size, data, ds->type_size - header_size);
 
+	if (ds->buf) {
+		int rc = SLURM_SUCCESS;
+
+		if (++ds->buf_cnt == hdf5_conf.chunk_size)
+			rc = _flush_table(ds);
+		if (!last_flush)
+			last_flush = time(NULL);
+		else if ((time(NULL) - last_flush) >=
+			 hdf5_conf.flush_interval)
+			_flush_tables();
+		return rc;
+	}
+
 	/* append the record to the table */
 	if (H5PTappend(ds->table_id, 1, send_data) < 0) {
 		error("PROFILE: Impossible to add data to the table %d; "
 		      "maybe the table has not been created?", table_id);
+		xfree(send_data);
 		return SLURM_ERROR;
 	}
+	xfree(send_data);
 
 	return SLURM_SUCCESS;
 }
@@ -597,6 +694,19 @@ extern void acct_gather_profile_p_conf_values(List *data)
 
 	xassert(*data);
 
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("ProfileHDF5ChunkSize");
+	key_pair->value = xstrdup_printf("%u", hdf5_conf.chunk_size);
+	list_append(*data, key_pair);
+
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("ProfileHDF5Compress");
+	if (hdf5_conf.compress < 0)
+		key_pair->value = xstrdup("none");
+	else
+		key_pair->value = xstrdup_printf("%d", hdf5_conf.compress);
+	list_append(*data, key_pair);
+
 	key_pair = xmalloc(sizeof(config_key_pair_t));
 	key_pair->name = xstrdup("ProfileHDF5Dir");
 	key_pair->value = xstrdup(hdf5_conf.dir);
@@ -607,6 +717,11 @@ extern void acct_gather_profile_p_conf_values(List *data)
 	key_pair->value = xstrdup(acct_gather_profile_to_string(hdf5_conf.def));
 	list_append(*data, key_pair);
 
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("ProfileHDF5FlushInterval");
+	key_pair->value = xstrdup_printf("%u", hdf5_conf.flush_interval);
+	list_append(*data, key_pair);
+
 	return;
 
 }
@@ -55,6 +55,7 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/wait.h>
 
 #include "src/common/uid.h"
 #include "src/common/read_config.h"
@@ -184,6 +185,8 @@ static void _help_msg(void)
 	       " -o, --output         Path to a file into which to write.\n"
 	       "                      Default for merge is ./job_$jobid.h5\n"
 	       "                      Default for extract is ./extract_$jobid.csv\n"
+	       " -P, --parallel       Number of processes used to merge node-step files\n"
+	       "                      (default 1)\n"
 	       " -p, --profiledir     Profile directory location where node-step files exist\n"
 	       "		               default is what is set in acct_gather.conf\n"
 	       " -S, --savefiles      Don't remove node-step files after merging them \n"
@@ -326,6 +329,7 @@ static void _init_opts(void)
 	memset(&params, 0, sizeof(sh5util_opts_t));
 	params.job_id = -1;
 	params.mode = SH5UTIL_MODE_MERGE;
+	params.parallel = 1;
 	params.step_id = -1;
 }
 
@@ -348,6 +352,7 @@ static int _set_options(const int argc, char **argv)
 		{"list", no_argument, 0, 'L'},
 		{"node", required_argument, 0, 'N'},
 		{"output", required_argument, 0, 'o'},
+		{"parallel", required_argument, 0, 'P'},
 		{"profiledir", required_argument, 0, 'p'},
 		{"series", required_argument, 0, 's'},
 		{"savefiles", no_argument, 0, 'S'},
@@ -370,7 +375,7 @@ static int _set_options(const int argc, char **argv)
 
 	_init_opts();
 
-	while ((cc = getopt_long(argc, argv, "d:Ehi:Ij:l:LN:o:p:s:Su:UvV",
+	while ((cc = getopt_long(argc, argv, "d:Ehi:Ij:l:LN:o:P:p:s:Su:UvV",
 	                         long_options, &option_index)) != EOF) {
 		switch (cc) {
 		case 'd':
@@ -409,6 +414,14 @@ static int _set_options(const int argc, char **argv)
 		case 'o':
 			params.output = xstrdup(optarg);
 			break;
+		case 'P':
+			params.parallel = strtol(optarg, &next_str, 10);
+			if ((params.parallel < 1) || (next_str[0] != '\0')) {
+				error("Bad value for --parallel=\"%s\"",
+				      optarg);
+				return -1;
+			}
+			break;
 		case 'p':
 			params.dir = xstrdup(optarg);
 			break;
@@ -555,7 +568,7 @@ static int _merge_node_step_data(char* file_name, hid_t jgid_nodes,
 		goto endit;
 	}
 
-	if (!params.keepfiles &&
+	if (!params.keepfiles && (params.parallel == 1) &&
 	    (remove(file_name) == -1))
 		error("%s: remove(%s): %m", __func__, file_name);
 
@@ -566,98 +579,26 @@ endit:
 	return rc;
 }
 
-/* Look for step and node files and merge them together into one job file */
-static int _merge_step_files(void)
+/* Merge the node-step files of file_list, sorted by step, into output */
+static int _merge_file_list(List file_list, char *step_dir, char *output)
 {
 	hid_t fid_job = -1;
 	hid_t jgid_steps = -1;
 	hid_t jgid_step = -1;
 	hid_t jgid_nodes = -1;
-	DIR *dir;
-	struct  dirent *de;
-
-	char *file_name = NULL;
 	char *jgrp_nodes_name = NULL;
 	char *jgrp_step_name = NULL;
-	char *pos_char = NULL;
-	char *step_dir = NULL;
 	char *step_path = NULL;
-	char *stepno = NULL;
-	int node_cnt = -1;
+	int node_cnt = 0;
 	int last_step = -1, step_cnt = 0;
-	int job_id;
 	int rc = SLURM_SUCCESS;
 	ListIterator itr;
-	List file_list = NULL;
 	sh5util_file_t *sh5util_file = NULL;
 
-	step_dir = xstrdup_printf("%s/%s", params.dir, params.user);
-
-	if (!(dir = opendir(step_dir))) {
-		error("Cannot open %s job profile directory: %m",
-		      step_dir);
-		rc = -1;
-		goto endit;
-	}
-
-	while ((de = readdir(dir))) {
-		xfree(file_name);
-		file_name = xstrdup(de->d_name);
-
-		if (file_name[0] == '.')
-			continue;
-
-		pos_char = strstr(file_name, ".h5");
-		if (!pos_char)
-			continue;
-		*pos_char = 0;
-
-		pos_char = strchr(file_name, '_');
-		if (!pos_char)
-			continue;
-		*pos_char = 0;
-
-		job_id = strtol(file_name, NULL, 10);
-		if (job_id != params.job_id)
-			continue;
-
-		stepno = pos_char + 1;
-		pos_char = strchr(stepno, '_');
-		if (!pos_char) {
-			continue;
-		}
-		*pos_char = 0;
-
-		if (!file_list)
-			file_list = list_create(_destroy_sh5util_file);
-
-		sh5util_file = xmalloc(sizeof(sh5util_file_t));
-		list_append(file_list, sh5util_file);
-
-		sh5util_file->file_name = xstrdup(de->d_name);
-		sh5util_file->job_id = job_id;
-
-		if (!xstrcmp(stepno, "batch"))
-			sh5util_file->step_id = -2;
-		else
-			sh5util_file->step_id = strtol(stepno, NULL, 10);
-
-		stepno = pos_char + 1;
-		sh5util_file->node_name = xstrdup(stepno);
-	}
-	closedir(dir);
-
-	if (!file_list || !list_count(file_list)) {
-		info("No node-step files found for jobid %d", params.job_id);
-		goto endit;
-	}
-
-	fid_job = H5Fcreate(
-		params.output, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	fid_job = H5Fcreate(output, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
 	if (fid_job < 0) {
-		error("Failed create HDF5 file %s", params.output);
-		rc = -1;
-		goto endit;
+		error("Failed create HDF5 file %s", output);
+		return -1;
 	}
 
 	jgid_steps = make_group(fid_job, GRP_STEPS);
@@ -668,10 +609,6 @@ static int _merge_step_files(void)
 		goto endit;
 	}
 
-	/* sort the files so they are in step order */
-	list_sort(file_list, (ListCmpF) _sh5util_sort_files_dec);
-
-	node_cnt = 0;
 	itr = list_iterator_create(file_list);
 	while ((sh5util_file = list_next(itr))) {
 		//info("got file of %s", sh5util_file->file_name);
@@ -733,14 +670,11 @@ static int _merge_step_files(void)
 	}
 	list_iterator_destroy(itr);
 
+	if (jgid_step > 0)
+		put_int_attribute(jgid_step, ATTR_NNODES, node_cnt);
 	put_int_attribute(fid_job, ATTR_NSTEPS, step_cnt);
 
-
 endit:
-	FREE_NULL_LIST(file_list);
-	xfree(file_name);
-	xfree(step_dir);
-
 	if (jgid_steps != -1)
 		H5Gclose(jgid_steps);
 	if (jgid_step != -1)
@@ -753,6 +687,293 @@ endit:
 	return rc;
 }
 
+static herr_t _copy_partial_node(hid_t g_id, const char *name,
+				 const H5L_info_t *link_info, void *op_data)
+{
+	hid_t jgid_nodes = *(hid_t *) op_data;
+
+	if (H5Ocopy(g_id, name, jgid_nodes, name, H5P_DEFAULT,
+		    H5P_DEFAULT) < 0) {
+		error("Failed to copy node %s into the job file", name);
+		return -1;
+	}
+
+	return 0;
+}
+
+static herr_t _copy_partial_step(hid_t g_id, const char *name,
+				 const H5L_info_t *link_info, void *op_data)
+{
+	hid_t jgid_steps = *(hid_t *) op_data;
+	hid_t jgid_step, jgid_nodes, gid_step, gid_nodes;
+	herr_t err;
+
+	/* The same step may have been merged by several workers */
+	if ((jgid_step = make_group(jgid_steps, name)) < 0) {
+		error("Failed to create /%s/%s", GRP_STEPS, name);
+		return -1;
+	}
+	jgid_nodes = make_group(jgid_step, GRP_NODES);
+	H5Gclose(jgid_step);
+	if (jgid_nodes < 0) {
+		error("Failed to create /%s/%s/%s", GRP_STEPS, name,
+		      GRP_NODES);
+		return -1;
+	}
+
+	if ((gid_step = get_group(g_id, name)) < 0) {
+		H5Gclose(jgid_nodes);
+		return 0;
+	}
+	gid_nodes = get_group(gid_step, GRP_NODES);
+	H5Gclose(gid_step);
+	if (gid_nodes < 0) {
+		H5Gclose(jgid_nodes);
+		return 0;
+	}
+	err = H5Literate(gid_nodes, H5_INDEX_NAME, H5_ITER_INC, NULL,
+			 _copy_partial_node, &jgid_nodes);
+	H5Gclose(gid_nodes);
+	H5Gclose(jgid_nodes);
+
+	return err;
+}
+
+static herr_t _count_step_nodes(hid_t g_id, const char *name,
+				const H5L_info_t *link_info, void *op_data)
+{
+	hid_t jgid_step, jgid_nodes;
+	H5G_info_t group_info;
+
+	if ((jgid_step = get_group(g_id, name)) < 0)
+		return 0;
+	if ((jgid_nodes = get_group(jgid_step, GRP_NODES)) >= 0) {
+		if (H5Gget_info(jgid_nodes, &group_info) >= 0)
+			put_int_attribute(jgid_step, ATTR_NNODES,
+					  group_info.nlinks);
+		H5Gclose(jgid_nodes);
+	}
+	H5Gclose(jgid_step);
+
+	return 0;
+}
+
+/*
+ * Merge the node-step files with params.parallel processes. Each worker
+ * merges a slice of the files into a partial job file, so the opening and
+ * reading of the many small node-step files on the shared file system
+ * happens in parallel. The partial files are then copied into the job file.
+ * HDF5 is not thread safe, hence processes rather than threads.
+ */
+static int _merge_parallel(List file_list, char *step_dir)
+{
+	int nworkers = MIN(params.parallel, list_count(file_list));
+	int per_worker = (list_count(file_list) + nworkers - 1) / nworkers;
+	List *lists = xcalloc(nworkers, sizeof(List));
+	char **outputs = xcalloc(nworkers, sizeof(char *));
+	pid_t *pids = xcalloc(nworkers, sizeof(pid_t));
+	hid_t fid_job = -1, jgid_steps = -1, fid_part;
+	H5G_info_t group_info;
+	sh5util_file_t *sh5util_file;
+	ListIterator itr;
+	int i = 0, n = 0, status, rc = SLURM_SUCCESS;
+
+	itr = list_iterator_create(file_list);
+	while ((sh5util_file = list_next(itr))) {
+		if (!lists[i])
+			lists[i] = list_create(NULL);
+		list_append(lists[i], sh5util_file);
+		if (++n == per_worker) {
+			n = 0;
+			i++;
+		}
+	}
+	list_iterator_destroy(itr);
+
+	for (i = 0; i < nworkers; i++) {
+		if (!lists[i])
+			continue;
+		outputs[i] = xstrdup_printf("%s.part%d", params.output, i);
+		if ((pids[i] = fork()) < 0) {
+			error("%s: fork: %m", __func__);
+			rc = -1;
+			break;
+		} else if (pids[i] == 0) {
+			_exit(_merge_file_list(lists[i], step_dir, outputs[i]) ?
+			      1 : 0);
+		}
+	}
+	for (i = 0; i < nworkers; i++) {
+		if (pids[i] <= 0)
+			continue;
+		if ((waitpid(pids[i], &status, 0) < 0) ||
+		    !WIFEXITED(status) || WEXITSTATUS(status)) {
+			error("Failed to merge the node-step files into %s",
+			      outputs[i]);
+			rc = -1;
+		}
+	}
+	if (rc != SLURM_SUCCESS)
+		goto endit;
+
+	fid_job = H5Fcreate(params.output, H5F_ACC_TRUNC, H5P_DEFAULT,
+			    H5P_DEFAULT);
+	if (fid_job < 0) {
+		error("Failed create HDF5 file %s", params.output);
+		rc = -1;
+		goto endit;
+	}
+	if ((jgid_steps = make_group(fid_job, GRP_STEPS)) < 0) {
+		error("Failed to create group %s", GRP_STEPS);
+		rc = -1;
+		goto endit;
+	}
+
+	for (i = 0; (i < nworkers) && outputs[i]; i++) {
+		if ((fid_part = H5Fopen(outputs[i], H5F_ACC_RDONLY,
+					H5P_DEFAULT)) < 0) {
+			error("Failed to open %s", outputs[i]);
+			rc = -1;
+			goto endit;
+		}
+		if (H5Literate_by_name(fid_part, GRP_STEPS, H5_INDEX_NAME,
+				       H5_ITER_INC, NULL, _copy_partial_step,
+				       &jgid_steps, H5P_DEFAULT) < 0)
+			rc = -1;
+		H5Fclose(fid_part);
+		if (rc != SLURM_SUCCESS)
+			goto endit;
+	}
+
+	H5Literate(jgid_steps, H5_INDEX_NAME, H5_ITER_INC, NULL,
+		   _count_step_nodes, NULL);
+	if (H5Gget_info(jgid_steps, &group_info) >= 0)
+		put_int_attribute(fid_job, ATTR_NSTEPS, group_info.nlinks);
+
+	if (!params.keepfiles) {
+		itr = list_iterator_create(file_list);
+		while ((sh5util_file = list_next(itr))) {
+			char *step_path = xstrdup_printf(
+				"%s/%s", step_dir, sh5util_file->file_name);
+			if (remove(step_path) == -1)
+				error("%s: remove(%s): %m",
+				      __func__, step_path);
+			xfree(step_path);
+		}
+		list_iterator_destroy(itr);
+	}
+
+endit:
+	if (jgid_steps != -1)
+		H5Gclose(jgid_steps);
+	if (fid_job != -1)
+		H5Fclose(fid_job);
+	for (i = 0; i < nworkers; i++) {
+		if (outputs[i] && (remove(outputs[i]) == -1) &&
+		    (errno != ENOENT))
+			error("%s: remove(%s): %m", __func__, outputs[i]);
+		xfree(outputs[i]);
+		FREE_NULL_LIST(lists[i]);
+	}
+	xfree(outputs);
+	xfree(lists);
+	xfree(pids);
+
+	return rc;
+}
+
+/* Look for step and node files and merge them together into one job file */
+static int _merge_step_files(void)
+{
+	DIR *dir;
+	struct  dirent *de;
+
+	char *file_name = NULL;
+	char *pos_char = NULL;
+	char *step_dir = NULL;
+	char *stepno = NULL;
+	int job_id;
+	int rc = SLURM_SUCCESS;
+	List file_list = NULL;
+	sh5util_file_t *sh5util_file = NULL;
+
+	step_dir = xstrdup_printf("%s/%s", params.dir, params.user);
+
+	if (!(dir = opendir(step_dir))) {
+		error("Cannot open %s job profile directory: %m",
+		      step_dir);
+		rc = -1;
+		goto endit;
+	}
+
+	while ((de = readdir(dir))) {
+		xfree(file_name);
+		file_name = xstrdup(de->d_name);
+
+		if (file_name[0] == '.')
+			continue;
+
+		pos_char = strstr(file_name, ".h5");
+		if (!pos_char)
+			continue;
+		*pos_char = 0;
+
+		pos_char = strchr(file_name, '_');
+		if (!pos_char)
+			continue;
+		*pos_char = 0;
+
+		job_id = strtol(file_name, NULL, 10);
+		if (job_id != params.job_id)
+			continue;
+
+		stepno = pos_char + 1;
+		pos_char = strchr(stepno, '_');
+		if (!pos_char) {
+			continue;
+		}
+		*pos_char = 0;
+
+		if (!file_list)
+			file_list = list_create(_destroy_sh5util_file);
+
+		sh5util_file = xmalloc(sizeof(sh5util_file_t));
+		list_append(file_list, sh5util_file);
+
+		sh5util_file->file_name = xstrdup(de->d_name);
+		sh5util_file->job_id = job_id;
+
+		if (!xstrcmp(stepno, "batch"))
+			sh5util_file->step_id = -2;
+		else
+			sh5util_file->step_id = strtol(stepno, NULL, 10);
+
+		stepno = pos_char + 1;
+		sh5util_file->node_name = xstrdup(stepno);
+	}
+	closedir(dir);
+
+	if (!file_list || !list_count(file_list)) {
+		info("No node-step files found for jobid %d", params.job_id);
+		goto endit;
+	}
+
+	/* sort the files so they are in step order */
+	list_sort(file_list, (ListCmpF) _sh5util_sort_files_dec);
+
+	if (params.parallel > 1)
+		rc = _merge_parallel(file_list, step_dir);
+	else
+		rc = _merge_file_list(file_list, step_dir, params.output);
+
+endit:
+	FREE_NULL_LIST(file_list);
+	xfree(file_name);
+	xfree(step_dir);
+
+	return rc;
+}
+
 /* ============================================================================
  * ============================================================================
  * Functions for data extraction
@@ -58,6 +58,7 @@ typedef struct {
 	sh5util_mode_t mode;
 	char *node;
 	char *output;
+	int parallel;
 	char *series;
 	char *data_item;
 	int step_id;
@@ -45,6 +45,8 @@
  *  Copyright (C) 2002 The Regents of the University of California.
  \*****************************************************************************/
 
+#include "config.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/types.h>
@@ -56,6 +58,9 @@
 #include <unistd.h>
 #include <math.h>
 #include <curl/curl.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 #include "src/common/slurm_xlator.h"
 #include "src/common/fd.h"
@@ -64,6 +69,7 @@
 #include "src/common/slurm_protocol_defs.h"
 #include "src/common/slurm_time.h"
 #include "src/common/macros.h"
+#include "src/common/read_config.h"
 #include "src/slurmd/common/proctrack.h"
 
 
@@ -96,15 +102,32 @@ const char plugin_name[] = "AcctGatherProfile influxdb plugin";
 const char plugin_type[] = "acct_gather_profile/influxdb";
 const uint32_t plugin_version = SLURM_VERSION_NUMBER;
 
+/* Number of batches of BUF_SIZE bytes the sender thread may fall behind */
+#define DEFAULT_INFLUXDB_QUEUE_SIZE 32
+#define DEFAULT_INFLUXDB_TIMEOUT 10
+/* Cap on the data kept on local disk while the server is unreachable */
+#define INFLUXDB_SPILL_MAX (64 * 1024 * 1024)
+#define INFLUXDB_BACKOFF_MAX 60
+
 typedef struct {
+	bool compress;
 	char *host;
 	char *database;
 	uint32_t def;
 	char *password;
+	uint32_t queue_size;
 	char *rt_policy;
+	uint32_t timeout;
 	char *username;
 } slurm_influxdb_conf_t;
 
+/* A batch of samples in InfluxDB line protocol */
+typedef struct {
+	char *data;
+	uint32_t len;
+	uint32_t samples;
+} batch_t;
+
 typedef struct {
 	char ** names;
 	uint32_t *types;
@@ -127,8 +150,41 @@ static slurm_influxdb_conf_t influxdb_conf;
 static uint32_t g_profile_running = ACCT_GATHER_PROFILE_NOT_SET;
 static stepd_step_rec_t *g_job = NULL;
 
-static char *datastr = NULL;
-static int datastrlen = 0;
+/*
+ * The sampling path only appends to cur_batch. Full batches are moved into
+ * a bounded ring which is drained by a sender thread, so a slow or
+ * unreachable server never stalls the sampling. When the ring is full the
+ * batch is dropped. Batches the sender fails to post are spilled to a file
+ * in the SlurmdSpoolDir and resent once the server answers again.
+ */
+static pthread_mutex_t send_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t send_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t send_tid = 0;
+static bool send_shutdown = false;
+static time_t send_deadline = 0;
+static batch_t cur_batch;
+static batch_t *ring = NULL;
+static uint32_t ring_head = 0;
+static uint32_t ring_cnt = 0;
+
+/* Only used by the sender thread */
+static char *spill_file = NULL;
+static int spill_fd = -1;
+static off_t spill_off = 0;
+static off_t spill_size = 0;
+static uint64_t spill_samples = 0;
+static time_t retry_time = 0;
+static uint32_t backoff = 0;
+
+/* Sample counters, protected by send_lock */
+static struct {
+	uint64_t queued;
+	uint64_t sent;
+	uint64_t dropped;
+	uint64_t spilled;
+	uint64_t resent;
+	uint32_t failures;
+} stats;
 
 static table_t *tables = NULL;
 static size_t tables_max_len = 0;
@@ -189,53 +245,73 @@ static size_t _write_callback(void *contents, size_t size, size_t nmemb,
 	return realsize;
 }
 
-/* Try to send data to influxdb */
-static int _send_data(const char *data)
+#ifdef HAVE_ZLIB
+/* Compress a batch into a gzip stream, as accepted by the /write endpoint */
+static char *_gzip(const char *data, size_t len, size_t *out_len)
+{
+	z_stream strm;
+	char *out;
+	size_t out_max;
+
+	memset(&strm, 0, sizeof(strm));
+	if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+			 Z_DEFAULT_STRATEGY) != Z_OK)
+		return NULL;
+
+	out_max = deflateBound(&strm, len);
+	out = xmalloc(out_max);
+	strm.next_in = (Bytef *) data;
+	strm.avail_in = len;
+	strm.next_out = (Bytef *) out;
+	strm.avail_out = out_max;
+
+	if (deflate(&strm, Z_FINISH) != Z_STREAM_END) {
+		deflateEnd(&strm);
+		xfree(out);
+		return NULL;
+	}
+
+	*out_len = strm.total_out;
+	deflateEnd(&strm);
+	return out;
+}
+#endif
+
+/*
+ * Post data to influxdb.
+ * RET SLURM_SUCCESS, or SLURM_ERROR with *retry set if the server could not
+ * be reached or is impaired and the same data should be sent again later.
+ */
+static int _post_data(CURL *curl_handle, const char *data, size_t len,
+		      bool *retry)
 {
-	CURL *curl_handle = NULL;
 	CURLcode res;
 	struct http_response chunk;
+	struct curl_slist *headers = NULL;
 	int rc = SLURM_SUCCESS;
 	long response_code;
 	static int error_cnt = 0;
-	char *url = NULL;
-	size_t length;
+	char *url = NULL, *zdata = NULL;
+	size_t zlen = 0;
 
 	debug3("%s %s called", plugin_type, __func__);
 
-	/*
-	 * Every compute node which is sampling data will try to establish a
-	 * different connection to the influxdb server. In order to reduce the
-	 * number of connections, every time a new sampled data comes in, it
-	 * is saved in the 'datastr' buffer. Once this buffer is full, then we
-	 * try to open the connection and send this buffer, instead of opening
-	 * one per sample.
-	 */
-	if (data && ((datastrlen + strlen(data)) <= BUF_SIZE)) {
-		xstrcat(datastr, data);
-		length = strlen(data);
-		datastrlen += length;
-		log_flag(PROFILE, "%s %s: %zu bytes of data added to buffer. New buffer size: %d",
-			 plugin_type, __func__, length, datastrlen);
-		return rc;
-	}
+	*retry = false;
 
 	DEF_TIMERS;
 	START_TIMER;
 
-	if (curl_global_init(CURL_GLOBAL_ALL) != 0) {
-		error("%s %s: curl_global_init: %m", plugin_type, __func__);
-		rc = SLURM_ERROR;
-		goto cleanup_global_init;
-	} else if ((curl_handle = curl_easy_init()) == NULL) {
-		error("%s %s: curl_easy_init: %m", plugin_type, __func__);
-		rc = SLURM_ERROR;
-		goto cleanup_easy_init;
-	}
-
 	xstrfmtcat(url, "%s/write?db=%s&rp=%s&precision=s", influxdb_conf.host,
 		   influxdb_conf.database, influxdb_conf.rt_policy);
 
+#ifdef HAVE_ZLIB
+	if (influxdb_conf.compress && (zdata = _gzip(data, len, &zlen))) {
+		headers = curl_slist_append(headers, "Content-Encoding: gzip");
+		data = zdata;
+		len = zlen;
+	}
+#endif
+
 	chunk.message = xmalloc(1);
 	chunk.size = 0;
 
@@ -243,9 +319,13 @@ static int _send_data(const char *data)
 	if (influxdb_conf.password)
 		curl_easy_setopt(curl_handle, CURLOPT_PASSWORD,
 				 influxdb_conf.password);
-	curl_easy_setopt(curl_handle, CURLOPT_POST, 1);
-	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, datastr);
-	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE, strlen(datastr));
+	curl_easy_setopt(curl_handle, CURLOPT_POST, 1L);
+	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, data);
+	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE, (long) len);
+	curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
+	curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT,
+			 (long) influxdb_conf.timeout);
+	curl_easy_setopt(curl_handle, CURLOPT_NOSIGNAL, 1L);
 	if (influxdb_conf.username)
 		curl_easy_setopt(curl_handle, CURLOPT_USERNAME,
 				 influxdb_conf.username);
@@ -254,8 +334,9 @@ static int _send_data(const char *data)
 
 	if ((res = curl_easy_perform(curl_handle)) != CURLE_OK) {
 		if ((error_cnt++ % 100) == 0)
-			error("%s %s: curl_easy_perform failed to send data (discarded). Reason: %s",
+			error("%s %s: curl_easy_perform failed to send data. Reason: %s",
 			      plugin_type, __func__, curl_easy_strerror(res));
+		*retry = true;
 		rc = SLURM_ERROR;
 		goto cleanup;
 	}
@@ -280,40 +361,327 @@ static int _send_data(const char *data)
 			error_cnt = 0;
 	} else {
 		rc = SLURM_ERROR;
+		if (response_code >= 500)
+			*retry = true;
 		debug2("%s %s: data write failed, response code: %ld",
 		       plugin_type, __func__, response_code);
 		if (slurm_conf.debug_flags & DEBUG_FLAG_PROFILE) {
 			/* Strip any trailing newlines. */
-			while (chunk.message[strlen(chunk.message) - 1] == '\n')
-				chunk.message[strlen(chunk.message) - 1] = '\0';
+			while (chunk.size &&
+			       (chunk.message[chunk.size - 1] == '\n'))
+				chunk.message[--chunk.size] = '\0';
 			info("%s %s: JSON response body: %s", plugin_type,
 			     __func__, chunk.message);
 		}
 	}
 
 cleanup:
+	curl_slist_free_all(headers);
 	xfree(chunk.message);
 	xfree(url);
-cleanup_easy_init:
-	curl_easy_cleanup(curl_handle);
-cleanup_global_init:
-	curl_global_cleanup();
+	xfree(zdata);
 
 	END_TIMER;
-	log_flag(PROFILE, "%s %s: took %s to send data",
-		 plugin_type, __func__, TIME_STR);
+	log_flag(PROFILE, "%s %s: took %s to send %zu bytes of data",
+		 plugin_type, __func__, TIME_STR, len);
 
-	if (data) {
-		datastr = xstrdup(data);
-		datastrlen = strlen(data);
-	} else {
-		datastr[0] = '\0';
-		datastrlen = 0;
+	return rc;
+}
+
+static uint32_t _count_lines(const char *data, size_t len)
+{
+	uint32_t cnt = 0;
+	const char *end = data + len;
+
+	while ((data = memchr(data, '\n', end - data))) {
+		cnt++;
+		data++;
+	}
+
+	return cnt;
+}
+
+/* Called by the sender thread once a post failed */
+static void _set_backoff(void)
+{
+	slurm_mutex_lock(&send_lock);
+	stats.failures++;
+	slurm_mutex_unlock(&send_lock);
+
+	if (!backoff)
+		backoff = 1;
+	else
+		backoff = MIN(backoff * 2, INFLUXDB_BACKOFF_MAX);
+	retry_time = time(NULL) + backoff;
+
+	log_flag(PROFILE, "%s %s: server unavailable, next attempt in %u seconds",
+		 plugin_type, __func__, backoff);
+}
+
+static void _spill_batch(batch_t *batch)
+{
+	uint64_t spilled = 0, dropped = 0;
+
+	if ((spill_fd < 0) && spill_file) {
+		spill_fd = open(spill_file, O_CREAT | O_RDWR | O_APPEND |
+				O_CLOEXEC, S_IRUSR | S_IWUSR);
+		if (spill_fd < 0) {
+			error("%s %s: unable to open %s: %m",
+			      plugin_type, __func__, spill_file);
+			xfree(spill_file);
+		}
+	}
+
+	if ((spill_fd < 0) ||
+	    ((spill_size + batch->len) > INFLUXDB_SPILL_MAX)) {
+		dropped = batch->samples;
+		goto end_it;
+	}
+
+	safe_write(spill_fd, batch->data, batch->len);
+	spill_size += batch->len;
+	spill_samples += batch->samples;
+	spilled = batch->samples;
+	goto end_it;
+
+rwfail:
+	error("%s %s: unable to write %s: %m",
+	      plugin_type, __func__, spill_file);
+	dropped = batch->samples;
+end_it:
+	slurm_mutex_lock(&send_lock);
+	stats.spilled += spilled;
+	stats.dropped += dropped;
+	slurm_mutex_unlock(&send_lock);
+}
+
+/*
+ * Resend what was spilled while the server was unreachable, oldest first.
+ * Once the step has ended, stop at send_deadline and leave the rest on disk.
+ */
+static int _resend_spill(CURL *curl_handle)
+{
+	char *buf, *eol;
+	ssize_t len, i;
+	uint32_t samples;
+	bool expired, long_line = false, retry;
+	int rc = SLURM_SUCCESS;
+
+	if ((spill_fd < 0) || (spill_off >= spill_size))
+		return SLURM_SUCCESS;
+
+	buf = xmalloc(BUF_SIZE);
+	while (spill_off < spill_size) {
+		slurm_mutex_lock(&send_lock);
+		expired = send_shutdown && (time(NULL) > send_deadline);
+		slurm_mutex_unlock(&send_lock);
+		if (expired) {
+			rc = SLURM_ERROR;
+			break;
+		}
+
+		len = pread(spill_fd, buf, BUF_SIZE, spill_off);
+		if (len <= 0) {
+			error("%s %s: unable to read %s: %m",
+			      plugin_type, __func__, spill_file);
+			rc = SLURM_ERROR;
+			break;
+		}
+
+		if (long_line) {
+			/* Skip the rest of a line longer than BUF_SIZE */
+			if (!(eol = memchr(buf, '\n', len))) {
+				spill_off += len;
+				continue;
+			}
+			spill_off += eol - buf + 1;
+			spill_samples -= MIN(1, spill_samples);
+			long_line = false;
+			slurm_mutex_lock(&send_lock);
+			stats.dropped++;
+			slurm_mutex_unlock(&send_lock);
+			continue;
+		}
+
+		/* Only send complete lines */
+		for (i = len - 1; (i >= 0) && (buf[i] != '\n'); i--)
+			;
+		if (i < 0) {
+			/* Not even one complete line, it can't be sent */
+			error("%s %s: dropping a sample longer than %d bytes from %s",
+			      plugin_type, __func__, BUF_SIZE, spill_file);
+			spill_off += len;
+			long_line = true;
+			continue;
+		}
+		len = i + 1;
+		samples = _count_lines(buf, len);
+
+		if (_post_data(curl_handle, buf, len, &retry) != SLURM_SUCCESS) {
+			if (retry) {
+				_set_backoff();
+				rc = SLURM_ERROR;
+				break;
+			}
+			slurm_mutex_lock(&send_lock);
+			stats.dropped += samples;
+			slurm_mutex_unlock(&send_lock);
+		} else {
+			slurm_mutex_lock(&send_lock);
+			stats.resent += samples;
+			slurm_mutex_unlock(&send_lock);
+		}
+		spill_off += len;
+		spill_samples -= MIN(samples, spill_samples);
+	}
+	xfree(buf);
+
+	if (spill_off >= spill_size) {
+		if (ftruncate(spill_fd, 0) < 0)
+			error("%s %s: unable to truncate %s: %m",
+			      plugin_type, __func__, spill_file);
+		spill_off = spill_size = 0;
+		spill_samples = 0;
 	}
 
 	return rc;
 }
 
+static void _ship_batch(CURL *curl_handle, batch_t *batch, bool expired)
+{
+	bool retry = false;
+
+	if (expired) {
+		slurm_mutex_lock(&send_lock);
+		stats.dropped += batch->samples;
+		slurm_mutex_unlock(&send_lock);
+		return;
+	}
+
+	/* While the server is down, go straight to disk until the backoff */
+	if (time(NULL) >= retry_time) {
+		if (_post_data(curl_handle, batch->data, batch->len, &retry)
+		    == SLURM_SUCCESS) {
+			slurm_mutex_lock(&send_lock);
+			stats.sent += batch->samples;
+			slurm_mutex_unlock(&send_lock);
+			backoff = 0;
+			retry_time = 0;
+			(void) _resend_spill(curl_handle);
+			return;
+		}
+		if (!retry) {
+			/* Rejected by the server, sending it again won't help */
+			slurm_mutex_lock(&send_lock);
+			stats.dropped += batch->samples;
+			slurm_mutex_unlock(&send_lock);
+			return;
+		}
+		_set_backoff();
+	}
+
+	_spill_batch(batch);
+}
+
+static void *_sender(void *arg)
+{
+	CURL *curl_handle;
+	batch_t batch;
+	bool expired;
+
+	if (!(curl_handle = curl_easy_init())) {
+		error("%s %s: curl_easy_init: %m", plugin_type, __func__);
+		return NULL;
+	}
+
+	while (true) {
+		slurm_mutex_lock(&send_lock);
+		while (!ring_cnt && !send_shutdown)
+			slurm_cond_wait(&send_cond, &send_lock);
+		if (!ring_cnt) {
+			slurm_mutex_unlock(&send_lock);
+			break;
+		}
+		batch = ring[ring_head];
+		ring_head = (ring_head + 1) % (influxdb_conf.queue_size + 1);
+		ring_cnt--;
+		expired = send_shutdown && (time(NULL) > send_deadline);
+		slurm_mutex_unlock(&send_lock);
+
+		_ship_batch(curl_handle, &batch, expired);
+		xfree(batch.data);
+	}
+
+	/* Last chance for what was spilled while the step was running */
+	if (spill_size && (time(NULL) <= send_deadline)) {
+		retry_time = 0;
+		(void) _resend_spill(curl_handle);
+	}
+
+	curl_easy_cleanup(curl_handle);
+	return NULL;
+}
+
+/*
+ * Move cur_batch into the ring. The ring has one slot more than
+ * ProfileInfluxDBQueueSize for the final flush of the step.
+ * Call with send_lock held.
+ */
+static void _queue_batch(bool final)
+{
+	static int drop_cnt = 0;
+	uint32_t max = influxdb_conf.queue_size + (final ? 1 : 0);
+
+	if (!cur_batch.len)
+		return;
+
+	if (ring_cnt >= max) {
+		if ((drop_cnt++ % 100) == 0)
+			error("%s %s: sender is falling behind, dropping %u samples",
+			      plugin_type, __func__, cur_batch.samples);
+		stats.dropped += cur_batch.samples;
+		xfree(cur_batch.data);
+	} else {
+		ring[(ring_head + ring_cnt) % (influxdb_conf.queue_size + 1)] =
+			cur_batch;
+		ring_cnt++;
+		slurm_cond_signal(&send_cond);
+	}
+
+	memset(&cur_batch, 0, sizeof(cur_batch));
+}
+
+/*
+ * Add samples to the current batch. Every compute node which is sampling
+ * data would otherwise establish a different connection to the influxdb
+ * server per sample, so samples are only handed to the sender thread once
+ * BUF_SIZE bytes have been gathered.
+ */
+static void _send_data(const char *data, uint32_t samples)
+{
+	size_t length = strlen(data);
+
+	debug3("%s %s called", plugin_type, __func__);
+
+	slurm_mutex_lock(&send_lock);
+	if (!send_tid) {
+		stats.dropped += samples;
+		slurm_mutex_unlock(&send_lock);
+		return;
+	}
+
+	if (cur_batch.len && ((cur_batch.len + length) > BUF_SIZE))
+		_queue_batch(false);
+
+	xstrcat(cur_batch.data, data);
+	cur_batch.len += length;
+	cur_batch.samples += samples;
+	stats.queued += samples;
+	log_flag(PROFILE, "%s %s: %zu bytes of data added to buffer. New buffer size: %u",
+		 plugin_type, __func__, length, cur_batch.len);
+	slurm_mutex_unlock(&send_lock);
+}
+
 /*
  * init() is called when the plugin is loaded, before any other functions
  * are called. Put global initialization here.
@@ -322,10 +690,6 @@ extern int init(void)
 {
 	debug3("%s %s called", plugin_type, __func__);
 
-	if (!running_in_slurmstepd())
-		return SLURM_SUCCESS;
-
-	datastr = xmalloc(BUF_SIZE);
 	return SLURM_SUCCESS;
 }
 
@@ -334,7 +698,9 @@ extern int fini(void)
 	debug3("%s %s called", plugin_type, __func__);
 
 	_free_tables();
-	xfree(datastr);
+	xfree(ring);
+	xfree(cur_batch.data);
+	xfree(spill_file);
 	xfree(influxdb_conf.host);
 	xfree(influxdb_conf.database);
 	xfree(influxdb_conf.password);
@@ -350,10 +716,13 @@ extern void acct_gather_profile_p_conf_options(s_p_options_t **full_options,
 
 	s_p_options_t options[] = {
 		{"ProfileInfluxDBHost", S_P_STRING},
+		{"ProfileInfluxDBCompress", S_P_BOOLEAN},
 		{"ProfileInfluxDBDatabase", S_P_STRING},
 		{"ProfileInfluxDBDefault", S_P_STRING},
 		{"ProfileInfluxDBPass", S_P_STRING},
+		{"ProfileInfluxDBQueueSize", S_P_UINT32},
 		{"ProfileInfluxDBRTPolicy", S_P_STRING},
+		{"ProfileInfluxDBTimeout", S_P_UINT32},
 		{"ProfileInfluxDBUser", S_P_STRING},
 		{NULL} };
 
@@ -368,8 +737,15 @@ extern void acct_gather_profile_p_conf_set(s_p_hashtbl_t *tbl)
 	debug3("%s %s called", plugin_type, __func__);
 
 	influxdb_conf.def = ACCT_GATHER_PROFILE_ALL;
+#ifdef HAVE_ZLIB
+	influxdb_conf.compress = true;
+#endif
+	influxdb_conf.queue_size = DEFAULT_INFLUXDB_QUEUE_SIZE;
+	influxdb_conf.timeout = DEFAULT_INFLUXDB_TIMEOUT;
 	if (tbl) {
 		s_p_get_string(&influxdb_conf.host, "ProfileInfluxDBHost", tbl);
+		s_p_get_boolean(&influxdb_conf.compress,
+				"ProfileInfluxDBCompress", tbl);
 		if (s_p_get_string(&tmp, "ProfileInfluxDBDefault", tbl)) {
 			influxdb_conf.def =
 				acct_gather_profile_from_string(tmp);
@@ -382,12 +758,26 @@ extern void acct_gather_profile_p_conf_set(s_p_hashtbl_t *tbl)
 			       "ProfileInfluxDBDatabase", tbl);
 		s_p_get_string(&influxdb_conf.password,
 			       "ProfileInfluxDBPass", tbl);
+		s_p_get_uint32(&influxdb_conf.queue_size,
+			       "ProfileInfluxDBQueueSize", tbl);
 		s_p_get_string(&influxdb_conf.rt_policy,
 			       "ProfileInfluxDBRTPolicy", tbl);
+		s_p_get_uint32(&influxdb_conf.timeout,
+			       "ProfileInfluxDBTimeout", tbl);
 		s_p_get_string(&influxdb_conf.username,
 			       "ProfileInfluxDBUser", tbl);
 	}
 
+#ifndef HAVE_ZLIB
+	if (influxdb_conf.compress) {
+		error("ProfileInfluxDBCompress requires Slurm built with zlib, sending uncompressed data");
+		influxdb_conf.compress = false;
+	}
+#endif
+
+	if (!influxdb_conf.queue_size)
+		fatal("ProfileInfluxDBQueueSize can not be 0");
+
 	if (!influxdb_conf.host)
 		fatal("No ProfileInfluxDBHost in your acct_gather.conf file. This is required to use the %s plugin",
 		      plugin_type);
@@ -445,6 +835,29 @@ extern int acct_gather_profile_p_node_step_start(stepd_step_rec_t* job)
 	debug2("%s %s: option --profile=%s", plugin_type, __func__,
 	       profile_str);
 	g_profile_running = _determine_profile();
+
+	if (g_profile_running <= ACCT_GATHER_PROFILE_NONE)
+		return rc;
+
+	if (curl_global_init(CURL_GLOBAL_ALL) != 0) {
+		error("%s %s: curl_global_init: %m", plugin_type, __func__);
+		return SLURM_ERROR;
+	}
+
+	if (slurm_conf.slurmd_spooldir) {
+		char *spooldir = slurm_conf_expand_slurmd_path(
+			slurm_conf.slurmd_spooldir, g_job->node_name);
+		xstrfmtcat(spill_file, "%s/profile_influxdb.%u.%u.spill",
+			   spooldir, g_job->step_id.job_id,
+			   g_job->step_id.step_id);
+		xfree(spooldir);
+	}
+
+	ring = xcalloc(influxdb_conf.queue_size + 1, sizeof(batch_t));
+	slurm_mutex_lock(&send_lock);
+	slurm_thread_create(&send_tid, _sender, NULL);
+	slurm_mutex_unlock(&send_lock);
+
 	return rc;
 }
 
@@ -457,10 +870,51 @@ extern int acct_gather_profile_p_child_forked(void)
 extern int acct_gather_profile_p_node_step_end(void)
 {
 	int rc = SLURM_SUCCESS;
+	pthread_t tid;
+
 	debug3("%s %s called", plugin_type, __func__);
 
 	xassert(running_in_slurmstepd());
 
+	slurm_mutex_lock(&send_lock);
+	if (!(tid = send_tid)) {
+		slurm_mutex_unlock(&send_lock);
+		return rc;
+	}
+	_queue_batch(true);
+	send_shutdown = true;
+	/* Don't hold up the end of the step much longer than one post */
+	send_deadline = time(NULL) + influxdb_conf.timeout;
+	slurm_cond_signal(&send_cond);
+	slurm_mutex_unlock(&send_lock);
+
+	pthread_join(tid, NULL);
+
+	slurm_mutex_lock(&send_lock);
+	send_tid = 0;
+	slurm_mutex_unlock(&send_lock);
+
+	curl_global_cleanup();
+
+	if (spill_fd >= 0) {
+		close(spill_fd);
+		spill_fd = -1;
+		/* Whatever could not be resent by now is lost */
+		stats.dropped += spill_samples;
+		spill_samples = 0;
+	}
+	if (spill_file && (unlink(spill_file) < 0) && (errno != ENOENT))
+		error("%s %s: unable to remove %s: %m",
+		      plugin_type, __func__, spill_file);
+
+	log_flag(PROFILE, "%s %s: samples queued:%"PRIu64" sent:%"PRIu64" spilled:%"PRIu64" resent:%"PRIu64" dropped:%"PRIu64" failed posts:%u",
+		 plugin_type, __func__, stats.queued, stats.sent,
+		 stats.spilled, stats.resent, stats.dropped, stats.failures);
+	if (stats.dropped)
+		info("%s: %"PRIu64" of %"PRIu64" samples could not be sent to %s",
+		     plugin_type, stats.dropped, stats.queued,
+		     influxdb_conf.host);
+
 	return rc;
 }
 
@@ -486,7 +940,10 @@ extern int acct_gather_profile_p_task_end(pid_t taskpid)
 {
 	debug3("%s %s called", plugin_type, __func__);
 
-	_send_data(NULL);
+	slurm_mutex_lock(&send_lock);
+	if (send_tid)
+		_queue_batch(false);
+	slurm_mutex_unlock(&send_lock);
 	return SLURM_SUCCESS;
 }
 
@@ -583,7 +1040,8 @@ extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 		}
 	}
 
-	_send_data(str);
+	if (str)
+		_send_data(str, table->size);
 	xfree(str);
 
 	return SLURM_SUCCESS;
@@ -602,6 +1060,11 @@ extern void acct_gather_profile_p_conf_values(List *data)
 	key_pair->value = xstrdup(influxdb_conf.host);
 	list_append(*data, key_pair);
 
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("ProfileInfluxDBCompress");
+	key_pair->value = xstrdup(influxdb_conf.compress ? "yes" : "no");
+	list_append(*data, key_pair);
+
 	key_pair = xmalloc(sizeof(config_key_pair_t));
 	key_pair->name = xstrdup("ProfileInfluxDBDatabase");
 	key_pair->value = xstrdup(influxdb_conf.database);
@@ -618,11 +1081,21 @@ extern void acct_gather_profile_p_conf_values(List *data)
 	key_pair->value = xstrdup(influxdb_conf.password);
 	list_append(*data, key_pair);
 
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("ProfileInfluxDBQueueSize");
+	key_pair->value = xstrdup_printf("%u", influxdb_conf.queue_size);
+	list_append(*data, key_pair);
+
 	key_pair = xmalloc(sizeof(config_key_pair_t));
 	key_pair->name = xstrdup("ProfileInfluxDBRTPolicy");
 	key_pair->value = xstrdup(influxdb_conf.rt_policy);
 	list_append(*data, key_pair);
 
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("ProfileInfluxDBTimeout");
+	key_pair->value = xstrdup_printf("%u", influxdb_conf.timeout);
+	list_append(*data, key_pair);
+
 	key_pair = xmalloc(sizeof(config_key_pair_t));
 	key_pair->name = xstrdup("ProfileInfluxDBUser");
 	key_pair->value = xstrdup(influxdb_conf.username);
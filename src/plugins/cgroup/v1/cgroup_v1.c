@@ -1495,6 +1495,12 @@ extern cgroup_acct_t *cgroup_p_task_get_acct_data(uint32_t taskid)
 	stats->ssec = NO_VAL64;
 	stats->total_rss = NO_VAL64;
 	stats->total_pgmajfault = NO_VAL64;
+	stats->cpu_pressure_usec = NO_VAL64;
+	stats->mem_pressure_usec = NO_VAL64;
+	stats->io_pressure_usec = NO_VAL64;
+	stats->mem_high_events = NO_VAL64;
+	stats->mem_max_events = NO_VAL64;
+	stats->oom_kill_cnt = NO_VAL64;
 
 	if (cpu_time != NULL)
 		sscanf(cpu_time, "%*s %lu %*s %lu", &stats->usec, &stats->ssec);
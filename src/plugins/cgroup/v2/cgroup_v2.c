@@ -0,0 +1,1064 @@
+/*****************************************************************************\
+ *  cgroup_v2.c - Cgroup v2 plugin
+ *****************************************************************************
+ *  Copyright (C) 2021 agent <agent@local>
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "cgroup_v2.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/vfs.h>
+
+/*
+ * These variables are required by the generic plugin interface.  If they
+ * are not found in the plugin, the plugin loader will ignore it.
+ *
+ * plugin_name - a string giving a human-readable description of the
+ * plugin.  There is no maximum length, but the symbol must refer to
+ * a valid string.
+ *
+ * plugin_type - a string suggesting the type of the plugin or its
+ * applicability to a particular form of data or method of data handling.
+ * If the low-level plugin API is used, the contents of this string are
+ * unimportant and may be anything.  Slurm uses the higher-level plugin
+ * interface which requires this string to be of the form
+ *
+ *	<application>/<method>
+ *
+ * where <application> is a description of the intended application of
+ * the plugin (e.g., "select" for Slurm node selection) and <method>
+ * is a description of how this plugin satisfies that application.  Slurm will
+ * only load select plugins if the plugin_type string has a
+ * prefix of "select/".
+ *
+ * plugin_version - an unsigned 32-bit integer containing the Slurm version
+ * (major.minor.micro combined into a single number).
+ */
+const char plugin_name[] = "Cgroup v2 plugin";
+const char plugin_type[] = "cgroup/v2";
+const uint32_t plugin_version = SLURM_VERSION_NUMBER;
+
+/*
+ * Controller of the unified hierarchy needed by each Slurm controller type,
+ * NULL if the core cgroup files are enough.
+ */
+static const char *g_ctl_name[CG_CTL_CNT] = {
+	NULL,		/* CG_TRACK: cgroup.procs and cgroup.freeze */
+	"cpuset",	/* CG_CPUS */
+	"memory",	/* CG_MEMORY */
+	NULL,		/* CG_DEVICES: not supported */
+	NULL,		/* CG_CPUACCT: cpu.stat */
+};
+
+static xcgroup_ns_t g_cg_ns;
+static xcgroup_t g_root_cg;
+static xcgroup_t g_slurm_cg;
+static xcgroup_t g_sys_cg;
+static xcgroup_t g_user_cg;
+static xcgroup_t g_job_cg;
+static xcgroup_t g_step_cg;
+static xcgroup_t g_special_cg;	/* step_<id>/task_special */
+
+static uint16_t g_step_active_cnt[CG_CTL_CNT];
+static uint32_t g_ctl_mask = 0;		/* controller types initialized */
+static long g_hertz = 0;
+static uint64_t g_oom_kill_start = NO_VAL64;
+static int g_lock_fd = -1;
+
+typedef struct {
+	xcgroup_t task_cg;
+	uint32_t taskid;
+	pid_t pid;		/* last pid moved in, to move it only once */
+} task_cg_info_t;
+
+static List g_task_list = NULL;
+
+static int _find_task_cg_info(void *x, void *key)
+{
+	task_cg_info_t *task_cg = x;
+	uint32_t taskid = *(uint32_t *) key;
+
+	return (task_cg->taskid == taskid);
+}
+
+static void _free_task_cg_info(void *object)
+{
+	task_cg_info_t *task_cg = object;
+
+	if (task_cg) {
+		common_cgroup_destroy(&task_cg->task_cg);
+		xfree(task_cg);
+	}
+}
+
+static int _active_cnt(void)
+{
+	int cnt = 0;
+
+	for (int i = 0; i < CG_CTL_CNT; i++)
+		cnt += g_step_active_cnt[i];
+
+	return cnt;
+}
+
+static int _ns_init(void)
+{
+	struct statfs fs;
+	char *pre;
+
+	if (g_cg_ns.mnt_point)
+		return SLURM_SUCCESS;
+
+	if (statfs(slurm_cgroup_conf.cgroup_mountpoint, &fs) < 0) {
+		error("unable to stat %s: %m",
+		      slurm_cgroup_conf.cgroup_mountpoint);
+		return SLURM_ERROR;
+	}
+	if (!F_TYPE_EQUAL(fs.f_type, CGROUP2_SUPER_MAGIC)) {
+		error("%s is not a cgroup v2 unified hierarchy",
+		      slurm_cgroup_conf.cgroup_mountpoint);
+		return SLURM_ERROR;
+	}
+
+	g_cg_ns.mnt_point = xstrdup(slurm_cgroup_conf.cgroup_mountpoint);
+	g_cg_ns.subsystems = xstrdup("unified");
+
+	pre = xstrdup(slurm_cgroup_conf.cgroup_prepend);
+#ifdef MULTIPLE_SLURMD
+	if (conf->node_name) {
+		xstrsubstitute(pre, "%n", conf->node_name);
+	} else {
+		xfree(pre);
+		pre = xstrdup("/slurm");
+	}
+#endif
+	common_cgroup_create(&g_cg_ns, &g_root_cg, "", 0, 0);
+	common_cgroup_create(&g_cg_ns, &g_slurm_cg, pre, 0, 0);
+	xfree(pre);
+
+	return SLURM_SUCCESS;
+}
+
+/* Return true if the controller is listed in the param file of cg */
+static bool _has_controller(xcgroup_t *cg, char *param, const char *ctl)
+{
+	char *content = NULL, *tok, *save_ptr = NULL;
+	size_t size;
+	bool found = false;
+
+	if (common_cgroup_get_param(cg, param, &content, &size) !=
+	    SLURM_SUCCESS)
+		return false;
+
+	tok = strtok_r(content, " \n", &save_ptr);
+	while (tok && !found) {
+		found = !xstrcmp(tok, ctl);
+		tok = strtok_r(NULL, " \n", &save_ptr);
+	}
+	xfree(content);
+
+	return found;
+}
+
+/* Build the "+ctl1 +ctl2" string enabling every controller we need */
+static char *_subtree_control(void)
+{
+	char *ctl = NULL;
+
+	for (int i = 0; i < CG_CTL_CNT; i++) {
+		if (!(g_ctl_mask & (1 << i)) || !g_ctl_name[i])
+			continue;
+		xstrfmtcat(ctl, "%s+%s", ctl ? " " : "", g_ctl_name[i]);
+	}
+
+	return ctl;
+}
+
+/*
+ * Enable all the controllers we need in the children of cg with a single
+ * write, skipping it if they are already enabled.
+ */
+static int _enable_controllers(xcgroup_t *cg, bool check)
+{
+	char *ctl = _subtree_control();
+	bool missing = !check;
+	int rc = SLURM_SUCCESS;
+
+	if (!ctl)
+		return SLURM_SUCCESS;
+
+	for (int i = 0; (i < CG_CTL_CNT) && !missing; i++) {
+		if ((g_ctl_mask & (1 << i)) && g_ctl_name[i] &&
+		    !_has_controller(cg, "cgroup.subtree_control",
+				     g_ctl_name[i]))
+			missing = true;
+	}
+
+	if (missing &&
+	    (rc = common_cgroup_set_param(cg, "cgroup.subtree_control", ctl)))
+		error("unable to enable controllers '%s' in %s",
+		      ctl, cg->path);
+	xfree(ctl);
+
+	return rc;
+}
+
+/*
+ * mkdir a cgroup of the unified hierarchy.
+ * RET 1 if created, 0 if it already existed, -1 on error.
+ */
+static int _create_cg(xcgroup_t *cg, char *uri, uid_t uid, gid_t gid)
+{
+	common_cgroup_create(&g_cg_ns, cg, uri, uid, gid);
+
+	if (mkdir(cg->path, 0755)) {
+		if (errno == EEXIST)
+			return 0;
+		error("unable to create cgroup '%s': %m", cg->path);
+		common_cgroup_destroy(cg);
+		return -1;
+	}
+	if ((uid || gid) && chown(cg->path, uid, gid))
+		error("unable to chown %d:%d cgroup '%s': %m",
+		      uid, gid, cg->path);
+
+	return 1;
+}
+
+/* Create the slurm cgroup and make our controllers available under it */
+static int _slurm_cg_create(void)
+{
+	if (_enable_controllers(&g_root_cg, true) != SLURM_SUCCESS)
+		return SLURM_ERROR;
+
+	if (mkdir(g_slurm_cg.path, 0755) && (errno != EEXIST)) {
+		error("unable to create cgroup '%s': %m", g_slurm_cg.path);
+		return SLURM_ERROR;
+	}
+
+	return _enable_controllers(&g_slurm_cg, true);
+}
+
+/*
+ * Serialize the creation and removal of the uid and job directories between
+ * the steps of the node.
+ */
+static int _lock(void)
+{
+	if ((g_lock_fd = open(g_slurm_cg.path, O_RDONLY | O_CLOEXEC)) < 0) {
+		error("unable to open %s: %m", g_slurm_cg.path);
+		return SLURM_ERROR;
+	}
+	if (flock(g_lock_fd, LOCK_EX) < 0) {
+		error("unable to lock %s: %m", g_slurm_cg.path);
+		close(g_lock_fd);
+		g_lock_fd = -1;
+		return SLURM_ERROR;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+static void _unlock(void)
+{
+	if (g_lock_fd < 0)
+		return;
+
+	(void) flock(g_lock_fd, LOCK_UN);
+	(void) close(g_lock_fd);
+	g_lock_fd = -1;
+}
+
+static int _step_hierarchy_create(stepd_step_rec_t *job)
+{
+	char *uri = NULL, tmp_char[64];
+	int rc = SLURM_ERROR, created;
+
+	if (_slurm_cg_create() != SLURM_SUCCESS)
+		return SLURM_ERROR;
+
+	if (_lock() != SLURM_SUCCESS)
+		return SLURM_ERROR;
+
+	/*
+	 * The uid and job cgroups may have been set up by another step, only
+	 * enable the controllers when we are the ones creating them.
+	 */
+	xstrfmtcat(uri, "%s/uid_%u", g_slurm_cg.name, job->uid);
+	if ((created = _create_cg(&g_user_cg, uri, 0, 0)) < 0)
+		goto end;
+	if (created && _enable_controllers(&g_user_cg, false))
+		goto end;
+
+	xstrfmtcat(uri, "/job_%u", job->step_id.job_id);
+	if ((created = _create_cg(&g_job_cg, uri, 0, 0)) < 0)
+		goto end;
+	if (created && _enable_controllers(&g_job_cg, false))
+		goto end;
+
+	xstrfmtcat(uri, "/step_%s",
+		   log_build_step_id_str(&job->step_id, tmp_char,
+					 sizeof(tmp_char),
+					 STEP_ID_FLAG_NO_PREFIX |
+					 STEP_ID_FLAG_NO_JOB));
+	if (_create_cg(&g_step_cg, uri, job->uid, job->gid) < 0)
+		goto end;
+	if (_enable_controllers(&g_step_cg, false))
+		goto end;
+
+	xstrcat(uri, "/task_special");
+	if (_create_cg(&g_special_cg, uri, job->uid, job->gid) < 0)
+		goto end;
+
+	rc = SLURM_SUCCESS;
+end:
+	_unlock();
+	xfree(uri);
+
+	if (rc != SLURM_SUCCESS) {
+		if (g_step_cg.path)
+			(void) rmdir(g_step_cg.path);
+		common_cgroup_destroy(&g_step_cg);
+		common_cgroup_destroy(&g_job_cg);
+		common_cgroup_destroy(&g_user_cg);
+	}
+
+	return rc;
+}
+
+static int _rmdir_task(void *x, void *arg)
+{
+	task_cg_info_t *t = x;
+
+	if (common_cgroup_delete(&t->task_cg) != SLURM_SUCCESS)
+		log_flag(CGROUP, "taskid: %d, failed to delete %s %m",
+			 t->taskid, t->task_cg.path);
+
+	return SLURM_SUCCESS;
+}
+
+static int _step_hierarchy_destroy(void)
+{
+	int rc;
+
+	(void) list_for_each(g_task_list, _rmdir_task, NULL);
+	list_flush(g_task_list);
+
+	if ((rc = common_cgroup_delete(&g_special_cg)) != SLURM_SUCCESS)
+		return rc;
+	if ((rc = common_cgroup_delete(&g_step_cg)) != SLURM_SUCCESS)
+		return rc;
+	common_cgroup_destroy(&g_special_cg);
+	common_cgroup_destroy(&g_step_cg);
+
+	/*
+	 * Best effort for the job and user cgroups, other steps may still be
+	 * using them. The last one will remove them.
+	 */
+	if (_lock() != SLURM_SUCCESS)
+		return SLURM_SUCCESS;
+	if (common_cgroup_delete(&g_job_cg) == SLURM_SUCCESS)
+		(void) common_cgroup_delete(&g_user_cg);
+	_unlock();
+
+	common_cgroup_destroy(&g_job_cg);
+	common_cgroup_destroy(&g_user_cg);
+
+	return SLURM_SUCCESS;
+}
+
+/* Append the pids of cgroup path and of all its descendants */
+static void _get_pids_recursive(char *path, pid_t **pids, int *npids)
+{
+	char *file = xstrdup_printf("%s/cgroup.procs", path);
+	struct dirent *ent;
+	pid_t *tmp = NULL;
+	int ntmp = 0;
+	DIR *dir;
+
+	if ((common_file_read_uint32s(file, (uint32_t **) &tmp, &ntmp) ==
+	     SLURM_SUCCESS) && ntmp) {
+		xrecalloc(*pids, *npids + ntmp, sizeof(pid_t));
+		memcpy(*pids + *npids, tmp, ntmp * sizeof(pid_t));
+		*npids += ntmp;
+	}
+	xfree(tmp);
+	xfree(file);
+
+	if (!(dir = opendir(path)))
+		return;
+	while ((ent = readdir(dir))) {
+		char *child;
+
+		if ((ent->d_type != DT_DIR) || !xstrcmp(ent->d_name, ".") ||
+		    !xstrcmp(ent->d_name, ".."))
+			continue;
+		child = xstrdup_printf("%s/%s", path, ent->d_name);
+		_get_pids_recursive(child, pids, npids);
+		xfree(child);
+	}
+	closedir(dir);
+}
+
+/* Read the value of key in a flat keyed file such as memory.events */
+static uint64_t _get_key_value(xcgroup_t *cg, char *param, char *key)
+{
+	char *content = NULL, *ptr;
+	uint64_t value = NO_VAL64;
+	size_t size, len = strlen(key);
+
+	if (common_cgroup_get_param(cg, param, &content, &size) !=
+	    SLURM_SUCCESS)
+		return NO_VAL64;
+
+	for (ptr = content; ptr && *ptr; ptr = xstrchr(ptr, '\n')) {
+		if (*ptr == '\n')
+			ptr++;
+		if (!xstrncmp(ptr, key, len) && (ptr[len] == ' ')) {
+			sscanf(ptr + len + 1, "%"SCNu64, &value);
+			break;
+		}
+	}
+	xfree(content);
+
+	return value;
+}
+
+/* Read the "some" stall total of a pressure stall information file */
+static uint64_t _get_pressure(xcgroup_t *cg, char *param)
+{
+	char *content = NULL, *ptr;
+	uint64_t value = NO_VAL64;
+	size_t size;
+
+	if (common_cgroup_get_param(cg, param, &content, &size) !=
+	    SLURM_SUCCESS)
+		return NO_VAL64;
+
+	if (!xstrncmp(content, "some", 4) &&
+	    (ptr = xstrstr(content, "total=")))
+		sscanf(ptr + 6, "%"SCNu64, &value);
+	xfree(content);
+
+	return value;
+}
+
+static int _set_memory_limits(xcgroup_t *cg, cgroup_limits_t *limits)
+{
+	int rc;
+
+	rc = common_cgroup_set_uint64_param(cg, "memory.max",
+					    limits->limit_in_bytes);
+	rc += common_cgroup_set_uint64_param(cg, "memory.high",
+					     limits->soft_limit_in_bytes);
+
+	/* memory.swap.max only accounts for swap, not memory + swap */
+	if (limits->memsw_limit_in_bytes != NO_VAL64)
+		rc += common_cgroup_set_uint64_param(
+			cg, "memory.swap.max",
+			(limits->memsw_limit_in_bytes >
+			 limits->limit_in_bytes) ?
+			(limits->memsw_limit_in_bytes -
+			 limits->limit_in_bytes) : 0);
+
+	if (limits->kmem_limit_in_bytes != NO_VAL64)
+		log_flag(CGROUP, "kernel memory is accounted as memory in cgroup v2, ignoring kmem limit for %s",
+			 cg->path);
+
+	return rc;
+}
+
+static int _set_cpuset_limits(xcgroup_t *cg, cgroup_limits_t *limits)
+{
+	int rc;
+
+	rc = common_cgroup_set_param(cg, "cpuset.cpus", limits->allow_cores);
+	rc += common_cgroup_set_param(cg, "cpuset.mems", limits->allow_mems);
+
+	return rc;
+}
+
+extern int init(void)
+{
+	for (int i = 0; i < CG_CTL_CNT; i++)
+		g_step_active_cnt[i] = 0;
+	FREE_NULL_LIST(g_task_list);
+	g_task_list = list_create(_free_task_cg_info);
+
+	if ((g_hertz = sysconf(_SC_CLK_TCK)) < 1)
+		g_hertz = 100;
+
+	debug("%s loaded", plugin_name);
+	return SLURM_SUCCESS;
+}
+
+extern int fini(void)
+{
+	FREE_NULL_LIST(g_task_list);
+	common_cgroup_destroy(&g_slurm_cg);
+	common_cgroup_destroy(&g_root_cg);
+	common_cgroup_ns_destroy(&g_cg_ns);
+
+	debug("unloading %s", plugin_name);
+	return SLURM_SUCCESS;
+}
+
+extern int cgroup_p_initialize(cgroup_ctl_type_t sub)
+{
+	if (sub >= CG_CTL_CNT)
+		return SLURM_ERROR;
+
+	if (_ns_init() != SLURM_SUCCESS)
+		return SLURM_ERROR;
+
+	if (sub == CG_DEVICES) {
+		error("ConstrainDevices is not supported with %s",
+		      plugin_type);
+		return SLURM_ERROR;
+	}
+
+	if (g_ctl_name[sub] &&
+	    !_has_controller(&g_root_cg, "cgroup.controllers",
+			     g_ctl_name[sub])) {
+		error("%s controller is not available in %s",
+		      g_ctl_name[sub], g_root_cg.path);
+		return SLURM_ERROR;
+	}
+
+	g_ctl_mask |= (1 << sub);
+
+	return SLURM_SUCCESS;
+}
+
+extern int cgroup_p_system_create(cgroup_ctl_type_t sub)
+{
+	char *sys_cgpath = NULL;
+	int rc = SLURM_SUCCESS;
+
+	switch (sub) {
+	case CG_CPUS:
+	case CG_MEMORY:
+		break;
+	default:
+		error("cgroup subsystem %u not supported", sub);
+		return SLURM_ERROR;
+	}
+
+	/* Both controllers share the same system cgroup */
+	if (g_sys_cg.path)
+		return SLURM_SUCCESS;
+
+	if ((rc = _slurm_cg_create()) != SLURM_SUCCESS)
+		return rc;
+
+	xstrfmtcat(sys_cgpath, "%s/system", g_slurm_cg.name);
+	if (_create_cg(&g_sys_cg, sys_cgpath, 0, 0) < 0)
+		rc = SLURM_ERROR;
+	xfree(sys_cgpath);
+
+	return rc;
+}
+
+extern int cgroup_p_system_addto(cgroup_ctl_type_t sub, pid_t *pids, int npids)
+{
+	switch (sub) {
+	case CG_CPUS:
+	case CG_MEMORY:
+		break;
+	default:
+		error("cgroup subsystem %u not supported", sub);
+		return SLURM_ERROR;
+	}
+
+	return common_cgroup_add_pids(&g_sys_cg, pids, npids);
+}
+
+extern int cgroup_p_system_destroy(cgroup_ctl_type_t sub)
+{
+	int rc;
+
+	/* Another plugin may have already destroyed it. */
+	if (!g_sys_cg.path)
+		return SLURM_SUCCESS;
+
+	if ((rc = common_cgroup_move_process(&g_root_cg, getpid()))
+	    != SLURM_SUCCESS) {
+		error("Unable to move pid %d to root cgroup", getpid());
+		return rc;
+	}
+
+	if ((rc = common_cgroup_delete(&g_sys_cg)) != SLURM_SUCCESS) {
+		log_flag(CGROUP, "not removing system cg, there may be attached stepds: %m");
+		return rc;
+	}
+	common_cgroup_destroy(&g_sys_cg);
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * The step directories are shared by all the controllers, create them on the
+ * first call and only count the users afterwards.
+ */
+extern int cgroup_p_step_create(cgroup_ctl_type_t sub, stepd_step_rec_t *job)
+{
+	if (sub >= CG_CTL_CNT)
+		return SLURM_ERROR;
+
+	if (!_active_cnt() &&
+	    (_step_hierarchy_create(job) != SLURM_SUCCESS))
+		return SLURM_ERROR;
+
+	/* we use slurmstepd pid as the identifier of the container */
+	if (sub == CG_TRACK)
+		job->cont_id = (uint64_t)job->jmgr_pid;
+
+	g_step_active_cnt[sub]++;
+
+	return SLURM_SUCCESS;
+}
+
+extern int cgroup_p_step_addto(cgroup_ctl_type_t sub, pid_t *pids, int npids)
+{
+	if (!g_special_cg.path)
+		return SLURM_ERROR;
+
+	if (sub == CG_CPUACCT) {
+		error("This operation is not supported for cpuacct");
+		return SLURM_ERROR;
+	}
+
+	return common_cgroup_add_pids(&g_special_cg, pids, npids);
+}
+
+extern int cgroup_p_step_get_pids(pid_t **pids, int *npids)
+{
+	if (!g_step_cg.path)
+		return SLURM_ERROR;
+
+	*pids = NULL;
+	*npids = 0;
+	_get_pids_recursive(g_step_cg.path, pids, npids);
+
+	return SLURM_SUCCESS;
+}
+
+extern int cgroup_p_step_suspend(void)
+{
+	if (!g_step_cg.path)
+		return SLURM_ERROR;
+
+	return common_cgroup_set_param(&g_step_cg, "cgroup.freeze", "1");
+}
+
+extern int cgroup_p_step_resume(void)
+{
+	if (!g_step_cg.path)
+		return SLURM_ERROR;
+
+	return common_cgroup_set_param(&g_step_cg, "cgroup.freeze", "0");
+}
+
+extern int cgroup_p_step_destroy(cgroup_ctl_type_t sub)
+{
+	int rc;
+
+	if (g_step_active_cnt[sub] == 0) {
+		error("called without a previous init. This shouldn't happen!");
+		return SLURM_SUCCESS;
+	}
+
+	if (_active_cnt() > 1) {
+		/*
+		 * proctrack relies on this failing while there are processes
+		 * left in the step.
+		 */
+		if (sub == CG_TRACK) {
+			pid_t *pids = NULL;
+			int npids = 0;
+
+			_get_pids_recursive(g_step_cg.path, &pids, &npids);
+			xfree(pids);
+			if (npids)
+				return SLURM_ERROR;
+		}
+		g_step_active_cnt[sub]--;
+		log_flag(CGROUP, "Not destroying step dir, resource busy by %d other plugin",
+			 _active_cnt());
+		return SLURM_SUCCESS;
+	}
+
+	if ((rc = _step_hierarchy_destroy()) == SLURM_SUCCESS)
+		g_step_active_cnt[sub] = 0;
+
+	return rc;
+}
+
+extern bool cgroup_p_has_pid(pid_t pid)
+{
+	char *file = NULL, *content = NULL, *ptr;
+	size_t size, len;
+	bool rc = false;
+
+	if (!g_step_cg.name)
+		return false;
+
+	file = xstrdup_printf("/proc/%d/cgroup", pid);
+	if (common_file_read_content(file, &content, &size) != SLURM_SUCCESS) {
+		xfree(file);
+		return false;
+	}
+	xfree(file);
+
+	/* The unified hierarchy line is "0::<path>" */
+	len = strlen(g_step_cg.name);
+	if ((ptr = xstrstr(content, "0::")) &&
+	    !xstrncmp(ptr + 3, g_step_cg.name, len) &&
+	    ((ptr[3 + len] == '/') || (ptr[3 + len] == '\n')))
+		rc = true;
+	xfree(content);
+
+	return rc;
+}
+
+extern cgroup_limits_t *cgroup_p_root_constrain_get(cgroup_ctl_type_t sub)
+{
+	int rc = SLURM_SUCCESS;
+	cgroup_limits_t *limits = xmalloc(sizeof(*limits));
+
+	switch (sub) {
+	case CG_TRACK:
+		break;
+	case CG_CPUS:
+		/* The root cgroup only has the effective values */
+		rc = common_cgroup_get_param(&g_root_cg,
+					     "cpuset.cpus.effective",
+					     &limits->allow_cores,
+					     &limits->cores_size);
+		rc += common_cgroup_get_param(&g_root_cg,
+					      "cpuset.mems.effective",
+					      &limits->allow_mems,
+					      &limits->mems_size);
+
+		if (limits->cores_size > 0)
+			limits->allow_cores[(limits->cores_size)-1] = '\0';
+
+		if (limits->mems_size > 0)
+			limits->allow_mems[(limits->mems_size)-1] = '\0';
+
+		if (rc != SLURM_SUCCESS)
+			goto fail;
+		break;
+	case CG_MEMORY:
+	case CG_DEVICES:
+		break;
+	default:
+		error("cgroup subsystem %u not supported", sub);
+		rc = SLURM_ERROR;
+		break;
+	}
+
+	return limits;
+fail:
+	cgroup_free_limits(limits);
+	return NULL;
+}
+
+extern int cgroup_p_root_constrain_set(cgroup_ctl_type_t sub,
+				       cgroup_limits_t *limits)
+{
+	if (!limits)
+		return SLURM_ERROR;
+
+	/* There is no memory.swappiness in cgroup v2 */
+	if ((sub == CG_MEMORY) && (limits->swappiness != NO_VAL64))
+		log_flag(CGROUP, "MemorySwappiness is not supported in cgroup v2, ignoring it");
+
+	return SLURM_SUCCESS;
+}
+
+extern cgroup_limits_t *cgroup_p_system_constrain_get(cgroup_ctl_type_t sub)
+{
+	return NULL;
+}
+
+extern int cgroup_p_system_constrain_set(cgroup_ctl_type_t sub,
+					 cgroup_limits_t *limits)
+{
+	int rc = SLURM_SUCCESS;
+
+	if (!limits)
+		return SLURM_ERROR;
+
+	switch (sub) {
+	case CG_TRACK:
+		break;
+	case CG_CPUS:
+		rc = common_cgroup_set_param(&g_sys_cg, "cpuset.cpus",
+					     limits->allow_cores);
+		break;
+	case CG_MEMORY:
+		common_cgroup_set_uint64_param(&g_sys_cg, "memory.max",
+					       limits->limit_in_bytes);
+		/* Same as memory.oom_control=1 in v1, do not kill slurmd */
+		common_cgroup_set_uint64_param(&g_sys_cg, "memory.oom.group",
+					       0);
+		break;
+	case CG_DEVICES:
+		break;
+	default:
+		error("cgroup subsystem %u not supported", sub);
+		rc = SLURM_ERROR;
+		break;
+	}
+
+	return rc;
+}
+
+extern int cgroup_p_user_constrain_set(cgroup_ctl_type_t sub,
+				       stepd_step_rec_t *job,
+				       cgroup_limits_t *limits)
+{
+	if (!limits)
+		return SLURM_ERROR;
+
+	if (sub == CG_CPUS)
+		return _set_cpuset_limits(&g_user_cg, limits);
+
+	return SLURM_SUCCESS;
+}
+
+extern int cgroup_p_job_constrain_set(cgroup_ctl_type_t sub,
+				      stepd_step_rec_t *job,
+				      cgroup_limits_t *limits)
+{
+	if (!limits)
+		return SLURM_ERROR;
+
+	switch (sub) {
+	case CG_CPUS:
+		return _set_cpuset_limits(&g_job_cg, limits);
+	case CG_MEMORY:
+		return _set_memory_limits(&g_job_cg, limits);
+	case CG_DEVICES:
+		error("ConstrainDevices is not supported with %s",
+		      plugin_type);
+		return SLURM_ERROR;
+	default:
+		break;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+extern int cgroup_p_step_constrain_set(cgroup_ctl_type_t sub,
+				       stepd_step_rec_t *job,
+				       cgroup_limits_t *limits)
+{
+	if (!limits)
+		return SLURM_ERROR;
+
+	switch (sub) {
+	case CG_CPUS:
+		return _set_cpuset_limits(&g_step_cg, limits);
+	case CG_MEMORY:
+		return _set_memory_limits(&g_step_cg, limits);
+	case CG_DEVICES:
+		error("ConstrainDevices is not supported with %s",
+		      plugin_type);
+		return SLURM_ERROR;
+	default:
+		break;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+extern int cgroup_p_task_constrain_set(cgroup_ctl_type_t sub,
+				       cgroup_limits_t *limits,
+				       uint32_t taskid)
+{
+	if (!limits)
+		return SLURM_ERROR;
+
+	if (sub == CG_DEVICES) {
+		error("ConstrainDevices is not supported with %s",
+		      plugin_type);
+		return SLURM_ERROR;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * memory.events keeps the count of OOM kills of the cgroup and its
+ * descendants, so there is no need for a monitoring thread as in cgroup v1.
+ */
+extern int cgroup_p_step_start_oom_mgr(void)
+{
+	if (!g_step_cg.path)
+		return SLURM_ERROR;
+
+	g_oom_kill_start = _get_key_value(&g_step_cg, "memory.events",
+					  "oom_kill");
+	if (g_oom_kill_start == NO_VAL64) {
+		error("Unable to read OOM events from %s", g_step_cg.path);
+		return SLURM_ERROR;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+static uint64_t _events(xcgroup_t *cg, char *param, char *key)
+{
+	uint64_t value = _get_key_value(cg, param, key);
+
+	return (value == NO_VAL64) ? 0 : value;
+}
+
+extern cgroup_oom_t *cgroup_p_step_stop_oom_mgr(stepd_step_rec_t *job)
+{
+	cgroup_oom_t *results;
+	uint64_t oom_kill;
+
+	if (g_oom_kill_start == NO_VAL64) {
+		log_flag(CGROUP, "OOM events were not monitored for %ps",
+			 &job->step_id);
+		return NULL;
+	}
+
+	results = xmalloc(sizeof(*results));
+	results->step_mem_failcnt = _events(&g_step_cg, "memory.events",
+					    "max");
+	results->step_memsw_failcnt = _events(&g_step_cg,
+					      "memory.swap.events", "max");
+	results->job_mem_failcnt = _events(&g_job_cg, "memory.events", "max");
+	results->job_memsw_failcnt = _events(&g_job_cg, "memory.swap.events",
+					     "max");
+
+	oom_kill = _events(&g_step_cg, "memory.events", "oom_kill");
+	if (oom_kill > g_oom_kill_start)
+		results->oom_kill_cnt = oom_kill - g_oom_kill_start;
+	g_oom_kill_start = NO_VAL64;
+
+	return results;
+}
+
+/***************************************
+ ***** CGROUP TASK FUNCTIONS *****
+ **************************************/
+extern int cgroup_p_task_addto(cgroup_ctl_type_t sub, stepd_step_rec_t *job,
+			       pid_t pid, uint32_t task_id)
+{
+	task_cg_info_t *task_cg_info;
+	char *uri = NULL;
+	int rc;
+
+	if (!g_step_cg.path)
+		return SLURM_ERROR;
+
+	/* All the controllers share the task cgroup, only create it once */
+	if (!(task_cg_info = list_find_first(g_task_list, _find_task_cg_info,
+					     &task_id))) {
+		xstrfmtcat(uri, "%s/task_%u", g_step_cg.name, task_id);
+		task_cg_info = xmalloc(sizeof(*task_cg_info));
+		task_cg_info->taskid = task_id;
+		if (_create_cg(&task_cg_info->task_cg, uri, job->uid,
+			       job->gid) < 0) {
+			error("unable to create task %u cgroup", task_id);
+			xfree(task_cg_info);
+			xfree(uri);
+			return SLURM_ERROR;
+		}
+		xfree(uri);
+		list_append(g_task_list, task_cg_info);
+	}
+
+	if (task_cg_info->pid == pid)
+		return SLURM_SUCCESS;
+
+	if ((rc = common_cgroup_move_process(&task_cg_info->task_cg, pid))
+	    != SLURM_SUCCESS)
+		error("Unable to move pid %d to %s cg",
+		      pid, task_cg_info->task_cg.path);
+	else
+		task_cg_info->pid = pid;
+
+	log_flag(CGROUP, "%ps taskid %u pid %d", &job->step_id, task_id, pid);
+
+	return rc;
+}
+
+extern cgroup_acct_t *cgroup_p_task_get_acct_data(uint32_t taskid)
+{
+	task_cg_info_t *task_cg_info;
+	xcgroup_t *cg;
+	cgroup_acct_t *stats;
+	uint64_t usec;
+
+	if (!(task_cg_info = list_find_first(g_task_list, _find_task_cg_info,
+					     &taskid))) {
+		error("Could not find task_cg for task %u, this should never happen",
+		      taskid);
+		return NULL;
+	}
+	cg = &task_cg_info->task_cg;
+
+	stats = xmalloc(sizeof(*stats));
+
+	/* cpu.stat is in microseconds, callers expect clock ticks */
+	if ((usec = _get_key_value(cg, "cpu.stat", "user_usec")) != NO_VAL64)
+		stats->usec = (usec * g_hertz) / USEC_IN_SEC;
+	else
+		stats->usec = NO_VAL64;
+	if ((usec = _get_key_value(cg, "cpu.stat", "system_usec")) !=
+	    NO_VAL64)
+		stats->ssec = (usec * g_hertz) / USEC_IN_SEC;
+	else
+		stats->ssec = NO_VAL64;
+
+	stats->total_rss = _get_key_value(cg, "memory.stat", "anon");
+	stats->total_pgmajfault = _get_key_value(cg, "memory.stat",
+						 "pgmajfault");
+
+	stats->cpu_pressure_usec = _get_pressure(cg, "cpu.pressure");
+	stats->mem_pressure_usec = _get_pressure(cg, "memory.pressure");
+	stats->io_pressure_usec = _get_pressure(cg, "io.pressure");
+
+	stats->mem_high_events = _get_key_value(cg, "memory.events", "high");
+	stats->mem_max_events = _get_key_value(cg, "memory.events", "max");
+	stats->oom_kill_cnt = _get_key_value(cg, "memory.events", "oom_kill");
+
+	return stats;
+}
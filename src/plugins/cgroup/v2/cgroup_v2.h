@@ -0,0 +1,116 @@
+/*****************************************************************************\
+ *  cgroup_v2.h - Cgroup v2 plugin
+ *****************************************************************************
+ *  Copyright (C) 2021 agent <agent@local>
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _CGROUP_V2_H
+#define _CGROUP_V2_H
+
+#define _GNU_SOURCE
+
+#include "slurm/slurm.h"
+#include "slurm/slurm_errno.h"
+
+#include "src/common/cgroup.h"
+#include "src/common/list.h"
+#include "src/common/log.h"
+#include "src/common/xassert.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include "src/slurmd/slurmd/slurmd.h"
+#include "src/slurmd/slurmstepd/slurmstepd_job.h"
+#include "src/plugins/cgroup/common/cgroup_common.h"
+
+/*
+ * The cgroup/v2 plugin implements the same interface as cgroup/v1, see
+ * cgroup_v1.h for the description of every function. The differences are:
+ *
+ * - All the controllers share one hierarchy under CgroupMountpoint. The step
+ *   directories are created once, whatever the number of controllers used,
+ *   and the controllers are enabled with one write to cgroup.subtree_control
+ *   per level. Each cgroup_p_step_create() call still counts as one user of
+ *   the step directories.
+ *
+ * - The hierarchy is <CgroupPrepend>/uid_<uid>/job_<jobid>/step_<stepid>/
+ *   and, as processes may only live in leaves, the pids added to the step go
+ *   to step_<stepid>/task_special and the tasks to step_<stepid>/task_<id>.
+ *
+ * - CG_TRACK uses cgroup.freeze and CG_CPUACCT uses cpu.stat, which do not
+ *   need any controller. CG_DEVICES needs eBPF programs and is not supported.
+ *
+ * - OOM events are read from memory.events at the start and the end of the
+ *   step instead of being monitored by a thread.
+ *
+ * - cgroup_p_task_get_acct_data() also returns the pressure stall (PSI) totals
+ *   and the memory.events counters of the task.
+ */
+
+extern int init(void);
+extern int fini(void);
+
+extern int cgroup_p_initialize(cgroup_ctl_type_t sub);
+extern int cgroup_p_system_create(cgroup_ctl_type_t sub);
+extern int cgroup_p_system_addto(cgroup_ctl_type_t sub, pid_t *pids, int npids);
+extern int cgroup_p_system_destroy(cgroup_ctl_type_t sub);
+extern int cgroup_p_step_create(cgroup_ctl_type_t sub, stepd_step_rec_t *job);
+extern int cgroup_p_step_addto(cgroup_ctl_type_t sub, pid_t *pids, int npids);
+extern int cgroup_p_step_get_pids(pid_t **pids, int *npids);
+extern int cgroup_p_step_suspend(void);
+extern int cgroup_p_step_resume(void);
+extern int cgroup_p_step_destroy(cgroup_ctl_type_t sub);
+extern bool cgroup_p_has_pid(pid_t pid);
+extern cgroup_limits_t *cgroup_p_root_constrain_get(cgroup_ctl_type_t sub);
+extern int cgroup_p_root_constrain_set(cgroup_ctl_type_t sub,
+				       cgroup_limits_t *limits);
+extern cgroup_limits_t *cgroup_p_system_constrain_get(cgroup_ctl_type_t sub);
+extern int cgroup_p_system_constrain_set(cgroup_ctl_type_t sub,
+					 cgroup_limits_t *limits);
+extern int cgroup_p_user_constrain_set(cgroup_ctl_type_t sub,
+				       stepd_step_rec_t *job,
+				       cgroup_limits_t *limits);
+extern int cgroup_p_job_constrain_set(cgroup_ctl_type_t sub,
+				      stepd_step_rec_t *job,
+				      cgroup_limits_t *limits);
+extern int cgroup_p_step_constrain_set(cgroup_ctl_type_t sub,
+				       stepd_step_rec_t *job,
+				       cgroup_limits_t *limits);
+extern int cgroup_p_task_constrain_set(cgroup_ctl_type_t sub,
+				       cgroup_limits_t *limits,
+				       uint32_t taskid);
+extern int cgroup_p_step_start_oom_mgr(void);
+extern cgroup_oom_t *cgroup_p_step_stop_oom_mgr(stepd_step_rec_t *job);
+extern int cgroup_p_task_addto(cgroup_ctl_type_t sub, stepd_step_rec_t *job,
+			       pid_t pid, uint32_t task_id);
+extern cgroup_acct_t *cgroup_p_task_get_acct_data(uint32_t taskid);
+
+#endif /* !_CGROUP_V2_H */
@@ -83,6 +83,7 @@ const char plugin_type[] = "jobacct_gather/cgroup";
 const uint32_t plugin_version = SLURM_VERSION_NUMBER;
 
 static bool is_first_task = true;
+static bool cgroup_sampling = false;
 
 static void _prec_extra(jag_prec_t *prec, uint32_t taskid)
 {
@@ -127,6 +128,16 @@ static void _prec_extra(jag_prec_t *prec, uint32_t taskid)
 			cgroup_acct_data->total_pgmajfault;
 	}
 
+	/* Only cgroup/v2 gives pressure stall information */
+	if (cgroup_acct_data->cpu_pressure_usec != NO_VAL64)
+		log_flag(JAG, "task %u pressure cpu:%"PRIu64" mem:%"PRIu64" io:%"PRIu64" usec, memory events high:%"PRIu64" max:%"PRIu64" oom_kill:%"PRIu64,
+			 taskid, cgroup_acct_data->cpu_pressure_usec,
+			 cgroup_acct_data->mem_pressure_usec,
+			 cgroup_acct_data->io_pressure_usec,
+			 cgroup_acct_data->mem_high_events,
+			 cgroup_acct_data->mem_max_events,
+			 cgroup_acct_data->oom_kill_cnt);
+
 	xfree(cgroup_acct_data);
 	return;
 }
@@ -140,6 +151,10 @@ extern int init (void)
 	if (running_in_slurmstepd()) {
 		jag_common_init(0);
 
+		if (xstrcasestr(slurm_conf.job_acct_gather_params,
+				"CgroupSampling"))
+			cgroup_sampling = true;
+
 		if (xcpuinfo_init() != XCPUINFO_SUCCESS) {
 			return SLURM_ERROR;
 		}
@@ -181,6 +196,9 @@ extern int fini (void)
  * IN/OUT: task_list - list containing current processes.
  * IN: pgid_plugin - if we are running with the pgid plugin.
  * IN: cont_id - container id of processes if not running with pgid.
+ * IN: profile - true to also send the data to the profile plugin, false for
+ *		on demand requests (sstat).
+ * IN: final - true for the last poll before a task is removed.
  *
  * OUT:	none
  *
@@ -193,7 +211,8 @@ extern int fini (void)
  *    wrong.
  */
 extern void jobacct_gather_p_poll_data(List task_list, bool pgid_plugin,
-				       uint64_t cont_id, bool profile)
+				       uint64_t cont_id, bool profile,
+				       bool final)
 {
 	static jag_callbacks_t callbacks;
 	static bool first = 1;
@@ -204,8 +223,19 @@ extern void jobacct_gather_p_poll_data(List task_list, bool pgid_plugin,
 		callbacks.prec_extra = _prec_extra;
 	}
 
+	/*
+	 * With CgroupSampling the periodic polls only read the aggregate
+	 * counters of each task cgroup.  The /proc walk, which also gives
+	 * virtual memory and disk usage, is only done on demand (sstat) and
+	 * by the final poll of each task, so its maximums are always recorded.
+	 */
+	if (cgroup_sampling && profile && !final)
+		callbacks.get_precs = jag_common_get_task_precs;
+	else
+		callbacks.get_precs = NULL;
+
 	jag_common_poll_data(task_list, pgid_plugin, cont_id, &callbacks,
-			     profile);
+			     profile, final);
 
 	return;
 }
@@ -49,10 +49,12 @@
 #include "src/common/slurm_jobacct_gather.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_protocol_defs.h"
+#include "src/common/run_in_daemon.h"
 #include "src/common/slurm_acct_gather_energy.h"
 #include "src/common/slurm_acct_gather_filesystem.h"
 #include "src/common/slurm_acct_gather_interconnect.h"
 #include "src/common/xstring.h"
+#include "src/slurmd/common/jag_sampler.h"
 #include "src/slurmd/common/proctrack.h"
 
 #include "common_jag.h"
@@ -77,6 +79,13 @@ List prec_list = NULL;
 static int my_pagesize = 0;
 static DIR  *slash_proc = NULL;
 static int energy_profile = ENERGY_DATA_NODE_ENERGY_UP;
+static bool use_sampler = false;
+static bool poll_final = false;	/* last poll of a task, read /proc */
+
+/* Per-poll cost, index 0 is the per process sampling, 1 the per-task one */
+static uint32_t poll_cnt[2] = { 0, 0 };
+static uint64_t poll_usec[2] = { 0, 0 };
+static uint64_t poll_usec_max[2] = { 0, 0 };
 
 static int _find_prec(void *x, void *key)
 {
@@ -498,6 +507,65 @@ static int _init_tres(jag_prec_t *prec, void *empty)
 	return SLURM_SUCCESS;
 }
 
+static jag_prec_t *_create_prec(int tres_count)
+{
+	jag_prec_t *prec = xmalloc(sizeof(jag_prec_t));
+
+	if (!tres_count) {
+		assoc_mgr_lock_t locks = {
+			NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
+			READ_LOCK, NO_LOCK, NO_LOCK };
+		assoc_mgr_lock(&locks);
+		tres_count = g_tres_count;
+		assoc_mgr_unlock(&locks);
+	}
+
+	prec->tres_count = tres_count;
+	prec->tres_data = xmalloc(prec->tres_count *
+				  sizeof(acct_gather_data_t));
+
+	(void)_init_tres(prec, NULL);
+
+	return prec;
+}
+
+/*
+ * Same as _handle_stats() but from the record published by slurmd.
+ * RET false if slurmd has no sample of the process
+ */
+static bool _handle_sample(jag_sample_t *sample, int tres_count)
+{
+	jag_prec_t *prec;
+
+	if (!sample)
+		return false;
+
+	prec = _create_prec(tres_count);
+	prec->pid = sample->pid;
+	prec->ppid = sample->ppid;
+	prec->last_cpu = sample->last_cpu;
+	prec->usec = (double)sample->utime;
+	prec->ssec = (double)sample->stime;
+	prec->tres_data[TRES_ARRAY_PAGES].size_read = sample->majflt;
+	prec->tres_data[TRES_ARRAY_VMEM].size_read = sample->vsize;
+	prec->tres_data[TRES_ARRAY_MEM].size_read = sample->rss;
+	prec->tres_data[TRES_ARRAY_FS_DISK].size_read = sample->rchar;
+	prec->tres_data[TRES_ARRAY_FS_DISK].size_write = sample->wchar;
+
+	if (acct_gather_filesystem_g_get_data(prec->tres_data) < 0) {
+		log_flag(JAG, "problem retrieving filesystem data");
+	}
+
+	if (acct_gather_interconnect_g_get_data(prec->tres_data) < 0) {
+		log_flag(JAG, "problem retrieving interconnect data");
+	}
+
+	destroy_jag_prec(list_remove_first(prec_list, _find_prec, &prec->pid));
+	list_append(prec_list, prec);
+
+	return true;
+}
+
 static void _handle_stats(char *proc_stat_file, char *proc_io_file,
 			  char *proc_smaps_file, jag_callbacks_t *callbacks,
 			  int tres_count)
@@ -537,22 +605,7 @@ static void _handle_stats(char *proc_stat_file, char *proc_io_file,
 	if (fcntl(fd, F_SETFD, FD_CLOEXEC) == -1)
 		error("%s: fcntl(%s): %m", __func__, proc_stat_file);
 
-	prec = xmalloc(sizeof(jag_prec_t));
-
-	if (!tres_count) {
-		assoc_mgr_lock_t locks = {
-			NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
-			READ_LOCK, NO_LOCK, NO_LOCK };
-		assoc_mgr_lock(&locks);
-		tres_count = g_tres_count;
-		assoc_mgr_unlock(&locks);
-	}
-
-	prec->tres_count = tres_count;
-	prec->tres_data = xmalloc(prec->tres_count *
-				  sizeof(acct_gather_data_t));
-
-	(void)_init_tres(prec, NULL);
+	prec = _create_prec(tres_count);
 
 	if (!_get_process_data_line(fd, prec)) {
 		fclose(stat_fp);
@@ -607,11 +660,19 @@ static List _get_precs(List task_list, bool pgid_plugin, uint64_t cont_id,
 	static	int	slash_proc_open = 0;
 	int i;
 	struct jobacctinfo *jobacct = NULL;
+	jag_samples_t *samples = NULL;
 
 	xassert(task_list);
 
 	jobacct = list_peek(task_list);
 
+	/*
+	 * Read /proc if slurmd has no recent samples, and on the final poll
+	 * of a task whose usage since the last sample would otherwise be lost
+	 */
+	if (use_sampler && !poll_final)
+		samples = jag_sampler_open();
+
 	if (!pgid_plugin) {
 		pid_t *pids = NULL;
 		int npids = 0;
@@ -639,6 +700,11 @@ static List _get_precs(List task_list, bool pgid_plugin, uint64_t cont_id,
 			goto finished;
 		}
 		for (i = 0; i < npids; i++) {
+			if (samples &&
+			    _handle_sample(jag_sampler_find(samples, pids[i]),
+					   jobacct ? jobacct->tres_count : 0))
+				continue;
+			/* Not sampled yet (e.g. started since) or a thread */
 			snprintf(proc_stat_file, 256, "/proc/%d/stat", pids[i]);
 			snprintf(proc_io_file, 256, "/proc/%d/io", pids[i]);
 			snprintf(proc_smaps_file, 256, "/proc/%d/smaps", pids[i]);
@@ -647,6 +713,10 @@ static List _get_precs(List task_list, bool pgid_plugin, uint64_t cont_id,
 				      jobacct ? jobacct->tres_count : 0);
 		}
 		xfree(pids);
+	} else if (samples) {
+		for (i = 0; i < samples->sample_cnt; i++)
+			_handle_sample(&samples->samples[i],
+				       jobacct ? jobacct->tres_count : 0);
 	} else {
 		struct dirent *slash_proc_entry;
 		char  *iptr = NULL, *optr = NULL, *optr2 = NULL;
@@ -739,6 +809,47 @@ static List _get_precs(List task_list, bool pgid_plugin, uint64_t cont_id,
 	}
 
 finished:
+	jag_sampler_close(samples);
+
+	return prec_list;
+}
+
+/*
+ * Build one record per task without looking at /proc.  The records only carry
+ * the task's pid and the node wide filesystem/interconnect counters, the cpu
+ * and memory usage is expected to be filled in by callbacks->prec_extra()
+ * from an aggregate source such as the task's cgroup.
+ */
+extern List jag_common_get_task_precs(List task_list, bool pgid_plugin,
+				      uint64_t cont_id,
+				      jag_callbacks_t *callbacks)
+{
+	struct jobacctinfo *jobacct = NULL;
+	ListIterator itr;
+	jag_prec_t *prec;
+
+	xassert(task_list);
+
+	itr = list_iterator_create(task_list);
+	while ((jobacct = list_next(itr))) {
+		if (!(prec = list_find_first(prec_list, _find_prec,
+					     &jobacct->pid))) {
+			prec = xmalloc(sizeof(jag_prec_t));
+			prec->pid = jobacct->pid;
+			prec->tres_count = jobacct->tres_count;
+			prec->tres_data = xcalloc(prec->tres_count,
+						  sizeof(acct_gather_data_t));
+			(void)_init_tres(prec, NULL);
+			list_append(prec_list, prec);
+		}
+
+		if (acct_gather_filesystem_g_get_data(prec->tres_data) < 0)
+			log_flag(JAG, "problem retrieving filesystem data");
+
+		if (acct_gather_interconnect_g_get_data(prec->tres_data) < 0)
+			log_flag(JAG, "problem retrieving interconnect data");
+	}
+	list_iterator_destroy(itr);
 
 	return prec_list;
 }
@@ -885,10 +996,21 @@ extern void jag_common_init(long in_hertz)
 	}
 
 	my_pagesize = getpagesize();
+
+	if (running_in_slurmstepd() && jag_sampler_enabled())
+		use_sampler = true;
 }
 
 extern void jag_common_fini(void)
 {
+	for (int i = 0; i < 2; i++) {
+		if (!poll_cnt[i])
+			continue;
+		log_flag(JAG, "%s: %u polls, average %"PRIu64" usec, max %"PRIu64" usec",
+			 i ? "task sampling" : "process sampling", poll_cnt[i],
+			 poll_usec[i] / poll_cnt[i], poll_usec_max[i]);
+	}
+
 	FREE_NULL_LIST(prec_list);
 
 	if (slash_proc)
@@ -937,7 +1059,7 @@ static void _print_jag_prec(jag_prec_t *prec)
 
 extern void jag_common_poll_data(
 	List task_list, bool pgid_plugin, uint64_t cont_id,
-	jag_callbacks_t *callbacks, bool profile)
+	jag_callbacks_t *callbacks, bool profile, bool final)
 {
 	/* Update the data */
 	uint64_t total_job_mem = 0, total_job_vsize = 0;
@@ -949,7 +1071,8 @@ extern void jag_common_poll_data(
 	char sbuf[72];
 	int energy_counted = 0;
 	time_t ct;
-	int i = 0;
+	int i = 0, sampling;
+	DEF_TIMERS;
 
 	xassert(callbacks);
 
@@ -966,11 +1089,15 @@ extern void jag_common_poll_data(
 
 	if (!callbacks->get_precs)
 		callbacks->get_precs = _get_precs;
+	sampling = (callbacks->get_precs == jag_common_get_task_precs);
 
+	START_TIMER;
 	ct = time(NULL);
 
 	(void)list_for_each(prec_list, (ListForF)_init_tres, NULL);
+	poll_final = final;
 	(*(callbacks->get_precs))(task_list, pgid_plugin, cont_id, callbacks);
+	poll_final = false;
 
 	if (!list_count(prec_list) || !task_list || !list_count(task_list))
 		goto finished;	/* We have no business being here! */
@@ -1156,5 +1283,11 @@ extern void jag_common_poll_data(
 						total_job_vsize);
 
 finished:
+	END_TIMER;
+	poll_cnt[sampling]++;
+	poll_usec[sampling] += DELTA_TIMER;
+	poll_usec_max[sampling] = MAX(poll_usec_max[sampling], DELTA_TIMER);
+	log_flag(JAG, "%s took %s",
+		 sampling ? "task sampling" : "process sampling", TIME_STR);
 	processing = 0;
 }
@@ -68,8 +68,16 @@ extern void jag_common_init(long in_hertz);
 extern void jag_common_fini(void);
 extern void destroy_jag_prec(void *object);
 
+/*
+ * get_precs callback building one record per task without reading /proc,
+ * for use with a prec_extra that reads aggregate usage (e.g. from cgroups).
+ */
+extern List jag_common_get_task_precs(List task_list, bool pgid_plugin,
+				      uint64_t cont_id,
+				      jag_callbacks_t *callbacks);
+
 extern void jag_common_poll_data(
 	List task_list, bool pgid_plugin, uint64_t cont_id,
-	jag_callbacks_t *callbacks, bool profile);
+	jag_callbacks_t *callbacks, bool profile, bool final);
 
 #endif
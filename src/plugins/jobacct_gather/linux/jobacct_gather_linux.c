@@ -244,6 +244,8 @@ extern int fini (void)
  * IN/OUT: task_list - list containing current processes.
  * IN: pgid_plugin - if we are running with the pgid plugin.
  * IN: cont_id - container id of processes if not running with pgid.
+ * IN: profile - true to also send the data to the profile plugin.
+ * IN: final - true for the last poll before a task is removed.
  *
  * OUT:	none
  *
@@ -256,7 +258,8 @@ extern int fini (void)
  *    wrong.
  */
 extern void jobacct_gather_p_poll_data(
-	List task_list, bool pgid_plugin, uint64_t cont_id, bool profile)
+	List task_list, bool pgid_plugin, uint64_t cont_id, bool profile,
+	bool final)
 {
 	static jag_callbacks_t callbacks;
 	static bool first = 1;
@@ -270,7 +273,7 @@ extern void jobacct_gather_p_poll_data(
 	}
 
 	jag_common_poll_data(task_list, pgid_plugin, cont_id, &callbacks,
-			     profile);
+			     profile, final);
 	return;
 }
 
@@ -203,6 +203,7 @@ static int _apply_decay(double real_decay)
 		qos->usage->grp_used_wall *= real_decay;
 	}
 	list_iterator_destroy(itr);
+	assoc_mgr_usage_gen_bump(NULL);
 	assoc_mgr_unlock(&locks);
 
 	return SLURM_SUCCESS;
@@ -249,6 +250,7 @@ static int _reset_usage(void)
 		qos->usage->grp_used_wall = 0;
 	}
 	list_iterator_destroy(itr);
+	assoc_mgr_usage_gen_bump(NULL);
 	assoc_mgr_unlock(&locks);
 
 	return SLURM_SUCCESS;
@@ -796,6 +798,8 @@ static void _handle_qos_tres_run_secs(long double *tres_run_decay,
 	if (!qos || !(accounting_enforce & ACCOUNTING_ENFORCE_LIMITS))
 		return;
 
+	assoc_mgr_usage_gen_bump(&qos->usage->usage_gen);
+
 	for (i=0; i<slurmctld_tres_cnt; i++) {
 		if (i == TRES_ARRAY_ENERGY)
 			continue;
@@ -835,6 +839,8 @@ static void _handle_assoc_tres_run_secs(long double *tres_run_decay,
 	if (!assoc || !(accounting_enforce & ACCOUNTING_ENFORCE_LIMITS))
 		return;
 
+	assoc_mgr_usage_gen_bump(&assoc->usage->usage_gen);
+
 	for (i=0; i<slurmctld_tres_cnt; i++) {
 		if (i == TRES_ARRAY_ENERGY)
 			continue;
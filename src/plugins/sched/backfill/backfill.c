@@ -405,7 +405,9 @@ static int  _try_sched(job_record_t *job_ptr, bitstr_t **avail_bitmap,
 	ListIterator feat_iter;
 	job_feature_t *feat_ptr;
 	job_feature_t *feature_base;
+	struct timeval test_start;
 
+	gettimeofday(&test_start, NULL);
 	if (has_xand || feat_cnt) {
 		/*
 		 * Cache the feature information and test the individual
@@ -633,6 +635,8 @@ static int  _try_sched(job_record_t *job_ptr, bitstr_t **avail_bitmap,
 	}
 
 	FREE_NULL_LIST(preemptee_candidates);
+	sched_cost_add(job_ptr, "backfill", __func__,
+		       slurmctld_diag_stats.bf_cycle_counter + 1, &test_start);
 	return rc;
 }
 
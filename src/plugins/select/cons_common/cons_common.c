@@ -39,6 +39,7 @@
 #include "src/common/slurm_xlator.h"
 
 #include "cons_common.h"
+#include "gres_select_index.h"
 
 #include "src/common/assoc_mgr.h"
 #include "src/common/slurm_selecttype_info.h"
@@ -59,6 +60,7 @@ extern int node_record_count __attribute__((weak_import));
 extern time_t last_node_update __attribute__((weak_import));
 extern switch_record_t *switch_record_table __attribute__((weak_import));
 extern int switch_record_cnt __attribute__((weak_import));
+extern int switch_levels __attribute__((weak_import));
 extern bitstr_t *avail_node_bitmap __attribute__((weak_import));
 extern uint16_t *cr_node_num_cores __attribute__((weak_import));
 extern uint32_t *cr_node_cores_offset __attribute__((weak_import));
@@ -74,6 +76,7 @@ int node_record_count;
 time_t last_node_update;
 switch_record_t *switch_record_table;
 int switch_record_cnt;
+int switch_levels;
 bitstr_t *avail_node_bitmap;
 uint16_t *cr_node_num_cores;
 uint32_t *cr_node_cores_offset;
@@ -866,6 +869,8 @@ extern void common_fini(void)
 	part_data_destroy_res(select_part_record);
 	select_part_record = NULL;
 	cr_fini_global_core_data();
+	gres_select_index_fini();
+	job_test_fini();
 }
 
 /*
@@ -1128,6 +1133,27 @@ extern int select_p_node_init(node_record_t *node_ptr, int node_cnt)
 	} else
 		bf_window_scale = 0;
 
+	if ((tmp_ptr = xstrcasestr(slurm_conf.sched_params,
+				   "select_res_threads="))) {
+		res_avail_threads = atoi(tmp_ptr + 19);
+		if (res_avail_threads < 0) {
+			error("Invalid SchedulerParameters select_res_threads: %d",
+			      res_avail_threads);
+			res_avail_threads = RES_AVAIL_THREADS_DEFAULT;
+		}
+	} else
+		res_avail_threads = RES_AVAIL_THREADS_DEFAULT;
+	if ((tmp_ptr = xstrcasestr(slurm_conf.sched_params,
+				   "select_res_min_nodes="))) {
+		res_avail_min_nodes = atoi(tmp_ptr + 21);
+		if (res_avail_min_nodes < 1) {
+			error("Invalid SchedulerParameters select_res_min_nodes: %d",
+			      res_avail_min_nodes);
+			res_avail_min_nodes = RES_AVAIL_MIN_NODES_DEFAULT;
+		}
+	} else
+		res_avail_min_nodes = RES_AVAIL_MIN_NODES_DEFAULT;
+
 	if (xstrcasestr(slurm_conf.sched_params, "pack_serial_at_end"))
 		pack_serial_at_end = true;
 	else
@@ -1219,6 +1245,7 @@ extern int select_p_node_init(node_record_t *node_ptr, int node_cnt)
 		gres_node_state_dealloc_all(
 			select_node_record[i].node_ptr->gres_list);
 	}
+	gres_select_index_invalidate();
 	part_data_create_array();
 	node_data_dump();
 
@@ -2121,6 +2148,9 @@ extern int select_p_update_node_config(int index)
 		/* tot_cores should be the same */
 	}
 
+	/* GRES counts may have changed on registration or update */
+	gres_select_index_update_node(index);
+
 	return SLURM_SUCCESS;
 }
 
@@ -79,6 +79,39 @@ extern bitstr_t **copy_core_array(bitstr_t **core_array)
 	return core_array2;
 }
 
+/*
+ * Copy an array of bitmaps, one per node, into *core_array1. Its existing
+ * bitmaps are reused, so repeatedly resetting a scratch array from the same
+ * source does not allocate once the array has been built.
+ * Use free_core_array() to release *core_array1
+ */
+extern void core_array_copybits(bitstr_t ***core_array1,
+				bitstr_t **core_array2)
+{
+	bitstr_t **dest;
+	int n;
+
+	if (!core_array2) {
+		free_core_array(core_array1);
+		return;
+	}
+	if (!*core_array1)
+		*core_array1 = build_core_array();
+	dest = *core_array1;
+	for (n = 0; n < core_array_size; n++) {
+		if (!core_array2[n]) {
+			FREE_NULL_BITMAP(dest[n]);
+		} else if (!dest[n]) {
+			dest[n] = bit_copy(core_array2[n]);
+		} else {
+			if (bit_size(dest[n]) != bit_size(core_array2[n]))
+				dest[n] = bit_realloc(dest[n],
+						      bit_size(core_array2[n]));
+			bit_copybits(dest[n], core_array2[n]);
+		}
+	}
+}
+
 /*
  * Return count of set bits in array of bitmaps, one per node
  */
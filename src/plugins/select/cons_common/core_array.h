@@ -53,6 +53,13 @@ extern void clear_core_array(bitstr_t **core_array);
  */
 extern bitstr_t **copy_core_array(bitstr_t **core_array);
 
+/*
+ * Copy core_array2 into *core_array1, reusing the bitmaps already there
+ * Use free_core_array() to release *core_array1
+ */
+extern void core_array_copybits(bitstr_t ***core_array1,
+				bitstr_t **core_array2);
+
 /*
  * Return count of set bits in array of bitmaps, one per node
  */
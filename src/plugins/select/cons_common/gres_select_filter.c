@@ -65,9 +65,14 @@ static void _job_core_filter(void *job_gres_data, void *node_gres_data,
 		use_busy_dev = true;
 	}
 
-	/* Determine which specific cores can be used */
-	avail_core_bitmap = bit_copy(core_bitmap);
-	bit_nclear(avail_core_bitmap, core_start_bit, core_end_bit);
+	/*
+	 * Determine which specific cores of this node can be used. The node's
+	 * cores are gathered in a stack bitmap rather than in a copy of
+	 * core_bitmap, which for cons_res spans every core in the cluster.
+	 */
+	core_ctld = core_end_bit - core_start_bit + 1;
+	bitstr_t avail_core_words[BITSTR_WORDS(core_ctld)];
+	avail_core_bitmap = bit_init(avail_core_words, core_ctld);
 	for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
 		if (node_gres_ptr->topo_gres_cnt_avail[i] == 0)
 			continue;
@@ -82,21 +87,25 @@ static void _job_core_filter(void *job_gres_data, void *node_gres_data,
 		    (!node_gres_ptr->topo_type_name[i] ||
 		     (job_gres_ptr->type_id != node_gres_ptr->topo_type_id[i])))
 			continue;
-		if (!node_gres_ptr->topo_core_bitmap[i]) {
-			FREE_NULL_BITMAP(avail_core_bitmap);	/* No filter */
-			return;
-		}
-		core_ctld = core_end_bit - core_start_bit + 1;
+		if (!node_gres_ptr->topo_core_bitmap[i])
+			return;	/* No filter */
 		gres_validate_node_cores(node_gres_ptr, core_ctld, node_name);
-		core_ctld = bit_size(node_gres_ptr->topo_core_bitmap[i]);
-		for (j = 0; j < core_ctld; j++) {
-			if (bit_test(node_gres_ptr->topo_core_bitmap[i], j)) {
-				bit_set(avail_core_bitmap, core_start_bit + j);
-			}
+		if (bit_size(node_gres_ptr->topo_core_bitmap[i]) == core_ctld) {
+			bit_or(avail_core_bitmap,
+			       node_gres_ptr->topo_core_bitmap[i]);
+			continue;
+		}
+		j = MIN(bit_size(node_gres_ptr->topo_core_bitmap[i]),
+			core_ctld);
+		while (j--) {
+			if (bit_test(node_gres_ptr->topo_core_bitmap[i], j))
+				bit_set(avail_core_bitmap, j);
 		}
 	}
-	bit_and(core_bitmap, avail_core_bitmap);
-	FREE_NULL_BITMAP(avail_core_bitmap);
+	for (j = 0; j < core_ctld; j++) {
+		if (!bit_test(avail_core_bitmap, j))
+			bit_clear(core_bitmap, core_start_bit + j);
+	}
 }
 
 /*
@@ -0,0 +1,408 @@
+/*****************************************************************************\
+ *  gres_select_index.c - cluster wide index of available GRES
+ *****************************************************************************
+ *  Copyright (C) 2021 agent <agent@local>
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "src/common/slurm_xlator.h"
+
+#include "gres_select_index.h"
+#include "cons_common.h"
+
+#include "src/common/xstring.h"
+
+/* Bitmaps are kept for up to this many available GRES per node */
+#define GRES_INDEX_MAX_CNT 16
+/* Sockets per node for which per socket counts are tracked */
+#define GRES_INDEX_MAX_SOCK 64
+
+typedef struct {
+	uint32_t plugin_id;
+	bool typed;		/* false to count all types of this GRES */
+	uint32_t type_id;
+	uint64_t *total_cnt;	/* per node, GRES configured */
+	uint64_t *avail_cnt;	/* per node, GRES not allocated to jobs */
+	uint64_t *sock_cnt;	/* per node, most GRES available on a socket */
+	/* avail_map[k]: nodes with more than k GRES available */
+	bitstr_t *avail_map[GRES_INDEX_MAX_CNT];
+} gres_index_t;
+
+static pthread_mutex_t index_lock = PTHREAD_MUTEX_INITIALIZER;
+static gres_index_t *gres_index = NULL;
+static int gres_index_cnt = 0;
+static int index_node_cnt = 0;
+static bool index_valid = false;
+
+static void _free_index(void)
+{
+	int i, k;
+
+	for (i = 0; i < gres_index_cnt; i++) {
+		xfree(gres_index[i].total_cnt);
+		xfree(gres_index[i].avail_cnt);
+		xfree(gres_index[i].sock_cnt);
+		for (k = 0; k < GRES_INDEX_MAX_CNT; k++)
+			FREE_NULL_BITMAP(gres_index[i].avail_map[k]);
+	}
+	xfree(gres_index);
+	gres_index_cnt = 0;
+	index_node_cnt = 0;
+	index_valid = false;
+}
+
+static gres_index_t *_find_index(uint32_t gres_plugin_id, bool typed,
+				 uint32_t type_id)
+{
+	int i;
+
+	for (i = 0; i < gres_index_cnt; i++) {
+		if ((gres_index[i].plugin_id == gres_plugin_id) &&
+		    (gres_index[i].typed == typed) &&
+		    (!typed || (gres_index[i].type_id == type_id)))
+			return &gres_index[i];
+	}
+
+	return NULL;
+}
+
+static void _add_index(uint32_t gres_plugin_id, bool typed, uint32_t type_id)
+{
+	gres_index_t *idx;
+	int k;
+
+	if (_find_index(gres_plugin_id, typed, type_id))
+		return;
+
+	xrecalloc(gres_index, gres_index_cnt + 1, sizeof(gres_index_t));
+	idx = &gres_index[gres_index_cnt++];
+	idx->plugin_id = gres_plugin_id;
+	idx->typed = typed;
+	idx->type_id = type_id;
+	idx->total_cnt = xcalloc(index_node_cnt, sizeof(uint64_t));
+	idx->avail_cnt = xcalloc(index_node_cnt, sizeof(uint64_t));
+	idx->sock_cnt = xcalloc(index_node_cnt, sizeof(uint64_t));
+	for (k = 0; k < GRES_INDEX_MAX_CNT; k++)
+		idx->avail_map[k] = bit_alloc(index_node_cnt);
+}
+
+static List _node_gres_list(int node_inx)
+{
+	if (select_node_usage[node_inx].gres_list)
+		return select_node_usage[node_inx].gres_list;
+	return select_node_record[node_inx].node_ptr->gres_list;
+}
+
+static uint64_t _cnt_avail(uint64_t avail, uint64_t alloc, bool no_consume)
+{
+	if (no_consume)
+		return avail;
+	return (avail > alloc) ? (avail - alloc) : 0;
+}
+
+/*
+ * Count the GRES of an index entry on one node. Every count is an upper bound
+ * of what the detailed GRES test can find on the node.
+ */
+static void _node_cnt(gres_index_t *idx, gres_node_state_t *gres_ns,
+		      int node_inx, uint64_t *total, uint64_t *avail,
+		      uint64_t *sock)
+{
+	uint64_t sock_avail[GRES_INDEX_MAX_SOCK], topo_total = 0, cnt;
+	uint16_t sockets = select_node_record[node_inx].tot_sockets;
+	uint16_t cores = select_node_record[node_inx].cores;
+	int i, s;
+
+	*total = gres_ns->gres_cnt_avail;
+	*avail = _cnt_avail(gres_ns->gres_cnt_avail, gres_ns->gres_cnt_alloc,
+			    gres_ns->no_consume);
+	if (idx->typed) {
+		uint64_t type_total = 0, type_avail = 0;
+		/*
+		 * type_cnt_alloc isn't incremented by jobs requesting GRES
+		 * without a type, so also cap by the count of all types.
+		 */
+		for (i = 0; i < gres_ns->type_cnt; i++) {
+			if (gres_ns->type_id[i] != idx->type_id)
+				continue;
+			type_total += gres_ns->type_cnt_avail[i];
+			type_avail += _cnt_avail(gres_ns->type_cnt_avail[i],
+						 gres_ns->type_cnt_alloc[i],
+						 gres_ns->no_consume);
+		}
+		*total = type_total;
+		*avail = MIN(*avail, type_avail);
+	}
+	*sock = *avail;
+
+	if (!gres_ns->topo_cnt || gres_ns->no_consume ||
+	    (sockets > GRES_INDEX_MAX_SOCK))
+		return;
+
+	memset(sock_avail, 0, sizeof(uint64_t) * sockets);
+	for (i = 0; i < gres_ns->topo_cnt; i++) {
+		bitstr_t *core_map = gres_ns->topo_core_bitmap[i];
+
+		if (idx->typed &&
+		    (!gres_ns->topo_type_name[i] ||
+		     (gres_ns->topo_type_id[i] != idx->type_id)))
+			continue;
+		topo_total += gres_ns->topo_gres_cnt_avail[i];
+		cnt = _cnt_avail(gres_ns->topo_gres_cnt_avail[i],
+				 gres_ns->topo_gres_cnt_alloc[i], false);
+		if (!cnt)
+			continue;
+		for (s = 0; s < sockets; s++) {
+			if (!core_map ||
+			    (bit_size(core_map) != (sockets * cores)) ||
+			    (bit_set_count_range(core_map, s * cores,
+						 (s + 1) * cores) > 0))
+				sock_avail[s] += cnt;
+		}
+	}
+
+	/* Only trust the topology if it describes all of the GRES */
+	if (topo_total != *total)
+		return;
+	cnt = 0;
+	for (s = 0; s < sockets; s++)
+		cnt = MAX(cnt, sock_avail[s]);
+	*sock = MIN(*sock, cnt);
+}
+
+static void _set_node_cnt(gres_index_t *idx, int node_inx, uint64_t total,
+			  uint64_t avail, uint64_t sock)
+{
+	uint64_t old = idx->avail_cnt[node_inx], k;
+
+	for (k = avail; (k < old) && (k < GRES_INDEX_MAX_CNT); k++)
+		bit_clear(idx->avail_map[k], node_inx);
+	for (k = old; (k < avail) && (k < GRES_INDEX_MAX_CNT); k++)
+		bit_set(idx->avail_map[k], node_inx);
+
+	idx->total_cnt[node_inx] = total;
+	idx->avail_cnt[node_inx] = avail;
+	idx->sock_cnt[node_inx] = sock;
+}
+
+static void _update_node(int node_inx)
+{
+	List gres_list = _node_gres_list(node_inx);
+	gres_state_t *gres_state_node;
+	gres_node_state_t *gres_ns;
+	uint64_t total, avail, sock;
+	ListIterator iter;
+	int i;
+
+	for (i = 0; i < gres_index_cnt; i++) {
+		gres_index_t *idx = &gres_index[i];
+
+		if (!gres_list ||
+		    !(gres_state_node = list_find_first(gres_list,
+							gres_find_id,
+							&idx->plugin_id))) {
+			_set_node_cnt(idx, node_inx, 0, 0, 0);
+			continue;
+		}
+		gres_ns = gres_state_node->gres_data;
+		_node_cnt(idx, gres_ns, node_inx, &total, &avail, &sock);
+		_set_node_cnt(idx, node_inx, total, avail, sock);
+	}
+
+	if (!gres_list)
+		return;
+
+	/* A GRES or type new to the index needs a rebuild */
+	iter = list_iterator_create(gres_list);
+	while ((gres_state_node = list_next(iter))) {
+		gres_ns = gres_state_node->gres_data;
+		if (!_find_index(gres_state_node->plugin_id, false, 0)) {
+			index_valid = false;
+			break;
+		}
+		for (i = 0; i < gres_ns->type_cnt; i++) {
+			if (!_find_index(gres_state_node->plugin_id, true,
+					 gres_ns->type_id[i])) {
+				index_valid = false;
+				break;
+			}
+		}
+		if (!index_valid)
+			break;
+	}
+	list_iterator_destroy(iter);
+}
+
+static void _build_index(void)
+{
+	gres_state_t *gres_state_node;
+	gres_node_state_t *gres_ns;
+	ListIterator iter;
+	List gres_list;
+	int n, i;
+	DEF_TIMERS;
+
+	START_TIMER;
+	_free_index();
+	index_node_cnt = select_node_cnt;
+
+	for (n = 0; n < index_node_cnt; n++) {
+		if (!(gres_list = _node_gres_list(n)))
+			continue;
+		iter = list_iterator_create(gres_list);
+		while ((gres_state_node = list_next(iter))) {
+			gres_ns = gres_state_node->gres_data;
+			_add_index(gres_state_node->plugin_id, false, 0);
+			for (i = 0; i < gres_ns->type_cnt; i++)
+				_add_index(gres_state_node->plugin_id, true,
+					   gres_ns->type_id[i]);
+		}
+		list_iterator_destroy(iter);
+	}
+
+	index_valid = true;
+	for (n = 0; n < index_node_cnt; n++)
+		_update_node(n);
+
+	END_TIMER;
+	log_flag(SELECT_TYPE, "built GRES index of %d entries for %d nodes in %s",
+		 gres_index_cnt, index_node_cnt, TIME_STR);
+}
+
+/* Clear the nodes of node_bitmap with less than min_cnt in cnt[] */
+static int _filter_by_cnt(bitstr_t *node_bitmap, uint64_t *cnt,
+			  uint64_t min_cnt)
+{
+	int i, i_first, i_last, cleared = 0;
+
+	i_first = bit_ffs(node_bitmap);
+	if (i_first == -1)
+		return 0;
+	i_last = bit_fls(node_bitmap);
+	for (i = i_first; i <= i_last; i++) {
+		if (!bit_test(node_bitmap, i) || (cnt[i] >= min_cnt))
+			continue;
+		bit_clear(node_bitmap, i);
+		cleared++;
+	}
+
+	return cleared;
+}
+
+extern void gres_select_index_invalidate(void)
+{
+	slurm_mutex_lock(&index_lock);
+	index_valid = false;
+	slurm_mutex_unlock(&index_lock);
+}
+
+extern void gres_select_index_update_node(int node_inx)
+{
+	slurm_mutex_lock(&index_lock);
+	/* An invalid index is rebuilt from all the nodes on its next use */
+	if (index_valid && (node_inx < index_node_cnt))
+		_update_node(node_inx);
+	slurm_mutex_unlock(&index_lock);
+}
+
+extern int gres_select_index_filter(List job_gres_list, bitstr_t *node_bitmap,
+				    bool enforce_binding)
+{
+	gres_state_t *gres_state_job;
+	gres_job_state_t *gres_js;
+	gres_index_t *idx;
+	ListIterator iter;
+	uint64_t min_cnt;
+	int cnt, cleared = 0;
+
+	if (!job_gres_list)
+		return 0;
+
+	slurm_mutex_lock(&index_lock);
+	if (!index_valid || (index_node_cnt != select_node_cnt))
+		_build_index();
+	if (bit_size(node_bitmap) != index_node_cnt) {
+		slurm_mutex_unlock(&index_lock);
+		return 0;
+	}
+
+	iter = list_iterator_create(job_gres_list);
+	while ((gres_state_job = list_next(iter))) {
+		gres_js = gres_state_job->gres_data;
+
+		/* Same minimum per node as the detailed GRES test */
+		min_cnt = gres_js->gres_per_job ? 1 : 0;
+		min_cnt = MAX(min_cnt, gres_js->gres_per_node);
+		min_cnt = MAX(min_cnt, gres_js->gres_per_socket);
+		min_cnt = MAX(min_cnt, gres_js->gres_per_task);
+		if (!min_cnt)
+			continue;
+
+		if (!(idx = _find_index(gres_state_job->plugin_id,
+					(gres_js->type_name != NULL),
+					gres_js->type_id))) {
+			/* No node has this GRES */
+			cleared += bit_set_count(node_bitmap);
+			bit_clear_all(node_bitmap);
+			break;
+		}
+
+		if (gres_js->flags & GRES_NO_CONSUME) {
+			cleared += _filter_by_cnt(node_bitmap, idx->total_cnt,
+						  min_cnt);
+			continue;
+		}
+
+		if (min_cnt <= GRES_INDEX_MAX_CNT) {
+			cnt = bit_set_count(node_bitmap);
+			bit_and(node_bitmap, idx->avail_map[min_cnt - 1]);
+			cleared += cnt - bit_set_count(node_bitmap);
+		} else {
+			cleared += _filter_by_cnt(node_bitmap, idx->avail_cnt,
+						  min_cnt);
+		}
+
+		if (enforce_binding && gres_js->gres_per_socket)
+			cleared += _filter_by_cnt(node_bitmap, idx->sock_cnt,
+						  gres_js->gres_per_socket);
+	}
+	list_iterator_destroy(iter);
+	slurm_mutex_unlock(&index_lock);
+
+	return cleared;
+}
+
+extern void gres_select_index_fini(void)
+{
+	slurm_mutex_lock(&index_lock);
+	_free_index();
+	slurm_mutex_unlock(&index_lock);
+}
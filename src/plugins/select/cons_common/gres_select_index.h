@@ -0,0 +1,80 @@
+/*****************************************************************************\
+ *  gres_select_index.h - cluster wide index of available GRES
+ *****************************************************************************
+ *  Copyright (C) 2021 agent <agent@local>
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _GRES_SELECT_INDEX_H
+#define _GRES_SELECT_INDEX_H
+
+#include "src/common/gres.h"
+
+/*
+ * The GRES index keeps, for each GRES name and type found on the nodes, the
+ * count of GRES not allocated to jobs on every node, along with bitmaps of
+ * the nodes having at least 1, 2, ... such GRES. This lets node selection
+ * discard the nodes which can't satisfy a job's GRES request with a few
+ * bitmap operations before testing the GRES topology of each node.
+ *
+ * The counts are an upper bound of what gres_job_test2() finds on a node, so
+ * filtering with them never discards a usable node.
+ */
+
+/*
+ * Drop the index, it will be rebuilt from the node records on its next use.
+ * Call when the node table or the GRES configuration of all nodes changes.
+ */
+extern void gres_select_index_invalidate(void);
+
+/*
+ * Refresh the index for one node after GRES were allocated to or released
+ * from jobs on it, or its GRES configuration changed.
+ * IN node_inx - index of the node in node_record_table_ptr
+ */
+extern void gres_select_index_update_node(int node_inx);
+
+/*
+ * Clear from node_bitmap the nodes without enough unallocated GRES for the
+ * job's per node, per socket or per task GRES request.
+ * IN job_gres_list - job's gres_list built by gres_job_state_validate()
+ * IN/OUT node_bitmap - nodes to consider
+ * IN enforce_binding - if true, per socket requests must be satisfied by the
+ *			GRES bound to a single socket
+ * RET count of nodes cleared from node_bitmap
+ */
+extern int gres_select_index_filter(List job_gres_list, bitstr_t *node_bitmap,
+				    bool enforce_binding);
+
+/* Free all memory used by the index */
+extern void gres_select_index_fini(void);
+
+#endif /* _GRES_SELECT_INDEX_H */
@@ -36,6 +36,7 @@
 \*****************************************************************************/
 
 #include "cons_common.h"
+#include "gres_select_index.h"
 
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/gres_ctld.h"
@@ -365,6 +366,7 @@ extern int job_res_add_job(job_record_t *job_ptr, job_res_job_action_t action)
 					node_ptr->name, core_bitmap, new_alloc);
 
 			gres_node_state_log(node_gres_list, node_ptr->name);
+			gres_select_index_update_node(i);
 			FREE_NULL_BITMAP(core_bitmap);
 
 			if (job->memory_allocated[n] == 0)
@@ -532,6 +534,8 @@ extern int job_res_rm_job(part_res_record_t *part_record_ptr,
 					      node_ptr->name, old_job,
 					      job_fini);
 			gres_node_state_log(gres_list, node_ptr->name);
+			if (node_usage == select_node_usage)
+				gres_select_index_update_node(i);
 
 			if (node_usage[i].alloc_memory <
 			    job->memory_allocated[n]) {
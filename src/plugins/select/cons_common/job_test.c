@@ -37,9 +37,12 @@
 #include "cons_common.h"
 #include "dist_tasks.h"
 #include "gres_select_filter.h"
+#include "gres_select_index.h"
 #include "gres_select_util.h"
 
 #include "src/common/node_select.h"
+#include "src/common/timers.h"
+#include "src/common/workq.h"
 #include "src/common/xstring.h"
 
 #include "src/slurmctld/gres_ctld.h"
@@ -63,10 +66,42 @@ typedef struct {
 	bool *qos_preemptor;
 } cr_job_list_args_t;
 
+typedef struct {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int remaining;		/* parts not yet evaluated */
+} res_avail_batch_t;
+
+typedef struct {
+	job_record_t *job_ptr;
+	bitstr_t *node_map;
+	bitstr_t **core_map;
+	node_use_record_t *node_usage;
+	uint16_t cr_type;
+	bool test_only;
+	bool will_run;
+	bitstr_t **part_core_map;
+	uint32_t s_p_n;
+	avail_res_t **avail_res_array;
+	int i_first;		/* node index range of this part */
+	int i_last;
+	long usec;		/* time spent evaluating this part */
+	res_avail_batch_t *batch;
+} res_avail_part_t;
+
 uint64_t def_cpu_per_gpu = 0;
 uint64_t def_mem_per_gpu = 0;
 bool preempt_strict_order = false;
 int preempt_reorder_cnt	= 1;
+int res_avail_threads = RES_AVAIL_THREADS_DEFAULT;
+int res_avail_min_nodes = RES_AVAIL_MIN_NODES_DEFAULT;
+
+static pthread_mutex_t res_avail_mutex = PTHREAD_MUTEX_INITIALIZER;
+static workq_t *res_avail_workq = NULL;
+static int res_avail_workq_size = 0;
+static uint32_t res_avail_par_cnt = 0;	/* parallel evaluations */
+static uint64_t res_avail_par_wall = 0;	/* usec, summed over evaluations */
+static uint64_t res_avail_par_busy = 0;	/* usec, summed over all parts */
 
 /* When any cores on a node are removed from being available for a job,
  * then remove the entire node from being available. */
@@ -308,6 +343,126 @@ static uint32_t _socks_per_node(job_record_t *job_ptr)
 	return s_p_n;
 }
 
+/* Determine resource availability on the nodes of one part of node_map */
+static void _res_avail_part(res_avail_part_t *part)
+{
+	int i;
+	DEF_TIMERS;
+
+	START_TIMER;
+	for (i = part->i_first; i <= part->i_last; i++) {
+		if (!bit_test(part->node_map, i))
+			continue;
+		part->avail_res_array[i] =
+			(*cons_common_callbacks.can_job_run_on_node)(
+				part->job_ptr, part->core_map, i,
+				part->s_p_n, part->node_usage,
+				part->cr_type, part->test_only,
+				part->will_run, part->part_core_map);
+	}
+	END_TIMER;
+	part->usec = DELTA_TIMER;
+}
+
+static void _res_avail_work(void *arg)
+{
+	res_avail_part_t *part = arg;
+	res_avail_batch_t *batch = part->batch;
+
+	_res_avail_part(part);
+
+	slurm_mutex_lock(&batch->mutex);
+	if (--batch->remaining == 0)
+		slurm_cond_signal(&batch->cond);
+	slurm_mutex_unlock(&batch->mutex);
+}
+
+/*
+ * Evaluate the nodes of node_map on the res_avail_workq threads, the node
+ * range being split in one part per thread plus one for the calling thread.
+ * Each part only writes the avail_res_array and core_map entries of its own
+ * nodes. The pool is (re)created here, after res_avail_mutex is released it
+ * is used without it: the slurmctld job write lock held by every caller of
+ * the job test serializes the evaluations, so no other one can be using it.
+ */
+static void _get_res_avail_parallel(res_avail_part_t *args, int i_first,
+				    int i_last)
+{
+	res_avail_batch_t batch;
+	res_avail_part_t *parts;
+	int i, part_cnt, part_size, queued = 0;
+	long busy_usec = 0;
+	DEF_TIMERS;
+
+	slurm_mutex_lock(&res_avail_mutex);
+	if (res_avail_workq && (res_avail_workq_size != res_avail_threads)) {
+		/* SchedulerParameters changed, resize the pool */
+		FREE_NULL_WORKQ(res_avail_workq);
+	}
+	if (!res_avail_workq) {
+		res_avail_workq = new_workq(res_avail_threads);
+		res_avail_workq_size = res_avail_threads;
+	}
+	slurm_mutex_unlock(&res_avail_mutex);
+
+	START_TIMER;
+	part_cnt = res_avail_threads + 1;	/* this thread takes one part */
+	part_size = (i_last - i_first + part_cnt) / part_cnt;
+	parts = xcalloc(part_cnt, sizeof(res_avail_part_t));
+	slurm_mutex_init(&batch.mutex);
+	slurm_cond_init(&batch.cond, NULL);
+	batch.remaining = part_cnt - 1;
+	for (i = 0; i < part_cnt; i++) {
+		parts[i] = *args;
+		parts[i].i_first = i_first + (i * part_size);
+		parts[i].i_last = MIN(parts[i].i_first + part_size - 1,
+				      i_last);
+		parts[i].batch = &batch;
+	}
+
+	slurm_mutex_lock(&batch.mutex);
+	for (i = 1; i < part_cnt; i++) {
+		if (workq_add_work(res_avail_workq, _res_avail_work,
+				   &parts[i], "_res_avail_work"))
+			break;
+		queued++;
+	}
+	batch.remaining -= (part_cnt - 1 - queued);
+	slurm_mutex_unlock(&batch.mutex);
+
+	/* Evaluate whatever could not be handed to the pool here */
+	_res_avail_part(&parts[0]);
+	for (i = queued + 1; i < part_cnt; i++)
+		_res_avail_part(&parts[i]);
+
+	slurm_mutex_lock(&batch.mutex);
+	while (batch.remaining)
+		slurm_cond_wait(&batch.cond, &batch.mutex);
+	slurm_mutex_unlock(&batch.mutex);
+	slurm_mutex_destroy(&batch.mutex);
+	slurm_cond_destroy(&batch.cond);
+	END_TIMER;
+
+	for (i = 0; i < part_cnt; i++)
+		busy_usec += parts[i].usec;
+	xfree(parts);
+
+	if (slurm_conf.debug_flags & DEBUG_FLAG_SELECT_TYPE) {
+		uint32_t cnt;
+		uint64_t wall, busy;
+
+		slurm_mutex_lock(&res_avail_mutex);
+		cnt = ++res_avail_par_cnt;
+		wall = (res_avail_par_wall += DELTA_TIMER);
+		busy = (res_avail_par_busy += busy_usec);
+		slurm_mutex_unlock(&res_avail_mutex);
+		log_flag(SELECT_TYPE, "%pJ node evaluation in %d parts took %ld usec, speedup %.2f (average %.2f over %u tests)",
+			 args->job_ptr, queued + 1, DELTA_TIMER,
+			 (double) busy_usec / MAX(DELTA_TIMER, 1),
+			 (double) busy / MAX(wall, 1), cnt);
+	}
+}
+
 /*
  * Determine resource availability for pending job
  *
@@ -341,6 +496,30 @@ static avail_res_t **_get_res_avail(job_record_t *job_ptr,
 		i_last = bit_fls(node_map);
 	else
 		i_last = -2;
+
+	/*
+	 * cons_res shares one core bitmap between all of the nodes, so only
+	 * cons_tres evaluates large candidate sets in parallel.
+	 */
+	if (is_cons_tres && (res_avail_threads > 0) && (i_first != -1) &&
+	    (bit_set_count(node_map) >= res_avail_min_nodes)) {
+		res_avail_part_t args = {
+			.job_ptr = job_ptr,
+			.node_map = node_map,
+			.core_map = core_map,
+			.node_usage = node_usage,
+			.cr_type = cr_type,
+			.test_only = test_only,
+			.will_run = will_run,
+			.part_core_map = part_core_map,
+			.s_p_n = s_p_n,
+			.avail_res_array = avail_res_array,
+		};
+
+		_get_res_avail_parallel(&args, i_first, i_last);
+		return avail_res_array;
+	}
+
 	for (i = i_first; i <= i_last; i++) {
 		if (bit_test(node_map, i))
 			avail_res_array[i] =
@@ -361,6 +540,14 @@ static avail_res_t **_get_res_avail(job_record_t *job_ptr,
 	return avail_res_array;
 }
 
+extern void job_test_fini(void)
+{
+	slurm_mutex_lock(&res_avail_mutex);
+	FREE_NULL_WORKQ(res_avail_workq);
+	res_avail_workq_size = 0;
+	slurm_mutex_unlock(&res_avail_mutex);
+}
+
 /* For a given job already past it's end time, guess when it will actually end.
  * Used for backfill scheduling. */
 static time_t _guess_job_end(job_record_t *job_ptr, time_t now)
@@ -500,6 +687,21 @@ static avail_res_t **_select_nodes(job_record_t *job_ptr, uint32_t min_nodes,
 		return NULL;
 	}
 
+	/*
+	 * Discard the nodes without enough free GRES using the GRES index
+	 * before testing the GRES topology of each node. The index only
+	 * reflects the current allocations, not the node_usage of a test.
+	 */
+	if (is_cons_tres && job_ptr->gres_list_req && !test_only &&
+	    (node_usage == select_node_usage) &&
+	    gres_select_index_filter(job_ptr->gres_list_req, node_bitmap,
+				     (job_ptr->bit_flags & GRES_ENFORCE_BIND)) &&
+	    (bit_set_count(node_bitmap) < min_nodes)) {
+		log_flag(SELECT_TYPE, "%pJ AvailNodes < MinNodes after GRES index filter",
+			 job_ptr);
+		return NULL;
+	}
+
 	core_array_log("_select_nodes/enter", node_bitmap, avail_core);
 	/* Determine resource availability on each node for pending job */
 	avail_res_array = _get_res_avail(job_ptr, node_bitmap, avail_core,
@@ -827,6 +1029,7 @@ static int _job_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 	bitstr_t *orig_node_map, **part_core_map = NULL;
 	bitstr_t **free_cores_tmp = NULL,  *node_bitmap_tmp = NULL;
 	bitstr_t **free_cores_tmp2 = NULL, *node_bitmap_tmp2 = NULL;
+	bitstr_t **free_cores_swap, *node_bitmap_swap;
 	bitstr_t **avail_cores, **free_cores;
 	bool test_only = false, will_run = false;
 	uint32_t sockets_per_node = 1;
@@ -995,8 +1198,7 @@ static int _job_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 	/*** Step 1 ***/
 	bit_copybits(node_bitmap, orig_node_map);
 
-	free_core_array(&free_cores);
-	free_cores = copy_core_array(avail_cores);
+	core_array_copybits(&free_cores, avail_cores);
 	if (exc_core_bitmap && !is_cons_tres) {
 		int exc_core_size  = bit_size(exc_core_bitmap);
 		int free_core_size = bit_size(*free_cores);
@@ -1083,8 +1285,7 @@ static int _job_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 	}
 
 	bit_copybits(node_bitmap, orig_node_map);
-	free_core_array(&free_cores);
-	free_cores = copy_core_array(avail_cores);
+	core_array_copybits(&free_cores, avail_cores);
 	if (exc_cores)
 		core_array_and_not(free_cores, exc_cores);
 
@@ -1119,8 +1320,7 @@ static int _job_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 		_block_whole_nodes(node_bitmap, avail_cores, free_cores);
 
 	/* make these changes permanent */
-	free_core_array(&avail_cores);
-	avail_cores = copy_core_array(free_cores);
+	core_array_copybits(&avail_cores, free_cores);
 
 	avail_res_array = _select_nodes(job_ptr, min_nodes, max_nodes,
 					req_nodes, node_bitmap, free_cores,
@@ -1140,8 +1340,7 @@ static int _job_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 
 	/*** Step 3 ***/
 	bit_copybits(node_bitmap, orig_node_map);
-	free_core_array(&free_cores);
-	free_cores = copy_core_array(avail_cores);
+	core_array_copybits(&free_cores, avail_cores);
 
 	/*
 	 * remove existing allocations (jobs) from same-priority partitions
@@ -1194,28 +1393,32 @@ static int _job_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 						   free_cores_tmp);
 			}
 
-			free_cores_tmp2  = copy_core_array(free_cores_tmp);
-			node_bitmap_tmp2 = bit_copy(node_bitmap_tmp);
+			/*
+			 * The *_tmp2 arrays are scratch space recycled from
+			 * one partition to the next rather than reallocated
+			 */
+			core_array_copybits(&free_cores_tmp2, free_cores_tmp);
+			if (!node_bitmap_tmp2)
+				node_bitmap_tmp2 = bit_copy(node_bitmap_tmp);
+			else
+				bit_copybits(node_bitmap_tmp2, node_bitmap_tmp);
 			avail_res_array_tmp = _select_nodes(
 				job_ptr, min_nodes, max_nodes, req_nodes,
 				node_bitmap_tmp, free_cores_tmp, node_usage,
 				cr_type, test_only, will_run, part_core_map,
 				prefer_alloc_nodes, tres_mc_ptr);
-			if (!avail_res_array_tmp) {
-				free_core_array(&free_cores_tmp2);
-				FREE_NULL_BITMAP(node_bitmap_tmp2);
+			if (!avail_res_array_tmp)
 				break;
-			}
 			log_flag(SELECT_TYPE, "remove low-priority partition %s",
 			         p_ptr->part_ptr->name);
-			free_core_array(&free_cores);
+			free_cores_swap = free_cores;
 			free_cores      = free_cores_tmp;
 			free_cores_tmp  = free_cores_tmp2;
-			free_cores_tmp2 = NULL;
+			free_cores_tmp2 = free_cores_swap;
 			bit_copybits(node_bitmap, node_bitmap_tmp);
-			FREE_NULL_BITMAP(node_bitmap_tmp);
+			node_bitmap_swap = node_bitmap_tmp;
 			node_bitmap_tmp  = node_bitmap_tmp2;
-			node_bitmap_tmp2 = NULL;
+			node_bitmap_tmp2 = node_bitmap_swap;
 			_free_avail_res_array(avail_res_array);
 			avail_res_array = avail_res_array_tmp;
 		}
@@ -1240,8 +1443,7 @@ static int _job_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 		 * jobs in the other partitions with <= priority to
 		 * this partition
 		 */
-		free_core_array(&free_cores);
-		free_cores = copy_core_array(avail_cores);
+		core_array_copybits(&free_cores, avail_cores);
 		bit_copybits(node_bitmap, orig_node_map);
 		avail_res_array = _select_nodes(job_ptr, min_nodes, max_nodes,
 						req_nodes, node_bitmap,
@@ -1266,8 +1468,7 @@ static int _job_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 	for (i = 0; i < c; i++) {
 		if (!jp_ptr->row[i].row_bitmap)
 			break;
-		free_core_array(&free_cores);
-		free_cores = copy_core_array(avail_cores);
+		core_array_copybits(&free_cores, avail_cores);
 		core_array_and_not(free_cores, jp_ptr->row[i].row_bitmap);
 		bit_copybits(node_bitmap, orig_node_map);
 		if (job_ptr->details->whole_node == 1)
@@ -1290,8 +1491,7 @@ static int _job_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 
 	if ((i < c) && !jp_ptr->row[i].row_bitmap) {
 		/* we've found an empty row, so use it */
-		free_core_array(&free_cores);
-		free_cores = copy_core_array(avail_cores);
+		core_array_copybits(&free_cores, avail_cores);
 		bit_copybits(node_bitmap, orig_node_map);
 		log_flag(SELECT_TYPE, "test 4 trying empty row %i",
 		         i);
@@ -1333,7 +1533,9 @@ alloc_job:
 	FREE_NULL_BITMAP(orig_node_map);
 	free_core_array(&part_core_map);
 	free_core_array(&free_cores_tmp);
+	free_core_array(&free_cores_tmp2);
 	FREE_NULL_BITMAP(node_bitmap_tmp);
+	FREE_NULL_BITMAP(node_bitmap_tmp2);
 	if (!avail_res_array || !job_ptr->best_switch) {
 		/* we were sent here to cleanup and exit */
 		xfree(tres_mc_ptr);
@@ -2289,6 +2491,7 @@ extern int common_job_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 {
 	int rc = EINVAL;
 	uint16_t job_node_req;
+	uint64_t bitmap_allocs = bit_alloc_count();
 
 	if (!(slurm_conf.conf_flags & CTL_CONF_ASRU))
 		job_ptr->details->core_spec = NO_VAL16;
@@ -2368,5 +2571,8 @@ extern int common_job_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 		}
 	}
 
+	log_flag(SELECT_TYPE, "%pJ bitmaps allocated:%"PRIu64,
+		 job_ptr, bit_alloc_count() - bitmap_allocs);
+
 	return rc;
 }
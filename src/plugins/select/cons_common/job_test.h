@@ -45,6 +45,19 @@ extern uint64_t def_mem_per_gpu;
 extern bool preempt_strict_order;
 extern int preempt_reorder_cnt;
 
+/*
+ * Candidate nodes of a job test are evaluated on res_avail_threads threads
+ * when there are at least res_avail_min_nodes of them. Zero threads disables
+ * the parallel evaluation.
+ */
+#define RES_AVAIL_THREADS_DEFAULT	4
+#define RES_AVAIL_MIN_NODES_DEFAULT	1024
+extern int res_avail_threads;
+extern int res_avail_min_nodes;
+
+/* Stop the threads used to evaluate candidate nodes */
+extern void job_test_fini(void);
+
 /*
  * common_job_test - Given a specification of scheduling requirements,
  *	identify the nodes which "best" satisfy the request.
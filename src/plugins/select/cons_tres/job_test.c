@@ -1459,6 +1459,65 @@ static void _topo_choose_best_switch(uint32_t *dist, int *switch_node_cnt,
 		*best_switch = i;
 	}
 }
+
+/*
+ * Count the nodes of node_map under each switch, without building a bitmap
+ * per switch. Leaf switches are counted directly, an upper level switch whose
+ * children share no nodes just adds up its children's counts.
+ */
+static void _topo_switch_node_cnt(bitstr_t *node_map, int *switch_node_cnt)
+{
+	switch_record_t *switch_ptr;
+	int i, j, level;
+
+	for (level = 0; level <= switch_levels; level++) {
+		for (i = 0, switch_ptr = switch_record_table;
+		     i < switch_record_cnt; i++, switch_ptr++) {
+			if (switch_ptr->level != level)
+				continue;
+			switch_node_cnt[i] = 0;
+			if (!switch_ptr->node_bitmap)
+				continue;
+			if (!switch_ptr->disjoint_children) {
+				switch_node_cnt[i] = bit_overlap(
+					switch_ptr->node_bitmap, node_map);
+				continue;
+			}
+			for (j = 0; j < switch_ptr->num_switches; j++) {
+				switch_node_cnt[i] += switch_node_cnt[
+					switch_ptr->switch_index[j]];
+			}
+		}
+	}
+}
+
+/*
+ * Build the node bitmaps of the switches reachable from the top level switch,
+ * restricted to the nodes of that switch in node_map (all of them if NULL).
+ * Switches sharing no node with it are left NULL, they can not be used.
+ */
+static void _topo_switch_bitmaps(bitstr_t *node_map, int top_switch_inx,
+				 bitstr_t **switch_node_bitmap)
+{
+	switch_record_t *switch_ptr;
+	bitstr_t *top_bitmap;
+	int i;
+
+	top_bitmap = bit_copy(switch_record_table[top_switch_inx].node_bitmap);
+	if (node_map)
+		bit_and(top_bitmap, node_map);
+	switch_node_bitmap[top_switch_inx] = top_bitmap;
+
+	for (i = 0, switch_ptr = switch_record_table; i < switch_record_cnt;
+	     i++, switch_ptr++) {
+		if ((i == top_switch_inx) || !switch_ptr->node_bitmap ||
+		    !bit_overlap_any(switch_ptr->node_bitmap, top_bitmap))
+			continue;
+		switch_node_bitmap[i] = bit_copy(switch_ptr->node_bitmap);
+		bit_and(switch_node_bitmap[i], top_bitmap);
+	}
+}
+
 static int _topo_weight_find(void *x, void *key)
 {
 	topo_weight_info_t *nw = (topo_weight_info_t *) x;
@@ -1692,9 +1751,10 @@ static int _eval_nodes_dfly(job_record_t *job_ptr,
 		nw = list_peek(node_weight_list);
 	for (i = 0, switch_ptr = switch_record_table; i < switch_record_cnt;
 	     i++, switch_ptr++) {
-		switch_node_bitmap[i] = bit_copy(switch_ptr->node_bitmap);
+		if (!switch_ptr->node_bitmap)
+			continue;
 		if (req_nodes_bitmap &&
-		    bit_overlap_any(req_nodes_bitmap, switch_node_bitmap[i])) {
+		    bit_overlap_any(req_nodes_bitmap, switch_ptr->node_bitmap)) {
 			switch_required[i] = 1;
 			if (switch_record_table[i].level == 0) {
 				leaf_switch_count++;
@@ -1707,7 +1767,7 @@ static int _eval_nodes_dfly(job_record_t *job_ptr,
 		}
 		if (!req_nodes_bitmap &&
 		    (list_find_first(node_weight_list, _topo_node_find,
-				    switch_node_bitmap[i]))) {
+				    switch_ptr->node_bitmap))) {
 			if ((top_switch_inx == -1) ||
 			    (switch_record_table[i].level >
 			     switch_record_table[top_switch_inx].level)) {
@@ -1728,6 +1788,12 @@ static int _eval_nodes_dfly(job_record_t *job_ptr,
 		goto fini;
 	}
 
+	/*
+	 * Remove nodes from consideration that can not be reached from this
+	 * top level switch
+	 */
+	_topo_switch_bitmaps(NULL, top_switch_inx, switch_node_bitmap);
+
 	/* Check that all specificly required nodes are on shared network */
 	if (req_nodes_bitmap &&
 	    !bit_super_set(req_nodes_bitmap,
@@ -1738,17 +1804,6 @@ static int _eval_nodes_dfly(job_record_t *job_ptr,
 		goto fini;
 	}
 
-	/*
-	 * Remove nodes from consideration that can not be reached from this
-	 * top level switch
-	 */
-	for (i = 0; i < switch_record_cnt; i++) {
-		if (top_switch_inx != i) {
-			  bit_and(switch_node_bitmap[i],
-				  switch_node_bitmap[top_switch_inx]);
-		}
-	}
-
 	/*
 	 * Identify the best set of nodes (i.e. nodes with the lowest weight,
 	 * in addition to the required nodes) that can be used to satisfy the
@@ -1869,7 +1924,7 @@ static int _eval_nodes_dfly(job_record_t *job_ptr,
 
 		for (i = 0, switch_ptr = switch_record_table;
 		     i < switch_record_cnt; i++, switch_ptr++) {
-			if (switch_required[i])
+			if (switch_required[i] || !switch_node_bitmap[i])
 				continue;
 			if (bit_overlap_any(req2_nodes_bitmap,
 					    switch_node_bitmap[i])) {
@@ -1905,6 +1960,10 @@ static int _eval_nodes_dfly(job_record_t *job_ptr,
 	avail_nodes_bitmap = bit_alloc(node_record_count);
 	for (i = 0, switch_ptr = switch_record_table; i < switch_record_cnt;
 	     i++, switch_ptr++) {
+		if (!switch_node_bitmap[i]) {
+			switch_node_cnt[i] = 0;
+			continue;
+		}
 		bit_and(switch_node_bitmap[i], best_nodes_bitmap);
 		bit_or(avail_nodes_bitmap, switch_node_bitmap[i]);
 		switch_node_cnt[i] = bit_set_count(switch_node_bitmap[i]);
@@ -2114,7 +2173,8 @@ fini:
 		/* count up leaf switches */
 		for (i = 0, switch_ptr = switch_record_table;
 		     i < switch_record_cnt; i++, switch_ptr++) {
-			if (switch_record_table[i].level != 0)
+			if ((switch_record_table[i].level != 0) ||
+			    !switch_node_bitmap[i])
 				continue;
 			if (bit_overlap_any(switch_node_bitmap[i], node_map))
 				leaf_switch_count++;
@@ -2316,13 +2376,13 @@ static int _eval_nodes_topo(job_record_t *job_ptr,
 	switch_node_cnt    = xcalloc(switch_record_cnt, sizeof(int));
 	switch_required    = xcalloc(switch_record_cnt, sizeof(int));
 
+	_topo_switch_node_cnt(node_map, switch_node_cnt);
 	for (i = 0, switch_ptr = switch_record_table; i < switch_record_cnt;
 	     i++, switch_ptr++) {
-		switch_node_bitmap[i] = bit_copy(switch_ptr->node_bitmap);
-		bit_and(switch_node_bitmap[i], node_map);
-		switch_node_cnt[i] = bit_set_count(switch_node_bitmap[i]);
+		if (!switch_node_cnt[i])
+			continue;
 		if (req_nodes_bitmap &&
-		    bit_overlap_any(req_nodes_bitmap, switch_node_bitmap[i])) {
+		    bit_overlap_any(req_nodes_bitmap, switch_ptr->node_bitmap)) {
 			switch_required[i] = 1;
 			if ((top_switch_inx == -1) ||
 			    (switch_record_table[i].level >
@@ -2335,7 +2395,7 @@ static int _eval_nodes_topo(job_record_t *job_ptr,
 			continue;
 		if (!req_nodes_bitmap &&
 		    (nw = list_find_first(node_weight_list, _topo_node_find,
-				    switch_node_bitmap[i]))) {
+				    switch_ptr->node_bitmap))) {
 			if ((top_switch_inx == -1) ||
 			    ((switch_record_table[i].level >=
 			      switch_record_table[top_switch_inx].level) &&
@@ -2346,6 +2406,14 @@ static int _eval_nodes_topo(job_record_t *job_ptr,
 		}
 	}
 
+	/*
+	 * Remove nodes from consideration that can not be reached from this
+	 * top level switch.
+	 */
+	if (top_switch_inx != -1)
+		_topo_switch_bitmaps(node_map, top_switch_inx,
+				     switch_node_bitmap);
+
 	if (!req_nodes_bitmap) {
 		bit_clear_all(node_map);
 	}
@@ -2373,17 +2441,6 @@ static int _eval_nodes_topo(job_record_t *job_ptr,
 		goto fini;
 	}
 
-	/*
-	 * Remove nodes from consideration that can not be reached from this
-	 * top level switch.
-	 */
-	for (i = 0; i < switch_record_cnt; i++) {
-		if (top_switch_inx != i) {
-			  bit_and(switch_node_bitmap[i],
-				  switch_node_bitmap[top_switch_inx]);
-		}
-	}
-
 	if (req_nodes_bitmap) {
 		bit_and(node_map, req_nodes_bitmap);
 		if ((rem_nodes <= 0) && (rem_cpus <= 0) &&
@@ -2520,7 +2577,7 @@ static int _eval_nodes_topo(job_record_t *job_ptr,
 
 		for (i = 0, switch_ptr = switch_record_table;
 		     i < switch_record_cnt; i++, switch_ptr++) {
-			if (switch_required[i])
+			if (switch_required[i] || !switch_node_bitmap[i])
 				continue;
 			if (bit_overlap_any(req2_nodes_bitmap,
 					    switch_node_bitmap[i])) {
@@ -2554,6 +2611,10 @@ static int _eval_nodes_topo(job_record_t *job_ptr,
 	avail_nodes_bitmap = bit_alloc(node_record_count);
 	for (i = 0, switch_ptr = switch_record_table; i < switch_record_cnt;
 	     i++, switch_ptr++) {
+		if (!switch_node_bitmap[i]) {
+			switch_node_cnt[i] = 0;
+			continue;
+		}
 		bit_and(switch_node_bitmap[i], best_nodes_bitmap);
 		bit_or(avail_nodes_bitmap, switch_node_bitmap[i]);
 		switch_node_cnt[i] = bit_set_count(switch_node_bitmap[i]);
@@ -2713,7 +2774,8 @@ fini:
 		/* Count up leaf switches. */
 		for (i = 0, switch_ptr = switch_record_table;
 		     i < switch_record_cnt; i++, switch_ptr++) {
-			if (switch_record_table[i].level != 0)
+			if ((switch_record_table[i].level != 0) ||
+			    !switch_node_bitmap[i])
 				continue;
 			if (bit_overlap_any(switch_node_bitmap[i], node_map))
 				leaf_switch_count++;
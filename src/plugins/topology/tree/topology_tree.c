@@ -445,6 +445,28 @@ static void _validate_switches(void)
 		}
 	}
 
+	/*
+	 * Flag the switches whose node count is the sum of their children's,
+	 * so node selection can aggregate the counts up the tree.
+	 */
+	for (i = 0; i < switch_record_cnt; i++) {
+		int node_cnt = 0;
+
+		switch_ptr = &switch_record_table[i];
+		if (!switch_ptr->num_switches || !switch_ptr->node_bitmap)
+			continue;
+		for (j = 0; j < switch_ptr->num_switches; j++) {
+			uint16_t child = switch_ptr->switch_index[j];
+
+			if (!switch_record_table[child].node_bitmap)
+				continue;
+			node_cnt += bit_set_count(
+				switch_record_table[child].node_bitmap);
+		}
+		switch_ptr->disjoint_children =
+			(node_cnt == bit_set_count(switch_ptr->node_bitmap));
+	}
+
 	for (i = 0; i < switch_record_cnt; i++) {
 		switch_record_table[i].switches_dist = xcalloc(
 			switch_record_cnt, sizeof(uint32_t));
@@ -60,6 +60,7 @@ uint32_t *rpc_type_ave_time = NULL, *rpc_user_ave_time = NULL;
 
 static int  _print_stats(void);
 static void _sort_rpc(void);
+static void _swap_rpc_type_auth_time(int i, int j);
 
 stats_info_request_msg_t req;
 
@@ -193,16 +194,55 @@ static int _print_stats(void)
 		       buf->bf_table_size_sum / buf->bf_cycle_counter);
 	}
 
+	printf("\nNode registration statistics (microseconds):\n");
+	printf("\tTotal registrations: %u\n", buf->node_reg_cnt);
+	if (buf->node_reg_cnt > 0) {
+		printf("\tMean time: %"PRIu64"\n",
+		       buf->node_reg_time_sum / buf->node_reg_cnt);
+		printf("\tMax time:  %u\n", buf->node_reg_time_max);
+	}
+	if ((buf->req_time - buf->req_time_start) > 60) {
+		printf("\tRegistrations per minute: %u\n",
+		       (uint32_t) (buf->node_reg_cnt /
+		       ((buf->req_time - buf->req_time_start) / 60)));
+	}
+
+	printf("\nAccounting policy statistics (microseconds):\n");
+	printf("\tTotal checks: %"PRIu64"\n", buf->acct_policy_cnt);
+	if (buf->acct_policy_cnt > 0) {
+		printf("\tMean time: %"PRIu64"\n",
+		       buf->acct_policy_time_sum / buf->acct_policy_cnt);
+		printf("\tMax time:  %u\n", buf->acct_policy_time_max);
+	}
+
+	if (buf->sched_cost_cnt) {
+		printf("\nCostliest pending jobs (microseconds):\n");
+		for (i = 0; i < buf->sched_cost_cnt; i++) {
+			printf("\tJobId=%-10u tests:%-6u total_time:%-10"PRIu64
+			       " ave_time:%"PRIu64"\n",
+			       buf->sched_cost_job_id[i],
+			       buf->sched_cost_tests[i],
+			       buf->sched_cost_usec[i],
+			       buf->sched_cost_usec[i] /
+			       MAX(buf->sched_cost_tests[i], 1));
+		}
+	}
+
 	printf("\nLatency for 1000 calls to gettimeofday(): %d microseconds\n",
 	       buf->gettimeofday_latency);
 
 	printf("\nRemote Procedure Call statistics by message type\n");
 	for (i = 0; i < buf->rpc_type_size; i++) {
 		printf("\t%-40s(%5u) count:%-6u "
-		       "ave_time:%-6u total_time:%"PRIu64"\n",
+		       "ave_time:%-6u total_time:%"PRIu64,
 		       rpc_num2string(buf->rpc_type_id[i]),
 		       buf->rpc_type_id[i], buf->rpc_type_cnt[i],
 		       rpc_type_ave_time[i], buf->rpc_type_time[i]);
+		if (buf->rpc_type_auth_time && buf->rpc_type_cnt[i])
+			printf(" ave_auth_time:%"PRIu64,
+			       buf->rpc_type_auth_time[i] /
+			       buf->rpc_type_cnt[i]);
+		printf("\n");
 	}
 
 	printf("\nRemote Procedure Call statistics by user\n");
@@ -267,6 +307,7 @@ static void _sort_rpc(void)
 				buf->rpc_type_id[j]   = type_id;
 				buf->rpc_type_cnt[j]  = type_cnt;
 				buf->rpc_type_time[j] = type_time;
+				_swap_rpc_type_auth_time(i, j);
 			}
 			if (buf->rpc_type_cnt[i]) {
 				rpc_type_ave_time[i] = buf->rpc_type_time[i] /
@@ -306,6 +347,7 @@ static void _sort_rpc(void)
 				buf->rpc_type_id[j]   = type_id;
 				buf->rpc_type_cnt[j]  = type_cnt;
 				buf->rpc_type_time[j] = type_time;
+				_swap_rpc_type_auth_time(i, j);
 			}
 			if (buf->rpc_type_cnt[i]) {
 				rpc_type_ave_time[i] = buf->rpc_type_time[i] /
@@ -354,6 +396,7 @@ static void _sort_rpc(void)
 				buf->rpc_type_id[j]   = type_id;
 				buf->rpc_type_cnt[j]  = type_cnt;
 				buf->rpc_type_time[j] = type_time;
+				_swap_rpc_type_auth_time(i, j);
 			}
 		}
 		for (i = 0; i < buf->rpc_user_size; i++) {
@@ -394,6 +437,7 @@ static void _sort_rpc(void)
 				buf->rpc_type_id[j]   = type_id;
 				buf->rpc_type_cnt[j]  = type_cnt;
 				buf->rpc_type_time[j] = type_time;
+				_swap_rpc_type_auth_time(i, j);
 			}
 			if (buf->rpc_type_cnt[i]) {
 				rpc_type_ave_time[i] = buf->rpc_type_time[i] /
@@ -421,3 +465,16 @@ static void _sort_rpc(void)
 		}
 	}
 }
+
+/* Keep the optional per-type auth time aligned with the sorted RPC types */
+static void _swap_rpc_type_auth_time(int i, int j)
+{
+	uint64_t auth_time;
+
+	if (!buf->rpc_type_auth_time)
+		return;
+
+	auth_time = buf->rpc_type_auth_time[i];
+	buf->rpc_type_auth_time[i] = buf->rpc_type_auth_time[j];
+	buf->rpc_type_auth_time[j] = auth_time;
+}
@@ -45,6 +45,8 @@
 #include "src/slurmctld/acct_policy.h"
 #include "src/common/node_select.h"
 #include "src/common/slurm_priority.h"
+#include "src/common/timers.h"
+#include "src/common/xhash.h"
 
 #define _DEBUG 0
 
@@ -76,6 +78,8 @@ typedef struct acct_policy_validate_args {
 	bool update_call;
 } acct_policy_validate_args_t;
 
+static pthread_mutex_t acct_policy_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 static void _apply_limit_factor(uint64_t *limit, double limit_factor)
 {
 	int64_t new_val;
@@ -537,26 +541,47 @@ static int _get_tres_state_reason(int tres_pos, int unk_reason)
 	return unk_reason;
 }
 
-static int _find_used_limits_for_acct(void *x, void *key)
+static void _used_limits_acct_id(void *item, const char **key,
+				 uint32_t *key_len)
 {
-	slurmdb_used_limits_t *used_limits = (slurmdb_used_limits_t *)x;
-	char *account = (char *)key;
+	slurmdb_used_limits_t *used_limits = (slurmdb_used_limits_t *)item;
 
-	if (!xstrcmp(account, used_limits->acct))
-		return 1;
+	*key = used_limits->acct ? used_limits->acct : "";
+	*key_len = strlen(*key);
+}
 
-	return 0;
+static void _used_limits_user_id(void *item, const char **key,
+				 uint32_t *key_len)
+{
+	slurmdb_used_limits_t *used_limits = (slurmdb_used_limits_t *)item;
+
+	*key = (const char *)&used_limits->uid;
+	*key_len = sizeof(used_limits->uid);
 }
 
-static int _find_used_limits_for_user(void *x, void *key)
+/*
+ * The lists are still what gets packed and printed, the hash tables only
+ * index them. Records are never removed from the lists on their own, so a
+ * count mismatch means the list was recreated or filled by someone else
+ * and the index is rebuilt from scratch.
+ */
+static xhash_t *_used_limits_hash(List list, void **hash,
+				  xhash_idfunc_t idfunc)
 {
-	slurmdb_used_limits_t *used_limits = (slurmdb_used_limits_t *)x;
-	uint32_t user_id = *(uint32_t *)key;
+	slurmdb_used_limits_t *used_limits;
+	ListIterator itr;
 
-	if (used_limits->uid == user_id)
-		return 1;
+	if (*hash && (xhash_count(*hash) == list_count(list)))
+		return *hash;
 
-	return 0;
+	xhash_free_ptr((xhash_t **) hash);
+	*hash = xhash_init(idfunc, NULL);
+	itr = list_iterator_create(list);
+	while ((used_limits = list_next(itr)))
+		xhash_add(*hash, used_limits);
+	list_iterator_destroy(itr);
+
+	return *hash;
 }
 
 static bool _valid_job_assoc(job_record_t *job_ptr)
@@ -598,13 +623,17 @@ static void _qos_adjust_limit_usage(int type, job_record_t *job_ptr,
 		return;
 
 	used_limits_a =	acct_policy_get_acct_used_limits(
-		&qos_ptr->usage->acct_limit_list,
+		qos_ptr->usage,
 		job_ptr->assoc_ptr->acct);
 
 	used_limits = acct_policy_get_user_used_limits(
-		&qos_ptr->usage->user_limit_list,
+		qos_ptr->usage,
 		job_ptr->user_id);
 
+	/* Submit counts are only checked at submit time */
+	if ((type == ACCT_POLICY_JOB_BEGIN) || (type == ACCT_POLICY_JOB_FINI))
+		assoc_mgr_usage_gen_bump(&qos_ptr->usage->usage_gen);
+
 	switch (type) {
 	case ACCT_POLICY_ADD_SUBMIT:
 		qos_ptr->usage->grp_used_submit_jobs += job_cnt;
@@ -957,6 +986,10 @@ static void _adjust_limit_usage(int type, job_record_t *job_ptr)
 
 	assoc_ptr = job_ptr->assoc_ptr;
 	while (assoc_ptr) {
+		if ((type == ACCT_POLICY_JOB_BEGIN) ||
+		    (type == ACCT_POLICY_JOB_FINI))
+			assoc_mgr_usage_gen_bump(&assoc_ptr->usage->usage_gen);
+
 		switch (type) {
 		case ACCT_POLICY_ADD_SUBMIT:
 			assoc_ptr->usage->used_submit_jobs += job_cnt;
@@ -1077,6 +1110,8 @@ static void _qos_alter_job(job_record_t *job_ptr,
 	if (!qos_ptr || !job_ptr)
 		return;
 
+	assoc_mgr_usage_gen_bump(&qos_ptr->usage->usage_gen);
+
 	for (i=0; i<slurmctld_tres_cnt; i++) {
 		if (used_tres_run_secs[i] == new_used_tres_run_secs[i])
 			continue;
@@ -1850,7 +1885,7 @@ static int _qos_policy_validate(job_desc_msg_t *job_desc,
 	    (qos_ptr->max_submit_jobs_pa != INFINITE)) {
 		slurmdb_used_limits_t *used_limits =
 			acct_policy_get_acct_used_limits(
-				&qos_ptr->usage->acct_limit_list,
+				qos_ptr->usage,
 				assoc_ptr->acct);
 
 		qos_out_ptr->max_submit_jobs_pa = qos_ptr->max_submit_jobs_pa;
@@ -1873,7 +1908,7 @@ static int _qos_policy_validate(job_desc_msg_t *job_desc,
 	    (qos_ptr->max_submit_jobs_pu != INFINITE)) {
 		slurmdb_used_limits_t *used_limits =
 			acct_policy_get_user_used_limits(
-				&qos_ptr->usage->user_limit_list,
+				qos_ptr->usage,
 				job_desc->user_id);
 
 		qos_out_ptr->max_submit_jobs_pu = qos_ptr->max_submit_jobs_pu;
@@ -1947,11 +1982,11 @@ static int _qos_job_runnable_pre_select(job_record_t *job_ptr,
 	wall_mins = qos_ptr->usage->grp_used_wall / 60;
 
 	used_limits_a =	acct_policy_get_acct_used_limits(
-		&qos_ptr->usage->acct_limit_list,
+		qos_ptr->usage,
 		assoc_ptr->acct);
 
 	used_limits = acct_policy_get_user_used_limits(
-		&qos_ptr->usage->user_limit_list,
+		qos_ptr->usage,
 		job_ptr->user_id);
 
 
@@ -2171,11 +2206,11 @@ static int _qos_job_runnable_post_select(job_record_t *job_ptr,
 	}
 
 	used_limits_a =	acct_policy_get_acct_used_limits(
-		&qos_ptr->usage->acct_limit_list,
+		qos_ptr->usage,
 		assoc_ptr->acct);
 
 	used_limits = acct_policy_get_user_used_limits(
-		&qos_ptr->usage->user_limit_list,
+		qos_ptr->usage,
 		job_ptr->user_id);
 
 	tres_usage = _validate_tres_usage_limits_for_qos(
@@ -2719,6 +2754,8 @@ extern void acct_policy_alter_job(job_record_t *job_ptr,
 
 	assoc_ptr = job_ptr->assoc_ptr;
 	while (assoc_ptr) {
+		assoc_mgr_usage_gen_bump(&assoc_ptr->usage->usage_gen);
+
 		for (i=0; i<slurmctld_tres_cnt; i++) {
 			if (used_tres_run_secs[i] == new_used_tres_run_secs[i])
 				continue;
@@ -3436,14 +3473,78 @@ extern bool acct_policy_job_runnable_state(job_record_t *job_ptr)
 }
 
 /*
- * acct_policy_job_runnable_pre_select - Determine if the specified
- *	job can execute right now or not depending upon accounting
- *	policy (e.g. running job limit for this association). If the
- *	association limits prevent the job from ever running (lowered
- *	limits since job submission), then cancel the job.
+ * Return the latest usage generation stamp of the associations and QOS the
+ * limits of the job are checked against. Call with the assoc_mgr assoc and
+ * qos read locks held.
  */
-extern bool acct_policy_job_runnable_pre_select(job_record_t *job_ptr,
-						bool assoc_mgr_locked)
+static uint64_t _job_limit_gen(job_record_t *job_ptr)
+{
+	slurmdb_qos_rec_t *qos_ptr_1, *qos_ptr_2;
+	slurmdb_assoc_rec_t *assoc_ptr;
+	uint64_t gen = assoc_mgr_usage_gen_all();
+
+	acct_policy_set_qos_order(job_ptr, &qos_ptr_1, &qos_ptr_2);
+	if (qos_ptr_1)
+		gen = MAX(gen, qos_ptr_1->usage->usage_gen);
+	if (qos_ptr_2)
+		gen = MAX(gen, qos_ptr_2->usage->usage_gen);
+
+	for (assoc_ptr = job_ptr->assoc_ptr; assoc_ptr;
+	     assoc_ptr = assoc_ptr->usage->parent_assoc_ptr)
+		gen = MAX(gen, assoc_ptr->usage->usage_gen);
+
+	return gen;
+}
+
+/*
+ * A job held by a pre_select limit stays held until the usage or the limits
+ * of its associations or QOS change, or the job itself is updated.
+ */
+static bool _job_limit_held(job_record_t *job_ptr)
+{
+	if (!job_ptr->limit_gen ||
+	    (job_ptr->limit_part_ptr != job_ptr->part_ptr) ||
+	    acct_policy_job_runnable_state(job_ptr))
+		return false;
+
+	return (job_ptr->limit_gen == _job_limit_gen(job_ptr));
+}
+
+/* Remember under which usage generation pre_select held the job */
+static void _set_job_limit_gen(job_record_t *job_ptr, bool runnable)
+{
+	if (runnable || acct_policy_job_runnable_state(job_ptr)) {
+		job_ptr->limit_gen = 0;
+		return;
+	}
+
+	job_ptr->limit_gen = _job_limit_gen(job_ptr);
+	job_ptr->limit_part_ptr = job_ptr->part_ptr;
+}
+
+/* Record the time of one runnable check for sdiag */
+static void _record_acct_policy_stats(long delta)
+{
+	slurm_mutex_lock(&acct_policy_stats_mutex);
+	slurmctld_diag_stats.acct_policy_cnt++;
+	slurmctld_diag_stats.acct_policy_time_sum += delta;
+	if (delta > slurmctld_diag_stats.acct_policy_time_max)
+		slurmctld_diag_stats.acct_policy_time_max = delta;
+	slurm_mutex_unlock(&acct_policy_stats_mutex);
+}
+
+/* Clear the runnable check statistics, see reset_stats() */
+extern void acct_policy_reset_stats(void)
+{
+	slurm_mutex_lock(&acct_policy_stats_mutex);
+	slurmctld_diag_stats.acct_policy_cnt = 0;
+	slurmctld_diag_stats.acct_policy_time_max = 0;
+	slurmctld_diag_stats.acct_policy_time_sum = 0;
+	slurm_mutex_unlock(&acct_policy_stats_mutex);
+}
+
+static bool _job_runnable_pre_select(job_record_t *job_ptr,
+				     bool assoc_mgr_locked)
 {
 	slurmdb_qos_rec_t *qos_ptr_1, *qos_ptr_2;
 	slurmdb_qos_rec_t qos_rec;
@@ -3472,6 +3573,15 @@ extern bool acct_policy_job_runnable_pre_select(job_record_t *job_ptr,
 	if (!(accounting_enforce & ACCOUNTING_ENFORCE_LIMITS))
 		return true;
 
+	if (!assoc_mgr_locked)
+		assoc_mgr_lock(&locks);
+
+	if (_job_limit_held(job_ptr)) {
+		if (!assoc_mgr_locked)
+			assoc_mgr_unlock(&locks);
+		return false;
+	}
+
 	/* clear old state reason */
 	if (!acct_policy_job_runnable_state(job_ptr)) {
 		xfree(job_ptr->state_desc);
@@ -3480,9 +3590,6 @@ extern bool acct_policy_job_runnable_pre_select(job_record_t *job_ptr,
 
 	slurmdb_init_qos_rec(&qos_rec, 0, INFINITE);
 
-	if (!assoc_mgr_locked)
-		assoc_mgr_lock(&locks);
-
 	assoc_mgr_set_qos_tres_cnt(&qos_rec);
 
 	acct_policy_set_qos_order(job_ptr, &qos_ptr_1, &qos_ptr_2);
@@ -3661,6 +3768,7 @@ extern bool acct_policy_job_runnable_pre_select(job_record_t *job_ptr,
 		parent = 1;
 	}
 end_it:
+	_set_job_limit_gen(job_ptr, rc);
 	if (!assoc_mgr_locked)
 		assoc_mgr_unlock(&locks);
 	slurmdb_free_qos_rec_members(&qos_rec);
@@ -3669,12 +3777,29 @@ end_it:
 }
 
 /*
- * acct_policy_job_runnable_post_select - After nodes have been
- *	selected for the job verify the counts don't exceed aggregated limits.
+ * acct_policy_job_runnable_pre_select - Determine if the specified
+ *	job can execute right now or not depending upon accounting
+ *	policy (e.g. running job limit for this association). If the
+ *	association limits prevent the job from ever running (lowered
+ *	limits since job submission), then cancel the job.
  */
-extern bool acct_policy_job_runnable_post_select(job_record_t *job_ptr,
-						 uint64_t *tres_req_cnt,
-						 bool assoc_mgr_locked)
+extern bool acct_policy_job_runnable_pre_select(job_record_t *job_ptr,
+						bool assoc_mgr_locked)
+{
+	bool rc;
+	DEF_TIMERS;
+
+	START_TIMER;
+	rc = _job_runnable_pre_select(job_ptr, assoc_mgr_locked);
+	END_TIMER;
+	_record_acct_policy_stats(DELTA_TIMER);
+
+	return rc;
+}
+
+static bool _job_runnable_post_select(job_record_t *job_ptr,
+				      uint64_t *tres_req_cnt,
+				      bool assoc_mgr_locked)
 {
 	slurmdb_qos_rec_t *qos_ptr_1, *qos_ptr_2;
 	slurmdb_qos_rec_t qos_rec;
@@ -4047,6 +4172,11 @@ extern bool acct_policy_job_runnable_post_select(job_record_t *job_ptr,
 		parent = 1;
 	}
 end_it:
+	/*
+	 * These checks depend on the nodes selected, which no usage stamp
+	 * follows, so only the pre_select verdicts are remembered.
+	 */
+	job_ptr->limit_gen = 0;
 	if (!assoc_mgr_locked)
 		assoc_mgr_unlock(&locks);
 	slurmdb_free_qos_rec_members(&qos_rec);
@@ -4054,6 +4184,26 @@ end_it:
 	return rc;
 }
 
+/*
+ * acct_policy_job_runnable_post_select - After nodes have been
+ *	selected for the job verify the counts don't exceed aggregated limits.
+ */
+extern bool acct_policy_job_runnable_post_select(job_record_t *job_ptr,
+						 uint64_t *tres_req_cnt,
+						 bool assoc_mgr_locked)
+{
+	bool rc;
+	DEF_TIMERS;
+
+	START_TIMER;
+	rc = _job_runnable_post_select(job_ptr, tres_req_cnt,
+				       assoc_mgr_locked);
+	END_TIMER;
+	_record_acct_policy_stats(DELTA_TIMER);
+
+	return rc;
+}
+
 extern uint32_t acct_policy_get_max_nodes(job_record_t *job_ptr,
 					  uint32_t *wait_reason)
 {
@@ -4484,10 +4634,10 @@ extern int acct_policy_handle_accrue_time(job_record_t *job_ptr,
 	qos_ptr = job_ptr->qos_ptr;
 	if (qos_ptr) {
 		used_limits_acct = acct_policy_get_acct_used_limits(
-			&qos_ptr->usage->acct_limit_list,
+			qos_ptr->usage,
 			assoc_ptr->acct);
 		used_limits_user = acct_policy_get_user_used_limits(
-				&qos_ptr->usage->user_limit_list,
+				qos_ptr->usage,
 				job_ptr->user_id);
 	}
 
@@ -4683,10 +4833,10 @@ extern void acct_policy_add_accrue_time(job_record_t *job_ptr,
 	qos_ptr = job_ptr->qos_ptr;
 	if (qos_ptr) {
 		used_limits_acct = acct_policy_get_acct_used_limits(
-			&qos_ptr->usage->acct_limit_list,
+			qos_ptr->usage,
 			assoc_ptr->acct);
 		used_limits_user = acct_policy_get_user_used_limits(
-				&qos_ptr->usage->user_limit_list,
+				qos_ptr->usage,
 				job_ptr->user_id);
 	}
 
@@ -4742,10 +4892,10 @@ extern void acct_policy_remove_accrue_time(job_record_t *job_ptr,
 	qos_ptr = job_ptr->qos_ptr;
 	if (qos_ptr) {
 		used_limits_acct = acct_policy_get_acct_used_limits(
-			&qos_ptr->usage->acct_limit_list,
+			qos_ptr->usage,
 			assoc_ptr->acct);
 		used_limits_user = acct_policy_get_user_used_limits(
-				&qos_ptr->usage->user_limit_list,
+				qos_ptr->usage,
 				job_ptr->user_id);
 	}
 
@@ -4895,24 +5045,27 @@ extern void acct_policy_set_qos_order(job_record_t *job_ptr,
 }
 
 /*
- * Checks for record in *user_limit_list of user_id if
- * *user_limit_list doesn't exist it will create it, if the user_id
+ * Checks for record in usage->acct_limit_list of acct if
+ * usage->acct_limit_list doesn't exist it will create it, if the acct
  * record doesn't exist it will add it to the list.
- * In all cases the user record is returned.
+ * In all cases the acct record is returned.
  */
 extern slurmdb_used_limits_t *acct_policy_get_acct_used_limits(
-	List *acct_limit_list, char *acct)
+	slurmdb_qos_usage_t *usage, char *acct)
 {
 	slurmdb_used_limits_t *used_limits;
+	xhash_t *hash;
 
-	xassert(acct_limit_list);
+	xassert(usage);
 
-	if (!*acct_limit_list)
-		*acct_limit_list = list_create(slurmdb_destroy_used_limits);
+	if (!usage->acct_limit_list)
+		usage->acct_limit_list =
+			list_create(slurmdb_destroy_used_limits);
 
-	if (!(used_limits = list_find_first(*acct_limit_list,
-					    _find_used_limits_for_acct,
-					    acct))) {
+	hash = _used_limits_hash(usage->acct_limit_list,
+				 &usage->acct_limit_hash,
+				 _used_limits_acct_id);
+	if (!(used_limits = xhash_get_str(hash, acct ? acct : ""))) {
 		int i = sizeof(uint64_t) * slurmctld_tres_cnt;
 
 		used_limits = xmalloc(sizeof(slurmdb_used_limits_t));
@@ -4921,31 +5074,36 @@ extern slurmdb_used_limits_t *acct_policy_get_acct_used_limits(
 		used_limits->tres = xmalloc(i);
 		used_limits->tres_run_mins = xmalloc(i);
 
-		list_append(*acct_limit_list, used_limits);
+		list_append(usage->acct_limit_list, used_limits);
+		xhash_add(hash, used_limits);
 	}
 
 	return used_limits;
 }
 
 /*
- * Checks for record in *user_limit_list of user_id if
- * *user_limit_list doesn't exist it will create it, if the user_id
+ * Checks for record in usage->user_limit_list of user_id if
+ * usage->user_limit_list doesn't exist it will create it, if the user_id
  * record doesn't exist it will add it to the list.
  * In all cases the user record is returned.
  */
 extern slurmdb_used_limits_t *acct_policy_get_user_used_limits(
-	List *user_limit_list, uint32_t user_id)
+	slurmdb_qos_usage_t *usage, uint32_t user_id)
 {
 	slurmdb_used_limits_t *used_limits;
+	xhash_t *hash;
 
-	xassert(user_limit_list);
+	xassert(usage);
 
-	if (!*user_limit_list)
-		*user_limit_list = list_create(slurmdb_destroy_used_limits);
+	if (!usage->user_limit_list)
+		usage->user_limit_list =
+			list_create(slurmdb_destroy_used_limits);
 
-	if (!(used_limits = list_find_first(*user_limit_list,
-					    _find_used_limits_for_user,
-					    &user_id))) {
+	hash = _used_limits_hash(usage->user_limit_list,
+				 &usage->user_limit_hash,
+				 _used_limits_user_id);
+	if (!(used_limits = xhash_get(hash, (const char *)&user_id,
+				      sizeof(user_id)))) {
 		int i = sizeof(uint64_t) * slurmctld_tres_cnt;
 
 		used_limits = xmalloc(sizeof(slurmdb_used_limits_t));
@@ -4954,7 +5112,8 @@ extern slurmdb_used_limits_t *acct_policy_get_user_used_limits(
 		used_limits->tres = xmalloc(i);
 		used_limits->tres_run_mins = xmalloc(i);
 
-		list_append(*user_limit_list, used_limits);
+		list_append(usage->user_limit_list, used_limits);
+		xhash_add(hash, used_limits);
 	}
 
 	return used_limits;
@@ -207,10 +207,17 @@ extern void acct_policy_set_qos_order(job_record_t *job_ptr,
 				      slurmdb_qos_rec_t **qos_ptr_1,
 				      slurmdb_qos_rec_t **qos_ptr_2);
 
+/*
+ * Return the used limits record of an account or user in the QOS, adding
+ * it if this is the first job of that account or user.
+ */
 extern slurmdb_used_limits_t *acct_policy_get_acct_used_limits(
-	List *acct_limit_list, char *acct);
+	slurmdb_qos_usage_t *usage, char *acct);
 
 extern slurmdb_used_limits_t *acct_policy_get_user_used_limits(
-	 List *user_limit_list, uint32_t user_id);
+	slurmdb_qos_usage_t *usage, uint32_t user_id);
+
+/* Clear the runnable check statistics reported by sdiag */
+extern void acct_policy_reset_stats(void);
 
 #endif /* !_HAVE_ACCT_POLICY_H */
@@ -760,6 +760,7 @@ int main(int argc, char **argv)
 		_slurmctld_background(NULL);
 
 		sched_g_fini();	/* Stop all scheduling */
+		sched_cost_fini();
 
 		/* termination of controller */
 		switch_g_save(slurm_conf.state_save_location);
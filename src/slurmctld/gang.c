@@ -51,6 +51,8 @@
 #include "src/common/macros.h"
 #include "src/common/node_select.h"
 #include "src/common/slurm_protocol_defs.h"
+#include "src/common/timers.h"
+#include "src/common/xhash.h"
 #include "src/common/xstring.h"
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/preempt.h"
@@ -89,6 +91,8 @@ struct gs_job {
 	job_record_t *job_ptr;
 	uint16_t sig_state;
 	uint16_t row_state;
+	bool shadow_cast;	/* in the shadow array of every partition
+				 * with a lower priority */
 };
 
 struct gs_part {
@@ -97,6 +101,7 @@ struct gs_part {
 	uint32_t num_jobs;
 	struct gs_job **job_list;
 	uint32_t job_list_size;
+	xhash_t *job_hash;	/* job_list entries by job_id */
 	uint32_t num_shadows;
 	struct gs_job **shadow;  /* see '"Shadow" Design' below */
 	uint32_t shadow_size;
@@ -140,6 +145,18 @@ struct gs_part {
  * are applied first.
  *
  ******************************************
+ *
+ *	Cost of the operations
+ *
+ * Jobs are found by job_id through the job_hash of each partition. The
+ * job_list and shadow arrays are ordered (timeslice order, shadow casting
+ * order), so removing a job from them still shifts the entries after it,
+ * and _clear_shadow() visits every partition with a shadow array. Building
+ * an active row walks the shadows and the job_list of the partition, so each
+ * timeslice and each job start or end in a partition costs a pass over the
+ * jobs of that partition and the lower priority ones.
+ *
+ ******************************************
  */
 
 
@@ -304,6 +321,7 @@ static void _destroy_parts(void *x)
 	xfree(gs_part_ptr->part_name);
 	for (i = 0; i < gs_part_ptr->num_jobs; i++)
 		xfree(gs_part_ptr->job_list[i]);
+	xhash_free(gs_part_ptr->job_hash);
 	xfree(gs_part_ptr->shadow);
 	FREE_NULL_BITMAP(gs_part_ptr->active_resmap);
 	xfree(gs_part_ptr->active_cpus);
@@ -352,15 +370,21 @@ static int _find_gs_part(void *x, void *key)
 	return 0;
 }
 
-/* Find the job_list index of the given job_id in the given partition */
-static int _find_job_index(struct gs_part *p_ptr, uint32_t job_id)
+static void _gs_job_id(void *item, const char **key, uint32_t *key_len)
 {
-	int i;
-	for (i = 0; i < p_ptr->num_jobs; i++) {
-		if (p_ptr->job_list[i]->job_ptr->job_id == job_id)
-			return i;
-	}
-	return -1;
+	struct gs_job *j_ptr = (struct gs_job *) item;
+
+	*key = (const char *) &j_ptr->job_id;
+	*key_len = sizeof(j_ptr->job_id);
+}
+
+/* Find the gs_job of the given job_id in the given partition */
+static struct gs_job *_find_job(struct gs_part *p_ptr, uint32_t job_id)
+{
+	if (!p_ptr->job_hash)
+		return NULL;
+	return xhash_get(p_ptr->job_hash, (const char *) &job_id,
+			 sizeof(job_id));
 }
 
 /* Return 1 if job "cpu count" fits in this row, else return 0 */
@@ -397,7 +421,6 @@ static int _job_fits_in_active_row(job_record_t *job_ptr,
 {
 	job_resources_t *job_res = job_ptr->job_resrcs;
 	int count;
-	bitstr_t *job_map;
 	uint16_t job_gr_type;
 
 	if ((p_ptr->active_resmap == NULL) || (p_ptr->jobs_active == 0))
@@ -411,12 +434,9 @@ static int _job_fits_in_active_row(job_record_t *job_ptr,
 	}
 
 	/* job_gr_type == GS_NODE || job_gr_type == GS_CPU */
-	job_map = bit_copy(job_res->node_bitmap);
-	bit_and(job_map, p_ptr->active_resmap);
-	/* any set bits indicate contention for the same resource */
-	count = bit_set_count(job_map);
+	/* any common bits indicate contention for the same resource */
+	count = bit_overlap(job_res->node_bitmap, p_ptr->active_resmap);
 	log_flag(GANG, "gang: %s: %d bits conflict", __func__, count);
-	FREE_NULL_BITMAP(job_map);
 	if (count == 0)
 		return 1;
 	if (job_gr_type == GS_CPU) {
@@ -672,7 +692,12 @@ static void _cast_shadow(struct gs_job *j_ptr, uint16_t priority)
 {
 	ListIterator part_iterator;
 	struct gs_part *p_ptr;
-	int i;
+
+	/* The set of lower priority partitions only changes on reconfig,
+	 * which rebuilds all of the gs_job records */
+	if (j_ptr->shadow_cast)
+		return;
+	j_ptr->shadow_cast = true;
 
 	part_iterator = list_iterator_create(gs_part_list);
 	while ((p_ptr = list_next(part_iterator))) {
@@ -686,14 +711,6 @@ static void _cast_shadow(struct gs_job *j_ptr, uint16_t priority)
 			p_ptr->shadow = xmalloc(p_ptr->shadow_size *
 						sizeof(struct gs_job *));
 			/* 'shadow' is initialized to be NULL filled */
-		} else {
-			/* does this shadow already exist? */
-			for (i = 0; i < p_ptr->num_shadows; i++) {
-				if (p_ptr->shadow[i] == j_ptr)
-					break;
-			}
-			if (i < p_ptr->num_shadows)
-				continue;
 		}
 
 		if (p_ptr->num_shadows+1 >= p_ptr->shadow_size) {
@@ -714,6 +731,10 @@ static void _clear_shadow(struct gs_job *j_ptr)
 	struct gs_part *p_ptr;
 	int i;
 
+	if (!j_ptr->shadow_cast)
+		return;
+	j_ptr->shadow_cast = false;
+
 	part_iterator = list_iterator_create(gs_part_list);
 	while ((p_ptr = list_next(part_iterator))) {
 		if (!p_ptr->shadow)
@@ -730,8 +751,8 @@ static void _clear_shadow(struct gs_job *j_ptr)
 		p_ptr->num_shadows--;
 
 		/* shift all other jobs down */
-		for (; i < p_ptr->num_shadows; i++)
-			p_ptr->shadow[i] = p_ptr->shadow[i+1];
+		memmove(&p_ptr->shadow[i], &p_ptr->shadow[i + 1],
+			(p_ptr->num_shadows - i) * sizeof(struct gs_job *));
 		p_ptr->shadow[p_ptr->num_shadows] = NULL;
 	}
 	 list_iterator_destroy(part_iterator);
@@ -856,6 +877,24 @@ static void _update_all_active_rows(void)
 	list_iterator_destroy(part_iterator);
 }
 
+/* rebuild the active rows affected by a job starting or ending in the
+ * given partition: that partition and the partitions with a lower priority,
+ * which are the only ones its shadow can fall on */
+static void _update_active_rows_from(struct gs_part *part_ptr)
+{
+	ListIterator part_iterator;
+	struct gs_part *p_ptr;
+
+	list_sort(gs_part_list, _sort_partitions);
+
+	part_iterator = list_iterator_create(gs_part_list);
+	while ((p_ptr = list_next(part_iterator))) {
+		if ((p_ptr == part_ptr) || (p_ptr->priority < part_ptr->priority))
+			_update_active_row(p_ptr, 1);
+	}
+	list_iterator_destroy(part_iterator);
+}
+
 /* remove the given job from the given partition
  * IN job_id - job to remove
  * IN p_ptr  - GS partition structure
@@ -871,12 +910,15 @@ static void _remove_job_from_part(uint32_t job_id, struct gs_part *p_ptr,
 		return;
 
 	/* find the job in the job_list */
-	i = _find_job_index(p_ptr, job_id);
-	if (i < 0)
+	if (!(j_ptr = _find_job(p_ptr, job_id)))
 		/* job not found */
 		return;
-
-	j_ptr = p_ptr->job_list[i];
+	for (i = 0; i < p_ptr->num_jobs; i++) {
+		if (p_ptr->job_list[i] == j_ptr)
+			break;
+	}
+	xassert(i < p_ptr->num_jobs);
+	xhash_delete(p_ptr->job_hash, (const char *) &job_id, sizeof(job_id));
 
 	log_flag(GANG, "gang: %s: removing %pJ from %s",
 		 __func__, j_ptr->job_ptr, p_ptr->part_name);
@@ -886,10 +928,9 @@ static void _remove_job_from_part(uint32_t job_id, struct gs_part *p_ptr,
 
 	/* remove the job from the job_list by shifting everyone else down */
 	p_ptr->num_jobs--;
-	for (; i < p_ptr->num_jobs; i++) {
-		p_ptr->job_list[i] = p_ptr->job_list[i+1];
-	}
-	p_ptr->job_list[i] = NULL;
+	memmove(&p_ptr->job_list[i], &p_ptr->job_list[i + 1],
+		(p_ptr->num_jobs - i) * sizeof(struct gs_job *));
+	p_ptr->job_list[p_ptr->num_jobs] = NULL;
 
 	/* make sure the job is not suspended by gang, and then delete it */
 	if (!fini && (j_ptr->sig_state == GS_SUSPEND) &&
@@ -910,7 +951,6 @@ static void _remove_job_from_part(uint32_t job_id, struct gs_part *p_ptr,
  * job (GS_SUSPEND or GS_RESUME) */
 static uint16_t _add_job_to_part(struct gs_part *p_ptr, job_record_t *job_ptr)
 {
-	int i;
 	struct gs_job *j_ptr;
 	uint16_t preempt_mode;
 
@@ -930,10 +970,11 @@ static uint16_t _add_job_to_part(struct gs_part *p_ptr, job_record_t *job_ptr)
 					  sizeof(struct gs_job *));
 		/* job_list is initialized to be NULL filled */
 	}
+	if (!p_ptr->job_hash)
+		p_ptr->job_hash = xhash_init(_gs_job_id, NULL);
 
 	/* protect against duplicates */
-	i = _find_job_index(p_ptr, job_ptr->job_id);
-	if (i >= 0) {
+	if (_find_job(p_ptr, job_ptr->job_id)) {
 		/* This job already exists, but the resource allocation
 		 * may have changed. In any case, remove the existing
 		 * job before adding this new one.
@@ -961,6 +1002,7 @@ static uint16_t _add_job_to_part(struct gs_part *p_ptr, job_record_t *job_ptr)
 
 	/* append this job to the job_list */
 	p_ptr->job_list[p_ptr->num_jobs++] = j_ptr;
+	xhash_add(p_ptr->job_hash, j_ptr);
 
 	/* determine the immediate fate of this job (run or suspend) */
 	if (!IS_JOB_SUSPENDED(job_ptr) &&
@@ -1003,7 +1045,6 @@ static void _scan_slurm_job_list(void)
 {
 	job_record_t *job_ptr;
 	struct gs_part *p_ptr;
-	int i;
 	ListIterator job_iterator;
 	char *part_name;
 
@@ -1037,8 +1078,8 @@ static void _scan_slurm_job_list(void)
 						part_name);
 			if (!p_ptr) /* no partition */
 				continue;
-			i = _find_job_index(p_ptr, job_ptr->job_id);
-			if (i >= 0) /* we're tracking it, so continue */
+			if (_find_job(p_ptr, job_ptr->job_id))
+				/* we're tracking it, so continue */
 				continue;
 
 			/* We're not tracking this job. Resume it if it's
@@ -1186,7 +1227,7 @@ extern void gs_job_start(job_record_t *job_ptr)
 		job_sig_state = _add_job_to_part(p_ptr, job_ptr);
 		/* if this job is running then check for preemption */
 		if (job_sig_state == GS_RESUME)
-			_update_all_active_rows();
+			_update_active_rows_from(p_ptr);
 	}
 	slurm_mutex_unlock(&data_mutex);
 
@@ -1260,8 +1301,8 @@ extern void gs_job_fini(job_record_t *job_ptr)
 	/* remove job from the partition */
 	_remove_job_from_part(job_ptr->job_id, p_ptr, true);
 	/* this job may have preempted other jobs, so
-	 * check by updating all active rows */
-	_update_all_active_rows();
+	 * check by updating the active rows it shadowed */
+	_update_active_rows_from(p_ptr);
 	slurm_mutex_unlock(&data_mutex);
 	log_flag(GANG, "gang: leaving gs_job_fini");
 }
@@ -1429,26 +1470,25 @@ static void _build_active_row(struct gs_part *p_ptr)
  */
 static void _cycle_job_list(struct gs_part *p_ptr)
 {
-	int i, j;
-	struct gs_job *j_ptr;
+	int i, j, k;
+	struct gs_job *j_ptr, **active_jobs;
 	uint16_t preempt_mode;
 
 	log_flag(GANG, "gang: entering %s", __func__);
-	/* re-prioritize the job_list and set all row_states to GS_NO_ACTIVE */
-	for (i = 0; i < p_ptr->num_jobs; i++) {
-		while (p_ptr->job_list[i]->row_state == GS_ACTIVE) {
-			/* move this job to the back row and "deactivate" it */
-			j_ptr = p_ptr->job_list[i];
-			j_ptr->row_state = GS_NO_ACTIVE;
-			for (j = i; j+1 < p_ptr->num_jobs; j++) {
-				p_ptr->job_list[j] = p_ptr->job_list[j+1];
-			}
-			p_ptr->job_list[j] = j_ptr;
-		}
-		if (p_ptr->job_list[i]->row_state == GS_FILLER)
-			p_ptr->job_list[i]->row_state = GS_NO_ACTIVE;
-
+	/* re-prioritize the job_list and set all row_states to GS_NO_ACTIVE:
+	 * the GS_ACTIVE jobs move to the back row in a single pass, both
+	 * groups keeping their relative order */
+	active_jobs = xmalloc(sizeof(struct gs_job *) * (p_ptr->num_jobs + 1));
+	for (i = 0, j = 0, k = 0; i < p_ptr->num_jobs; i++) {
+		j_ptr = p_ptr->job_list[i];
+		if (j_ptr->row_state == GS_ACTIVE)
+			active_jobs[k++] = j_ptr;
+		else
+			p_ptr->job_list[j++] = j_ptr;
+		j_ptr->row_state = GS_NO_ACTIVE;
 	}
+	memcpy(&p_ptr->job_list[j], active_jobs, k * sizeof(struct gs_job *));
+	xfree(active_jobs);
 	log_flag(GANG, "gang: %s reordered job list:", __func__);
 	/* Rebuild the active row. */
 	_build_active_row(p_ptr);
@@ -1512,6 +1552,7 @@ static void *_timeslicer_thread(void *arg)
 		NO_LOCK, WRITE_LOCK, READ_LOCK, NO_LOCK, READ_LOCK };
 	ListIterator part_iterator;
 	struct gs_part *p_ptr;
+	DEF_TIMERS;
 
 	log_flag(GANG, "gang: starting timeslicer loop");
 	while (!thread_shutdown) {
@@ -1521,6 +1562,7 @@ static void *_timeslicer_thread(void *arg)
 
 		lock_slurmctld(job_write_lock);
 		slurm_mutex_lock(&data_mutex);
+		START_TIMER;
 		list_sort(gs_part_list, _sort_partitions);
 
 		/* scan each partition... */
@@ -1536,6 +1578,9 @@ static void *_timeslicer_thread(void *arg)
 			}
 		}
 		list_iterator_destroy(part_iterator);
+		END_TIMER;
+		log_flag(GANG, "gang: %s: timeslice cycle %s",
+			 __func__, TIME_STR);
 		slurm_mutex_unlock(&data_mutex);
 
 		/* Preempt jobs that were formerly only suspended */
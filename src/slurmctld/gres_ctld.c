@@ -86,9 +86,15 @@ static bool _cores_on_gres(bitstr_t *core_bitmap, bitstr_t *alloc_core_bitmap,
 		if (bit_size(node_gres_ptr->topo_core_bitmap[i]) !=
 		    bit_size(core_bitmap))
 			break;
+		if (!alloc_core_bitmap) {
+			if (bit_overlap_any(node_gres_ptr->topo_core_bitmap[i],
+					    core_bitmap))
+				return true;
+			continue;
+		}
 		avail_cores = bit_overlap(node_gres_ptr->topo_core_bitmap[i],
 					  core_bitmap);
-		if (avail_cores && alloc_core_bitmap) {
+		if (avail_cores) {
 			avail_cores -= bit_overlap(node_gres_ptr->
 						   topo_core_bitmap[i],
 						   alloc_core_bitmap);
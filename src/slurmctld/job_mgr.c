@@ -1164,6 +1164,9 @@ extern int load_all_job_state(void)
 	uint32_t ver_str_len;
 	uint16_t protocol_version = NO_VAL16;
 
+	/* The loaded jobs replace any which were indexed before */
+	slurm_preempt_index_reset();
+
 	/* read the file */
 	lock_state_files();
 	if (!(buffer = _open_job_state_file(&state_file))) {
@@ -9630,6 +9633,7 @@ static void _list_delete_job(void *job_entry)
 	xassert (job_ptr->magic == JOB_MAGIC);
 	job_ptr->magic = 0;	/* make sure we don't delete record twice */
 
+	sched_cost_remove(job_ptr);
 	_delete_job_common(job_ptr);
 
 	if (job_ptr->array_recs) {
@@ -12231,6 +12235,9 @@ static int _update_job(job_record_t *job_ptr, job_desc_msg_t *job_specs,
 	if (job_ptr->db_index == NO_VAL64)
 		return ESLURM_JOB_SETTING_DB_INX;
 
+	/* Any change may lift a limit, so evaluate them again */
+	job_ptr->limit_gen = 0;
+
 	operator = validate_operator(uid);
 	if (job_specs->burst_buffer) {
 		/*
@@ -13482,6 +13489,7 @@ static int _update_job(job_record_t *job_ptr, job_desc_msg_t *job_specs,
 				} else
 					job_ptr->state_reason = WAIT_HELD;
 				xfree(job_ptr->state_desc);
+				sched_cost_remove(job_ptr);
 
 				/* remove pending remote sibling jobs */
 				if (IS_JOB_PENDING(job_ptr) &&
@@ -16133,6 +16141,7 @@ extern void job_completion_logger(job_record_t *job_ptr, bool requeue)
 	xassert(job_ptr);
 
 	acct_policy_remove_job_submit(job_ptr);
+	sched_cost_remove(job_ptr);
 	if (job_ptr->nodes && ((job_ptr->bit_flags & JOB_KILL_HURRY) == 0)
 	    && !IS_JOB_RESIZING(job_ptr)) {
 		(void) bb_g_job_start_stage_out(job_ptr);
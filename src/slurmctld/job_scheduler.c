@@ -1017,6 +1017,7 @@ static int _schedule(bool full_queue)
 	bool fail_by_part, wait_on_resv;
 	uint32_t deadline_time_limit, save_time_limit = 0;
 	uint32_t prio_reserve;
+	struct timeval test_start;
 	DEF_TIMERS;
 
 	if (slurmctld_config.shutdown_time)
@@ -1714,8 +1715,12 @@ next_task:
 			goto skip_start;
 		}
 
+		gettimeofday(&test_start, NULL);
 		error_code = select_nodes(job_ptr, false, NULL, NULL, false,
 					  SLURMDB_JOB_FLAG_SCHED);
+		sched_cost_add(job_ptr, "main", "select_nodes",
+			       slurmctld_diag_stats.schedule_cycle_counter + 1,
+			       &test_start);
 
 		if (error_code == SLURM_SUCCESS) {
 			/*
@@ -4872,20 +4877,10 @@ static int _valid_feature_list(job_record_t *job_ptr, bool can_reboot)
 static int _valid_node_feature(char *feature, bool can_reboot)
 {
 	int rc = ESLURM_INVALID_FEATURE;
-	node_feature_t *feature_ptr;
-	ListIterator feature_iter;
+	feature_dict_t *dict_ptr = find_feature_dict(feature);
 
-	if (can_reboot)
-		feature_iter = list_iterator_create(avail_feature_list);
-	else
-		feature_iter = list_iterator_create(active_feature_list);
-	while ((feature_ptr = list_next(feature_iter))) {
-		if (xstrcmp(feature_ptr->name, feature))
-			continue;
+	if (dict_ptr && (can_reboot ? dict_ptr->avail : dict_ptr->active))
 		rc = SLURM_SUCCESS;
-		break;
-	}
-	list_iterator_destroy(feature_iter);
 
 	return rc;
 }
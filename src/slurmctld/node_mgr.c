@@ -2196,6 +2196,7 @@ static int _update_node_gres(char *node_names, char *gres)
 			}
 			gres_node_state_log(node_ptr->gres_list,
 					    node_ptr->name);
+			select_g_update_node_config(i);
 		}
 
 		overlap2 = bit_set_count(config_ptr->node_bitmap);
@@ -4277,6 +4278,7 @@ extern int send_nodes_to_accounting(time_t event_time)
 /* node_fini - free all memory associated with node records */
 extern void node_fini (void)
 {
+	feature_dict_fini();
 	FREE_NULL_LIST(active_feature_list);
 	FREE_NULL_LIST(avail_feature_list);
 	FREE_NULL_BITMAP(avail_node_bitmap);
@@ -496,47 +496,63 @@ static void _log_feature_nodes(job_feature_t  *job_feat_ptr)
 	xfree(tmp4);
 }
 
+/*
+ * Set *job_bitmap to the nodes of a feature_list record, or clear it if the
+ * record is NULL. *job_bitmap is reused when already allocated.
+ */
+static void _set_feature_bitmap(bitstr_t **job_bitmap,
+				node_feature_t *node_feat_ptr)
+{
+	if (*job_bitmap && (bit_size(*job_bitmap) != node_record_count))
+		FREE_NULL_BITMAP(*job_bitmap);
+
+	if (node_feat_ptr && node_feat_ptr->node_bitmap) {
+		if (*job_bitmap)
+			bit_copybits(*job_bitmap, node_feat_ptr->node_bitmap);
+		else
+			*job_bitmap = bit_copy(node_feat_ptr->node_bitmap);
+	} else if (*job_bitmap) {
+		bit_clear_all(*job_bitmap);
+	} else {
+		*job_bitmap = bit_alloc(node_record_count);
+	}
+}
+
 /*
  * For every element in the feature_list, identify the nodes with that feature
  * either active or available and set the feature_list's node_bitmap_active and
  * node_bitmap_avail fields accordingly.
+ *
+ * Each element is bound to its feature dictionary entry once, and again only
+ * if the dictionary changes, so this is reduced to copying node bitmaps.
  */
 extern void find_feature_nodes(List feature_list, bool can_reboot)
 {
 	ListIterator feat_iter;
 	job_feature_t  *job_feat_ptr;
-	node_feature_t *node_feat_ptr;
+	feature_dict_t *dict_ptr;
 
 	if (!feature_list)
 		return;
 	feat_iter = list_iterator_create(feature_list);
 	while ((job_feat_ptr = list_next(feat_iter))) {
-		FREE_NULL_BITMAP(job_feat_ptr->node_bitmap_active);
-		FREE_NULL_BITMAP(job_feat_ptr->node_bitmap_avail);
-		node_feat_ptr = list_find_first(active_feature_list,
-						list_find_feature,
-						job_feat_ptr->name);
-		if (node_feat_ptr && node_feat_ptr->node_bitmap) {
-			job_feat_ptr->node_bitmap_active =
-				bit_copy(node_feat_ptr->node_bitmap);
-		} else {	/* This feature not active */
-			job_feat_ptr->node_bitmap_active =
-				bit_alloc(node_record_count);
+		if (job_feat_ptr->dict_gen != feature_dict_gen) {
+			job_feat_ptr->dict_ptr =
+				find_feature_dict(job_feat_ptr->name);
+			job_feat_ptr->dict_gen = feature_dict_gen;
 		}
+		dict_ptr = job_feat_ptr->dict_ptr;
+
+		/* Without a record, this feature is not active */
+		_set_feature_bitmap(&job_feat_ptr->node_bitmap_active,
+				    dict_ptr ? dict_ptr->active : NULL);
 		if (can_reboot && job_feat_ptr->changeable) {
-			node_feat_ptr = list_find_first(avail_feature_list,
-							list_find_feature,
-							job_feat_ptr->name);
-			if (node_feat_ptr && node_feat_ptr->node_bitmap) {
-				job_feat_ptr->node_bitmap_avail =
-					bit_copy(node_feat_ptr->node_bitmap);
-			} else {   /* This feature not available */
-				job_feat_ptr->node_bitmap_avail =
-					bit_alloc(node_record_count);
-			}
-		} else if (job_feat_ptr->node_bitmap_active) {
-			job_feat_ptr->node_bitmap_avail =
-				bit_copy(job_feat_ptr->node_bitmap_active);
+			/* Without a record, this feature is not available */
+			_set_feature_bitmap(&job_feat_ptr->node_bitmap_avail,
+					    dict_ptr ? dict_ptr->avail : NULL);
+		} else {
+			_set_feature_bitmap(&job_feat_ptr->node_bitmap_avail,
+					    dict_ptr ? dict_ptr->active : NULL);
 		}
 
 		_log_feature_nodes(job_feat_ptr);
@@ -675,6 +691,7 @@ extern bitstr_t *build_active_feature_bitmap2(char *reboot_features)
 {
 	char *tmp, *sep;
 	bitstr_t *active_node_bitmap = NULL;
+	feature_dict_t *dict_ptr;
 	node_feature_t *node_feat_ptr;
 
 	if (!reboot_features || (reboot_features[0] == '\0')) {
@@ -687,8 +704,8 @@ extern bitstr_t *build_active_feature_bitmap2(char *reboot_features)
 	sep = strchr(tmp, ',');
 	if (sep) {
 		sep[0] = '\0';
-		node_feat_ptr = list_find_first(active_feature_list,
-						list_find_feature, sep + 1);
+		dict_ptr = find_feature_dict(sep + 1);
+		node_feat_ptr = dict_ptr ? dict_ptr->active : NULL;
 		if (node_feat_ptr && node_feat_ptr->node_bitmap) {
 			active_node_bitmap =
 				bit_copy(node_feat_ptr->node_bitmap);
@@ -696,8 +713,8 @@ extern bitstr_t *build_active_feature_bitmap2(char *reboot_features)
 			active_node_bitmap = bit_alloc(node_record_count);
 		}
 	}
-	node_feat_ptr = list_find_first(active_feature_list, list_find_feature,
-					tmp);
+	dict_ptr = find_feature_dict(tmp);
+	node_feat_ptr = dict_ptr ? dict_ptr->active : NULL;
 	if (node_feat_ptr && node_feat_ptr->node_bitmap) {
 		if (active_node_bitmap) {
 			bit_and(active_node_bitmap, node_feat_ptr->node_bitmap);
@@ -929,7 +946,7 @@ static void _find_qos_grp_node_bitmap(job_record_t *job_ptr,
 	    (qos_ptr->max_tres_pu_ctld[TRES_ARRAY_NODE] != INFINITE64)) {
 		*per_user_limit = true;
 		used_limits = acct_policy_get_user_used_limits(
-			&qos_ptr->usage->user_limit_list,
+			qos_ptr->usage,
 			job_ptr->user_id);
 		if (used_limits && used_limits->node_bitmap) {
 			if (*grp_node_bitmap)
@@ -946,7 +963,7 @@ static void _find_qos_grp_node_bitmap(job_record_t *job_ptr,
 	    (qos_ptr->max_tres_pa_ctld[TRES_ARRAY_NODE] != INFINITE64)) {
 		*per_acct_limit = true;
 		used_limits = acct_policy_get_acct_used_limits(
-			&qos_ptr->usage->acct_limit_list,
+			qos_ptr->usage,
 			job_ptr->assoc_ptr->acct);
 		if (used_limits && used_limits->node_bitmap) {
 			if (*grp_node_bitmap)
@@ -1225,15 +1242,15 @@ static int _get_req_features(struct node_set *node_set_ptr, int node_set_size,
 				    (prev_node_set_ptr->flags &
 				     NODE_SET_REBOOT))
 					continue;
+				if (bit_super_set(node_set_ptr[i].my_bitmap,
+						  feat_ptr->node_bitmap_active)) {
+					/* No inactive nodes (require reboot) */
+					continue;
+				}
 				inactive_bitmap =
 					bit_copy(node_set_ptr[i].my_bitmap);
 				bit_and_not(inactive_bitmap,
 					    feat_ptr->node_bitmap_active);
-				if (bit_ffs(inactive_bitmap) == -1) {
-					/* No inactive nodes (require reboot) */
-					FREE_NULL_BITMAP(inactive_bitmap);
-					continue;
-				}
 				sort_again = true;
 				if (bit_equal(prev_node_set_ptr->my_bitmap,
 					      inactive_bitmap)) {
@@ -2182,6 +2199,7 @@ static void _end_null_job(job_record_t *job_ptr)
 	gres_ctld_job_clear(job_ptr->gres_list_alloc);
 	job_ptr->job_state = JOB_RUNNING;
 	job_ptr->bit_flags |= JOB_WAS_RUNNING;
+	sched_cost_remove(job_ptr);
 	FREE_NULL_BITMAP(job_ptr->node_bitmap);
 	xfree(job_ptr->nodes);
 	xfree(job_ptr->sched_nodes);
@@ -2691,6 +2709,8 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 
 	job_ptr->job_state = JOB_RUNNING;
 	job_ptr->bit_flags |= JOB_WAS_RUNNING;
+	slurm_preempt_job_started(job_ptr);
+	sched_cost_remove(job_ptr);
 
 	if (select_g_select_nodeinfo_set(job_ptr) != SLURM_SUCCESS) {
 		error("select_g_select_nodeinfo_set(%pJ): %m", job_ptr);
@@ -1278,6 +1278,8 @@ extern int update_part(update_part_msg_t * part_desc, bool create_flag)
 	}
 
 	last_part_update = time(NULL);
+	/* The partition QOS and limits apply to the jobs held by a limit */
+	assoc_mgr_usage_gen_bump(NULL);
 
 	if (part_desc->billing_weights_str &&
 	    set_partition_billing_weights(part_desc->billing_weights_str,
@@ -53,6 +53,18 @@
 
 static bool youngest_order = false;
 
+/*
+ * Ids of the jobs which have been started, so the search for preemption
+ * candidates does not walk the pending and finished jobs, which are most of
+ * job_list on a busy cluster. Entries of jobs which are neither running nor
+ * suspended anymore are dropped by the search.
+ */
+static pthread_mutex_t run_index_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t *run_index = NULL;
+static int run_index_cnt = 0;
+static int run_index_size = 0;
+static bool run_index_valid = false;
+
 typedef struct slurm_preempt_ops {
 	bool		(*job_preempt_check)  (job_queue_rec_t *preemptor,
 					       job_queue_rec_t *preemptee);
@@ -181,6 +193,61 @@ static int _add_preemptable_job(void *x, void *arg)
 	return 0;
 }
 
+/* Call with run_index_lock held */
+static void _run_index_add(job_record_t *job_ptr)
+{
+	if (job_ptr->preempt_indexed)
+		return;
+
+	if (run_index_cnt >= run_index_size) {
+		run_index_size = MAX(1024, run_index_size * 2);
+		xrecalloc(run_index, run_index_size, sizeof(uint32_t));
+	}
+	run_index[run_index_cnt++] = job_ptr->job_id;
+	job_ptr->preempt_indexed = true;
+}
+
+static int _run_index_add_job(void *x, void *arg)
+{
+	job_record_t *job_ptr = (job_record_t *) x;
+
+	job_ptr->preempt_indexed = false;
+	if (IS_JOB_RUNNING(job_ptr) || IS_JOB_SUSPENDED(job_ptr))
+		_run_index_add(job_ptr);
+
+	return 0;
+}
+
+/*
+ * Call _add_preemptable_job() for every running or suspended job, dropping
+ * the index entries of the jobs which are not anymore.
+ * Call with run_index_lock held.
+ */
+static void _run_index_for_each(preempt_candidates_t *candidates)
+{
+	job_record_t *job_ptr;
+	int i = 0;
+
+	if (!run_index_valid) {
+		run_index_cnt = 0;
+		list_for_each(job_list, _run_index_add_job, NULL);
+		run_index_valid = true;
+	}
+
+	while (i < run_index_cnt) {
+		job_ptr = find_job_record(run_index[i]);
+		if (!job_ptr ||
+		    (!IS_JOB_RUNNING(job_ptr) && !IS_JOB_SUSPENDED(job_ptr))) {
+			if (job_ptr)
+				job_ptr->preempt_indexed = false;
+			run_index[i] = run_index[--run_index_cnt];
+			continue;
+		}
+		(void) _add_preemptable_job(job_ptr, candidates);
+		i++;
+	}
+}
+
 static int _sort_by_prio(void *x, void *y)
 {
 	int rc;
@@ -263,9 +330,31 @@ extern int slurm_preempt_fini(void)
 	init_run = false;
 	rc = plugin_context_destroy(g_context);
 	g_context = NULL;
+
+	slurm_mutex_lock(&run_index_lock);
+	xfree(run_index);
+	run_index_cnt = run_index_size = 0;
+	run_index_valid = false;
+	slurm_mutex_unlock(&run_index_lock);
+
 	return rc;
 }
 
+extern void slurm_preempt_job_started(job_record_t *job_ptr)
+{
+	slurm_mutex_lock(&run_index_lock);
+	if (run_index_valid)
+		_run_index_add(job_ptr);
+	slurm_mutex_unlock(&run_index_lock);
+}
+
+extern void slurm_preempt_index_reset(void)
+{
+	slurm_mutex_lock(&run_index_lock);
+	run_index_valid = false;
+	slurm_mutex_unlock(&run_index_lock);
+}
+
 extern List slurm_find_preemptable_jobs(job_record_t *job_ptr)
 {
 	preempt_candidates_t candidates	= { .preemptor = job_ptr };
@@ -291,8 +380,11 @@ extern List slurm_find_preemptable_jobs(job_record_t *job_ptr)
 
 	/* Build an array of pointers to preemption candidates */
 	if (slurm_preemption_enabled() ||
-	    job_uses_max_start_delay_resv(job_ptr))
-		list_for_each(job_list, _add_preemptable_job, &candidates);
+	    job_uses_max_start_delay_resv(job_ptr)) {
+		slurm_mutex_lock(&run_index_lock);
+		_run_index_for_each(&candidates);
+		slurm_mutex_unlock(&run_index_lock);
+	}
 
 	if (candidates.preemptee_job_list && youngest_order)
 		list_sort(candidates.preemptee_job_list, _sort_by_youngest);
@@ -65,6 +65,19 @@ int slurm_preempt_init(void);
  */
 extern int slurm_preempt_fini(void);
 
+/*
+ * Add a job which was just allocated resources to the index searched for
+ * preemption candidates. Jobs leaving the running and suspended states are
+ * dropped from the index by the next search.
+ */
+extern void slurm_preempt_job_started(job_record_t *job_ptr);
+
+/*
+ * Rebuild the index of started jobs from job_list on the next search, used
+ * after the job state has been (re)loaded.
+ */
+extern void slurm_preempt_index_reset(void);
+
 /*
  * slurm_find_preemptable_jobs - Given a pointer to a pending job, return list
  *	of pointers to preemptable jobs. The jobs should be sorted in order
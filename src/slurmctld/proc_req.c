@@ -109,6 +109,7 @@ static pthread_mutex_t rpc_mutex = PTHREAD_MUTEX_INITIALIZER;
 static uint16_t rpc_type_id[RPC_TYPE_SIZE] = { 0 };
 static uint32_t rpc_type_cnt[RPC_TYPE_SIZE] = { 0 };
 static uint64_t rpc_type_time[RPC_TYPE_SIZE] = { 0 };
+static uint64_t rpc_type_auth_time[RPC_TYPE_SIZE] = { 0 };
 #define RPC_USER_SIZE 200
 static uint32_t rpc_user_id[RPC_USER_SIZE] = { 0 };
 static uint32_t rpc_user_cnt[RPC_USER_SIZE] = { 0 };
@@ -148,6 +149,8 @@ static int          _route_msg_to_origin(slurm_msg_t *msg, char *job_id_str,
 static void         _throttle_fini(int *active_rpc_cnt);
 static void         _throttle_start(int *active_rpc_cnt);
 
+static void _record_node_reg_stats(long delta);
+static void _slurm_rpc_node_registration_resp(slurm_msg_t *msg);
 static void _update_cred_key(void);
 
 extern diag_stats_t slurmctld_diag_stats;
@@ -175,6 +178,7 @@ extern void record_rpc_stats(slurm_msg_t *msg, long delta)
 			continue;
 		rpc_type_cnt[i]++;
 		rpc_type_time[i] += delta;
+		rpc_type_auth_time[i] += msg->auth_time;
 		break;
 	}
 	for (int i = 0; i < RPC_USER_SIZE; i++) {
@@ -189,6 +193,25 @@ extern void record_rpc_stats(slurm_msg_t *msg, long delta)
 	slurm_mutex_unlock(&rpc_mutex);
 }
 
+static void _record_node_reg_stats(long delta)
+{
+	slurm_mutex_lock(&rpc_mutex);
+	slurmctld_diag_stats.node_reg_cnt++;
+	slurmctld_diag_stats.node_reg_time_sum += delta;
+	if (delta > slurmctld_diag_stats.node_reg_time_max)
+		slurmctld_diag_stats.node_reg_time_max = delta;
+	slurm_mutex_unlock(&rpc_mutex);
+}
+
+extern void reset_node_reg_stats(void)
+{
+	slurm_mutex_lock(&rpc_mutex);
+	slurmctld_diag_stats.node_reg_cnt = 0;
+	slurmctld_diag_stats.node_reg_time_max = 0;
+	slurmctld_diag_stats.node_reg_time_sum = 0;
+	slurm_mutex_unlock(&rpc_mutex);
+}
+
 /* These functions prevent certain RPCs from keeping the slurmctld write locks
  * constantly set, which can prevent other RPCs and system functions from being
  * processed. For example, a steady stream of batch submissions can prevent
@@ -2700,10 +2723,10 @@ send_reply:
 
 static bool _node_has_feature(node_record_t *node_ptr, char *feature)
 {
+	feature_dict_t *dict_ptr = find_feature_dict(feature);
 	node_feature_t *node_feature;
 
-	if ((node_feature = list_find_first(active_feature_list,
-					    list_find_feature, feature))) {
+	if (dict_ptr && (node_feature = dict_ptr->active)) {
 		int node_inx = node_ptr - node_record_table_ptr;
 		if (bit_test(node_feature->node_bitmap, node_inx))
 		    return true;
@@ -2841,12 +2864,12 @@ static void _slurm_rpc_node_registration(slurm_msg_t *msg)
 		if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 			unlock_slurmctld(job_write_lock);
 		END_TIMER2("_slurm_rpc_node_registration");
+		_record_node_reg_stats(DELTA_TIMER);
 		if (newly_up) {
 			queue_job_scheduler();
 		}
 	}
 
-	/* return result */
 	if (error_code) {
 		error("_slurm_rpc_node_registration node=%s: %s",
 		      node_reg_stat_msg->node_name,
@@ -2856,40 +2879,54 @@ static void _slurm_rpc_node_registration(slurm_msg_t *msg)
 		 * consider it to be invalid to avoid having slurmd try to
 		 * register again continuously.
 		 */
-		slurm_send_rc_msg(msg, SLURM_SUCCESS);
+		node_reg_stat_msg->flags &= ~SLURMD_REG_FLAG_RESP;
 	} else {
 		debug2("_slurm_rpc_node_registration complete for %s %s",
 		       node_reg_stat_msg->node_name, TIME_STR);
-		/* If the slurmd is requesting a response send it */
-		if (node_reg_stat_msg->flags & SLURMD_REG_FLAG_RESP) {
-			slurm_node_reg_resp_msg_t *resp = NULL, tmp_resp;
-			if (msg->msg_index && msg->ret_list) {
-				/*
-				 * If this is the case then the resp must be
-				 * xmalloced and will be freed when dealt with
-				 * later.
-				 */
-				resp = xmalloc(
-					sizeof(slurm_node_reg_resp_msg_t));
-			} else {
-				memset(&tmp_resp, 0, sizeof(tmp_resp));
-				resp = &tmp_resp;
-			}
+	}
 
-			/*
-			 * Don't add the assoc_mgr_tres_list here as it could
-			 * get freed later if you do.  The pack functions grab
-			 * it for us if it isn't here.
-			 */
-			//resp->tres_list = assoc_mgr_tres_list;
+	/*
+	 * When queued, the response is sent by the rpc_queue once the batch
+	 * of registrations has been validated and the locks released.
+	 */
+	if (!(msg->flags & CTLD_QUEUE_PROCESSING))
+		_slurm_rpc_node_registration_resp(msg);
+}
 
-			if (node_reg_stat_msg->dynamic)
-				resp->node_name = node_reg_stat_msg->node_name;
+/* Return result of _slurm_rpc_node_registration, no locks needed */
+static void _slurm_rpc_node_registration_resp(slurm_msg_t *msg)
+{
+	slurm_node_registration_status_msg_t *node_reg_stat_msg =
+		(slurm_node_registration_status_msg_t *) msg->data;
+	slurm_node_reg_resp_msg_t *resp = NULL, tmp_resp;
 
-			slurm_send_msg(msg, RESPONSE_NODE_REGISTRATION, resp);
-		} else
-			slurm_send_rc_msg(msg, SLURM_SUCCESS);
+	/* If the slurmd is requesting a response send it */
+	if (!(node_reg_stat_msg->flags & SLURMD_REG_FLAG_RESP)) {
+		slurm_send_rc_msg(msg, SLURM_SUCCESS);
+		return;
+	}
+
+	if (msg->msg_index && msg->ret_list) {
+		/*
+		 * If this is the case then the resp must be xmalloced and
+		 * will be freed when dealt with later.
+		 */
+		resp = xmalloc(sizeof(slurm_node_reg_resp_msg_t));
+	} else {
+		memset(&tmp_resp, 0, sizeof(tmp_resp));
+		resp = &tmp_resp;
 	}
+
+	/*
+	 * Don't add the assoc_mgr_tres_list here as it could get freed later
+	 * if you do.  The pack functions grab it for us if it isn't here.
+	 */
+	//resp->tres_list = assoc_mgr_tres_list;
+
+	if (node_reg_stat_msg->dynamic)
+		resp->node_name = node_reg_stat_msg->node_name;
+
+	slurm_send_msg(msg, RESPONSE_NODE_REGISTRATION, resp);
 }
 
 /* _slurm_rpc_job_alloc_info - process RPC to get details on existing job */
@@ -5417,6 +5454,7 @@ static void _clear_rpc_stats(void)
 	memset(rpc_type_cnt, 0, sizeof(rpc_type_cnt));
 	memset(rpc_type_id, 0, sizeof(rpc_type_id));
 	memset(rpc_type_time, 0, sizeof(rpc_type_time));
+	memset(rpc_type_auth_time, 0, sizeof(rpc_type_auth_time));
 	memset(rpc_user_cnt, 0, sizeof(rpc_user_cnt));
 	memset(rpc_user_id, 0, sizeof(rpc_user_id));
 	memset(rpc_user_time, 0, sizeof(rpc_user_time));
@@ -5433,7 +5471,28 @@ static void _pack_rpc_stats(int resp, char **buffer_ptr, int *buffer_size,
 	buffer = create_buf(*buffer_ptr, *buffer_size);
 	set_buf_offset(buffer, *buffer_size);
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		for (i = 0; i < RPC_TYPE_SIZE; i++) {
+			if (rpc_type_id[i] == 0)
+				break;
+		}
+		pack32(i, buffer);
+		pack16_array(rpc_type_id,   i, buffer);
+		pack32_array(rpc_type_cnt,  i, buffer);
+		pack64_array(rpc_type_time, i, buffer);
+		pack64_array(rpc_type_auth_time, i, buffer);
+
+		for (i = 1; i < RPC_USER_SIZE; i++) {
+			if (rpc_user_id[i] == 0)
+				break;
+		}
+		pack32(i, buffer);
+		pack32_array(rpc_user_id,   i, buffer);
+		pack32_array(rpc_user_cnt,  i, buffer);
+		pack64_array(rpc_user_time, i, buffer);
+
+		agent_pack_pending_rpc_stats(buffer);
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		for (i = 0; i < RPC_TYPE_SIZE; i++) {
 			if (rpc_type_id[i] == 0)
 				break;
@@ -6298,6 +6357,7 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = MESSAGE_NODE_REGISTRATION_STATUS,
 		.func = _slurm_rpc_node_registration,
+		.post_func = _slurm_rpc_node_registration_resp,
 		.queue_enabled = true,
 		.locks = {
 			.conf = READ_LOCK,
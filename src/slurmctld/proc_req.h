@@ -48,6 +48,11 @@
 typedef struct {
 	uint16_t msg_type;
 	void (*func)(slurm_msg_t *msg);
+	/*
+	 * Optional. When queued, called after the locks are released for
+	 * the part of the RPC that doesn't need them (e.g. the response).
+	 */
+	void (*post_func)(slurm_msg_t *msg);
 	slurmctld_lock_t locks;
 
 	/* Queue structual elements */
@@ -76,6 +81,11 @@ void slurmctld_req(slurm_msg_t *msg);
  */
 extern void record_rpc_stats(slurm_msg_t *msg, long delta);
 
+/*
+ * Clear the node registration counters in the slurmctld stats structure.
+ */
+extern void reset_node_reg_stats(void);
+
 /*
  * Initialize a response slurm_msg_t to an inbound msg,
  * first by calling slurm_msg_t_init(), then by copying
@@ -69,6 +69,7 @@
 #include "src/common/slurm_route.h"
 #include "src/common/strnatcmp.h"
 #include "src/common/switch.h"
+#include "src/common/xhash.h"
 #include "src/common/xstring.h"
 #include "src/common/cgroup.h"
 
@@ -94,9 +95,12 @@
 
 #define FEATURE_MAGIC	0x34dfd8b5
 
+static xhash_t *feature_dict = NULL;	/* feature_dict_t by feature name */
+
 /* Global variables */
 List active_feature_list;	/* list of currently active features_records */
 List avail_feature_list;	/* list of available features_records */
+uint32_t feature_dict_gen = 0;	/* changes when feature_dict entries do */
 bool node_features_updated = true;
 bool slurmctld_init_db = true;
 
@@ -1497,6 +1501,72 @@ end_it:
 
 }
 
+static void _feature_dict_id(void *item, const char **key, uint32_t *key_len)
+{
+	feature_dict_t *dict_ptr = item;
+
+	*key = dict_ptr->name;
+	*key_len = strlen(dict_ptr->name);
+}
+
+static void _feature_dict_free(void *item)
+{
+	feature_dict_t *dict_ptr = item;
+
+	xfree(dict_ptr->name);
+	xfree(dict_ptr);
+}
+
+/* Empty the feature dictionary, its entries point into the old lists */
+static void _feature_dict_reset(void)
+{
+	xhash_clear(feature_dict);
+	feature_dict_gen++;
+}
+
+/*
+ * Return the feature_list record for a feature name, NULL if none
+ * feature_list IN - either active_feature_list or avail_feature_list
+ */
+static node_feature_t *_find_config_feature(List feature_list, char *feature)
+{
+	feature_dict_t *dict_ptr = find_feature_dict(feature);
+
+	if (!dict_ptr)
+		return NULL;
+	if (feature_list == active_feature_list)
+		return dict_ptr->active;
+	return dict_ptr->avail;
+}
+
+/* Create a feature_list record and enter it in the feature dictionary */
+static node_feature_t *_new_config_feature(List feature_list, char *feature)
+{
+	node_feature_t *feature_ptr;
+	feature_dict_t *dict_ptr;
+
+	feature_ptr = xmalloc(sizeof(node_feature_t));
+	feature_ptr->magic = FEATURE_MAGIC;
+	feature_ptr->name = xstrdup(feature);
+	list_append(feature_list, feature_ptr);
+
+	if (!feature_dict)
+		feature_dict = xhash_init(_feature_dict_id, _feature_dict_free);
+	if (!(dict_ptr = find_feature_dict(feature))) {
+		dict_ptr = xmalloc(sizeof(feature_dict_t));
+		dict_ptr->name = xstrdup(feature);
+		xhash_add(feature_dict, dict_ptr);
+	}
+	if (feature_list == active_feature_list)
+		dict_ptr->active = feature_ptr;
+	else
+		dict_ptr->avail = feature_ptr;
+	/* Job features resolved before may have found no record */
+	feature_dict_gen++;
+
+	return feature_ptr;
+}
+
 /* Add feature to list
  * feature_list IN - destination list, either active_feature_list or
  *	avail_feature_list
@@ -1506,26 +1576,13 @@ static void _add_config_feature(List feature_list, char *feature,
 				bitstr_t *node_bitmap)
 {
 	node_feature_t *feature_ptr;
-	ListIterator feature_iter;
-	bool match = false;
 
 	/* If feature already in avail_feature_list, just update the bitmap */
-	feature_iter = list_iterator_create(feature_list);
-	while ((feature_ptr = list_next(feature_iter))) {
-		if (xstrcmp(feature, feature_ptr->name))
-			continue;
+	if ((feature_ptr = _find_config_feature(feature_list, feature))) {
 		bit_or(feature_ptr->node_bitmap, node_bitmap);
-		match = true;
-		break;
-	}
-	list_iterator_destroy(feature_iter);
-
-	if (!match) {	/* Need to create new avail_feature_list record */
-		feature_ptr = xmalloc(sizeof(node_feature_t));
-		feature_ptr->magic = FEATURE_MAGIC;
-		feature_ptr->name = xstrdup(feature);
+	} else {	/* Need to create new avail_feature_list record */
+		feature_ptr = _new_config_feature(feature_list, feature);
 		feature_ptr->node_bitmap = bit_copy(node_bitmap);
-		list_append(feature_list, feature_ptr);
 	}
 }
 
@@ -1538,28 +1595,14 @@ static void _add_config_feature_inx(List feature_list, char *feature,
 				    int node_inx)
 {
 	node_feature_t *feature_ptr;
-	ListIterator feature_iter;
-	bool match = false;
 
 	/* If feature already in avail_feature_list, just update the bitmap */
-	feature_iter = list_iterator_create(feature_list);
-	while ((feature_ptr = list_next(feature_iter))) {
-		if (xstrcmp(feature, feature_ptr->name))
-			continue;
-		bit_set(feature_ptr->node_bitmap, node_inx);
-		match = true;
-		break;
-	}
-	list_iterator_destroy(feature_iter);
-
-	if (!match) {	/* Need to create new avail_feature_list record */
-		feature_ptr = xmalloc(sizeof(node_feature_t));
-		feature_ptr->magic = FEATURE_MAGIC;
-		feature_ptr->name = xstrdup(feature);
+	if (!(feature_ptr = _find_config_feature(feature_list, feature))) {
+		/* Need to create new avail_feature_list record */
+		feature_ptr = _new_config_feature(feature_list, feature);
 		feature_ptr->node_bitmap = bit_alloc(node_record_count);
-		bit_set(feature_ptr->node_bitmap, node_inx);
-		list_append(feature_list, feature_ptr);
 	}
+	bit_set(feature_ptr->node_bitmap, node_inx);
 }
 
 /* _list_delete_feature - delete an entry from the feature list,
@@ -1587,6 +1630,7 @@ extern void build_feature_list_eq(void)
 	ListIterator feature_iter;
 	char *tmp_str, *token, *last = NULL;
 
+	_feature_dict_reset();
 	FREE_NULL_LIST(active_feature_list);
 	FREE_NULL_LIST(avail_feature_list);
 	active_feature_list = list_create(_list_delete_feature);
@@ -1610,12 +1654,10 @@ extern void build_feature_list_eq(void)
 	/* Copy avail_feature_list to active_feature_list */
 	feature_iter = list_iterator_create(avail_feature_list);
 	while ((avail_feature_ptr = list_next(feature_iter))) {
-		active_feature_ptr = xmalloc(sizeof(node_feature_t));
-		active_feature_ptr->magic = FEATURE_MAGIC;
-		active_feature_ptr->name = xstrdup(avail_feature_ptr->name);
+		active_feature_ptr = _new_config_feature(
+			active_feature_list, avail_feature_ptr->name);
 		active_feature_ptr->node_bitmap =
 			bit_copy(avail_feature_ptr->node_bitmap);
-		list_append(active_feature_list, active_feature_ptr);
 	}
 	list_iterator_destroy(feature_iter);
 }
@@ -1656,6 +1698,7 @@ extern void build_feature_list_ne(void)
 	char *tmp_str, *token, *last = NULL;
 	int i;
 
+	_feature_dict_reset();
 	FREE_NULL_LIST(active_feature_list);
 	FREE_NULL_LIST(avail_feature_list);
 	active_feature_list = list_create(_list_delete_feature);
@@ -1691,6 +1734,24 @@ extern void build_feature_list_ne(void)
 	}
 }
 
+/*
+ * Return the feature dictionary entry for a feature name, NULL if neither
+ *	active_feature_list nor avail_feature_list has it
+ */
+extern feature_dict_t *find_feature_dict(const char *name)
+{
+	if (!feature_dict || !name)
+		return NULL;
+	return xhash_get_str(feature_dict, name);
+}
+
+/* Free the feature dictionary, along with the feature lists */
+extern void feature_dict_fini(void)
+{
+	xhash_free(feature_dict);
+	feature_dict_gen++;
+}
+
 /*
  * Update active_feature_list or avail_feature_list
  * feature_list IN - List to update: active_feature_list or avail_feature_list
@@ -86,6 +86,9 @@ extern void build_feature_list_eq(void);
  * build new active and available feature lists */
 extern void build_feature_list_ne(void);
 
+/* Free the feature dictionary, along with the feature lists */
+extern void feature_dict_fini(void);
+
 /* Update active_feature_list or avail_feature_list
  * feature_list IN - List to update: active_feature_list or avail_feature_list
  * new_features IN - New active_features
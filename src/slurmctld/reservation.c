@@ -123,6 +123,28 @@ List      resv_list = (List) NULL;
 static List magnetic_resv_list = NULL;
 uint32_t  top_suffix = 0;
 
+/*
+ * Index of resv_list by start time, so that testing a job against the
+ * reservations only visits the ones which may overlap it. Floating
+ * reservations, whose start time is relative to the current time, sort
+ * first and are always visited. Rebuilt on first use after a change.
+ */
+typedef struct {
+	slurmctld_resv_t *resv_ptr;
+	time_t start_time;	/* earliest start, 0 if floating */
+	int list_pos;		/* position in resv_list */
+} resv_index_t;
+
+/*
+ * Job tests may run concurrently under the node read lock (e.g. sched/builtin
+ * and burst buffer stage in), so the lazy rebuild is serialized here.
+ */
+static pthread_mutex_t resv_index_mutex = PTHREAD_MUTEX_INITIALIZER;
+static resv_index_t *resv_index = NULL;	/* sorted by start_time */
+static int resv_index_cnt = -1;		/* -1 if index must be rebuilt */
+static int resv_index_size = 0;		/* allocated entries */
+static uint32_t resv_index_boot_time = 0;	/* largest boot_time */
+
 /*
  * the two following structs enable to build a
  * planning of a constraint evolution over time
@@ -202,6 +224,8 @@ static int  _post_resv_update(slurmctld_resv_t *resv_ptr,
 static int  _resize_resv(slurmctld_resv_t *resv_ptr, uint32_t node_cnt);
 static void _restore_resv(slurmctld_resv_t *dest_resv,
 			  slurmctld_resv_t *src_resv);
+static void _resv_index_clear(void);
+static slurmctld_resv_t **_resv_index_find(time_t end_time, int *cnt);
 static bool _resv_overlap(resv_desc_msg_t *resv_desc_ptr,
 			  bitstr_t *node_bitmap,
 			  slurmctld_resv_t *this_resv_ptr);
@@ -231,12 +255,16 @@ static bool _validate_user_access(slurmctld_resv_t *resv_ptr,
 
 static void _set_boot_time(slurmctld_resv_t *resv_ptr)
 {
-	resv_ptr->boot_time = 0;
-	if (!resv_ptr->node_bitmap)
-		return;
+	uint32_t old_boot_time = resv_ptr->boot_time;
 
-	if (node_features_g_overlap(resv_ptr->node_bitmap))
+	resv_ptr->boot_time = 0;
+	if (resv_ptr->node_bitmap &&
+	    node_features_g_overlap(resv_ptr->node_bitmap))
 		resv_ptr->boot_time = node_features_g_boot_time();
+
+	/* The index looks that much further ahead for every reservation */
+	if (resv_ptr->boot_time > old_boot_time)
+		_resv_index_clear();
 }
 
 /* Advance res_time by the specified day count,
@@ -470,6 +498,7 @@ static void _del_resv_rec(void *x)
 	slurmctld_resv_t *resv_ptr = (slurmctld_resv_t *) x;
 
 	if (resv_ptr) {
+		_resv_index_clear();
 		/*
 		 * If shutting down magnetic_resv_list is already freed, meaning
 		 * we don't need to remove anything from it.
@@ -527,6 +556,114 @@ static void _add_resv_to_lists(slurmctld_resv_t *resv_ptr)
 	list_append(resv_list, resv_ptr);
 	if (resv_ptr->flags & RESERVE_FLAG_MAGNETIC)
 		list_append(magnetic_resv_list, resv_ptr);
+	_resv_index_clear();
+}
+
+/*
+ * Invalidate the start time index of resv_list. Call whenever a reservation
+ * is added or removed, its start time or flags may move earlier, or its boot
+ * time grows.
+ */
+static void _resv_index_clear(void)
+{
+	slurm_mutex_lock(&resv_index_mutex);
+	resv_index_cnt = -1;
+	slurm_mutex_unlock(&resv_index_mutex);
+}
+
+static int _resv_index_sort_start(const void *x, const void *y)
+{
+	const resv_index_t *a = x, *b = y;
+
+	if (a->start_time != b->start_time)
+		return (a->start_time < b->start_time) ? -1 : 1;
+	return a->list_pos - b->list_pos;
+}
+
+static int _resv_index_sort_pos(const void *x, const void *y)
+{
+	const resv_index_t *a = x, *b = y;
+
+	return a->list_pos - b->list_pos;
+}
+
+static void _resv_index_build(void)
+{
+	slurmctld_resv_t *resv_ptr;
+	ListIterator iter;
+	int cnt = list_count(resv_list);
+
+	if (cnt > resv_index_size) {
+		resv_index_size = cnt;
+		xrecalloc(resv_index, cnt, sizeof(resv_index_t));
+	}
+
+	resv_index_cnt = 0;
+	resv_index_boot_time = 0;
+	iter = list_iterator_create(resv_list);
+	while ((resv_ptr = list_next(iter))) {
+		resv_index_t *entry = &resv_index[resv_index_cnt];
+
+		entry->resv_ptr = resv_ptr;
+		entry->list_pos = resv_index_cnt++;
+		if (resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT)
+			entry->start_time = 0;
+		else
+			entry->start_time = MIN(resv_ptr->start_time,
+						resv_ptr->start_time_first);
+		resv_index_boot_time = MAX(resv_index_boot_time,
+					   resv_ptr->boot_time);
+	}
+	list_iterator_destroy(iter);
+
+	qsort(resv_index, resv_index_cnt, sizeof(resv_index_t),
+	      _resv_index_sort_start);
+}
+
+/*
+ * Find the reservations which may overlap a job ending at end_time, that is
+ * those starting before it (plus their boot time). Reservations only move
+ * later once indexed, so the result may include extra reservations which the
+ * caller must still test, but never misses one.
+ * IN end_time - end time of the job
+ * OUT cnt - number of reservations found
+ * RET reservations found, in resv_list order, free using xfree(). Valid while
+ *     the caller holds the node read lock.
+ */
+static slurmctld_resv_t **_resv_index_find(time_t end_time, int *cnt)
+{
+	resv_index_t *hits;
+	slurmctld_resv_t **found;
+	int lo = 0, hi, mid;
+
+	slurm_mutex_lock(&resv_index_mutex);
+	if (resv_index_cnt < 0)
+		_resv_index_build();
+
+	/* First entry starting at or after end_time */
+	end_time += resv_index_boot_time;
+	hi = resv_index_cnt;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (resv_index[mid].start_time < end_time)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	hits = xcalloc(lo + 1, sizeof(resv_index_t));
+	memcpy(hits, resv_index, lo * sizeof(resv_index_t));
+	slurm_mutex_unlock(&resv_index_mutex);
+
+	/* Visit in list order, as the tests may stop at the first match */
+	qsort(hits, lo, sizeof(resv_index_t), _resv_index_sort_pos);
+	found = xcalloc(lo + 1, sizeof(slurmctld_resv_t *));
+	for (mid = 0; mid < lo; mid++)
+		found[mid] = hits[mid].resv_ptr;
+	xfree(hits);
+
+	*cnt = lo;
+	return found;
 }
 
 static int _queue_magnetic_resv(void *x, void *key)
@@ -2873,6 +3010,11 @@ extern void resv_fini(void)
 {
 	FREE_NULL_LIST(magnetic_resv_list);
 	FREE_NULL_LIST(resv_list);
+	slurm_mutex_lock(&resv_index_mutex);
+	xfree(resv_index);
+	resv_index_size = 0;
+	resv_index_cnt = -1;
+	slurm_mutex_unlock(&resv_index_mutex);
 }
 
 /* Update an exiting resource reservation */
@@ -5576,13 +5718,15 @@ extern void job_claim_resv(job_record_t *job_ptr)
  */
 extern void job_time_adj_resv(job_record_t *job_ptr)
 {
-	ListIterator iter;
+	slurmctld_resv_t **found;
+	int f, found_cnt;
 	slurmctld_resv_t * resv_ptr;
 	time_t now = time(NULL);
 	int32_t resv_begin_time;
 
-	iter = list_iterator_create(resv_list);
-	while ((resv_ptr = list_next(iter))) {
+	found = _resv_index_find(job_ptr->end_time, &found_cnt);
+	for (f = 0; f < found_cnt; f++) {
+		resv_ptr = found[f];
 		if (resv_ptr->end_time <= now)
 			(void)_advance_resv_time(resv_ptr);
 		if (job_ptr->resv_ptr == resv_ptr)
@@ -5600,7 +5744,7 @@ extern void job_time_adj_resv(job_record_t *job_ptr)
 		resv_begin_time = difftime(resv_ptr->start_time, now) / 60;
 		job_ptr->time_limit = MIN(job_ptr->time_limit,resv_begin_time);
 	}
-	list_iterator_destroy(iter);
+	xfree(found);
 	job_ptr->time_limit = MAX(job_ptr->time_limit, job_ptr->time_min);
 	job_end_time_reset(job_ptr);
 }
@@ -5778,7 +5922,8 @@ extern burst_buffer_info_msg_t *job_test_bb_resv(job_record_t *job_ptr,
 	time_t job_start_time, job_end_time, now = time(NULL);
 	time_t job_end_time_use;
 	burst_buffer_info_msg_t *bb_resv = NULL;
-	ListIterator iter;
+	slurmctld_resv_t **found;
+	int f, found_cnt;
 
 	if ((job_ptr->burst_buffer == NULL) ||
 	    (job_ptr->burst_buffer[0] == '\0'))
@@ -5786,8 +5931,9 @@ extern burst_buffer_info_msg_t *job_test_bb_resv(job_record_t *job_ptr,
 
 	job_start_time = when;
 	job_end_time   = when + _get_job_duration(job_ptr, reboot);
-	iter = list_iterator_create(resv_list);
-	while ((resv_ptr = list_next(iter))) {
+	found = _resv_index_find(job_end_time, &found_cnt);
+	for (f = 0; f < found_cnt; f++) {
+		resv_ptr = found[f];
 		if (resv_ptr->end_time <= now)
 			(void)_advance_resv_time(resv_ptr);
 
@@ -5808,7 +5954,7 @@ extern burst_buffer_info_msg_t *job_test_bb_resv(job_record_t *job_ptr,
 
 		_update_bb_resv(&bb_resv, resv_ptr->burst_buffer);
 	}
-	list_iterator_destroy(iter);
+	xfree(found);
 
 	return bb_resv;
 }
@@ -5829,13 +5975,15 @@ extern int job_test_lic_resv(job_record_t *job_ptr, char *lic_name,
 	slurmctld_resv_t * resv_ptr;
 	time_t job_start_time, job_end_time, now = time(NULL);
 	time_t job_end_time_use;
-	ListIterator iter;
+	slurmctld_resv_t **found;
+	int f, found_cnt;
 	int resv_cnt = 0;
 
 	job_start_time = when;
 	job_end_time   = when + _get_job_duration(job_ptr, reboot);
-	iter = list_iterator_create(resv_list);
-	while ((resv_ptr = list_next(iter))) {
+	found = _resv_index_find(job_end_time, &found_cnt);
+	for (f = 0; f < found_cnt; f++) {
+		resv_ptr = found[f];
 		if (resv_ptr->end_time <= now)
 			(void)_advance_resv_time(resv_ptr);
 
@@ -5855,7 +6003,7 @@ extern int job_test_lic_resv(job_record_t *job_ptr, char *lic_name,
 
 		resv_cnt += _license_cnt(resv_ptr->license_list, lic_name);
 	}
-	list_iterator_destroy(iter);
+	xfree(found);
 
 	/* info("%pJ blocked from %d licenses of type %s",
 	     job_ptr, resv_cnt, lic_name); */
@@ -6064,7 +6212,8 @@ extern uint32_t job_test_watts_resv(job_record_t *job_ptr, time_t when,
 	slurmctld_resv_t * resv_ptr;
 	time_t job_start_time, job_end_time, now = time(NULL);
 	time_t job_end_time_use;
-	ListIterator iter;
+	slurmctld_resv_t **found;
+	int f, found_cnt;
 	constraint_planning_t wsched;
 	time_t start, end;
 	char start_str[32] = "-1", end_str[32] = "-1";
@@ -6074,8 +6223,9 @@ extern uint32_t job_test_watts_resv(job_record_t *job_ptr, time_t when,
 
 	job_start_time = when;
 	job_end_time   = when + _get_job_duration(job_ptr, reboot);
-	iter = list_iterator_create(resv_list);
-	while ((resv_ptr = list_next(iter))) {
+	found = _resv_index_find(job_end_time, &found_cnt);
+	for (f = 0; f < found_cnt; f++) {
+		resv_ptr = found[f];
 		if (resv_ptr->end_time <= now)
 			(void)_advance_resv_time(resv_ptr);
 		if (resv_ptr->resv_watts == NO_VAL ||
@@ -6100,7 +6250,7 @@ extern uint32_t job_test_watts_resv(job_record_t *job_ptr, time_t when,
 					    resv_ptr->start_time,
 					    resv_ptr->end_time);
 	}
-	list_iterator_destroy(iter);
+	xfree(found);
 
 	resv_cnt = _max_constraint_planning(&wsched, &start, &end);
 	if (slurm_conf.debug_flags & DEBUG_FLAG_RESERVATION) {
@@ -6147,7 +6297,8 @@ extern int job_test_resv(job_record_t *job_ptr, time_t *when,
 	time_t job_start_time, job_end_time, job_end_time_use, lic_resv_time;
 	time_t start_relative, end_relative;
 	time_t now = time(NULL);
-	ListIterator iter;
+	slurmctld_resv_t **found;
+	int f, found_cnt;
 	int i, rc = SLURM_SUCCESS, rc2;
 
 	*resv_overlap = false;	/* initialize to false */
@@ -6233,8 +6384,9 @@ extern int job_test_resv(job_record_t *job_ptr, time_t *when,
 		 * if there are any overlapping reservations, we need to
 		 * prevent the job from using those nodes (e.g. MAINT nodes)
 		 */
-		iter = list_iterator_create(resv_list);
-		while ((res2_ptr = list_next(iter))) {
+		found = _resv_index_find(job_end_time, &found_cnt);
+		for (f = 0; f < found_cnt; f++) {
+			res2_ptr = found[f];
 			if (reboot)
 				job_end_time_use =
 					job_end_time + res2_ptr->boot_time;
@@ -6264,7 +6416,7 @@ extern int job_test_resv(job_record_t *job_ptr, time_t *when,
 				bit_and_not(*node_bitmap,res2_ptr->node_bitmap);
 			}
 		}
-		list_iterator_destroy(iter);
+		xfree(found);
 
 		if (slurm_conf.debug_flags & DEBUG_FLAG_RESERVATION) {
 			char *nodes = bitmap2node_name(*node_bitmap);
@@ -6299,8 +6451,9 @@ extern int job_test_resv(job_record_t *job_ptr, time_t *when,
 	for (i = 0; ; i++) {
 		lic_resv_time = (time_t) 0;
 
-		iter = list_iterator_create(resv_list);
-		while ((resv_ptr = list_next(iter))) {
+		found = _resv_index_find(job_end_time, &found_cnt);
+		for (f = 0; f < found_cnt; f++) {
+			resv_ptr = found[f];
 			_get_rel_start_end(
 				resv_ptr, now, &start_relative, &end_relative);
 
@@ -6389,7 +6542,7 @@ extern int job_test_resv(job_record_t *job_ptr, time_t *when,
 				continue;
 			}
 		}
-		list_iterator_destroy(iter);
+		xfree(found);
 
 		if ((rc == SLURM_SUCCESS) && move_time) {
 			if (license_job_test(job_ptr, job_start_time, reboot)
@@ -56,11 +56,42 @@
 
 bool enabled = true;
 
+/*
+ * Upper bound on processed messages held back for post_func() while the
+ * slurmctld locks are held. Keeps responses flowing during long bursts.
+ */
+#define RPC_QUEUE_MAX_DEFERRED 256
+
+static void _free_msg(slurm_msg_t *msg)
+{
+	if ((msg->conn_fd >= 0) && (close(msg->conn_fd) < 0))
+		error("close(%d): %m", msg->conn_fd);
+	slurm_free_msg(msg);
+}
+
+/*
+ * Run the post_func() for every deferred message.
+ * Must be called without the slurmctld locks held.
+ */
+static void _run_post_func(slurmctld_rpc_t *q, List deferred)
+{
+	slurm_msg_t *msg;
+
+	while ((msg = list_dequeue(deferred))) {
+		q->post_func(msg);
+		_free_msg(msg);
+	}
+}
+
 static void *_rpc_queue_worker(void *arg)
 {
 	slurmctld_rpc_t *q = (slurmctld_rpc_t *) arg;
 	slurm_msg_t *msg;
 	int processed = 0;
+	List deferred = NULL;
+
+	if (q->post_func)
+		deferred = list_create(NULL);
 
 #if HAVE_SYS_PRCTL_H
 	char *name = xstrdup_printf("rpcq-%u", q->msg_type);
@@ -85,6 +116,8 @@ static void *_rpc_queue_worker(void *arg)
 
 		if (!msg) {
 			unlock_slurmctld(q->locks);
+			if (deferred)
+				_run_post_func(q, deferred);
 
 			log_flag(PROTOCOL, "%s(%s): sleeping after processing %d",
 				 __func__, q->msg_name, processed);
@@ -110,6 +143,7 @@ static void *_rpc_queue_worker(void *arg)
 				log_flag(PROTOCOL, "%s(%s): shutting down",
 					 __func__, q->msg_name);
 				slurm_mutex_unlock(&q->mutex);
+				FREE_NULL_LIST(deferred);
 				return NULL;
 			}
 
@@ -131,13 +165,27 @@ static void *_rpc_queue_worker(void *arg)
 
 			msg->flags |= CTLD_QUEUE_PROCESSING;
 			q->func(msg);
-			if ((msg->conn_fd >= 0) && (close(msg->conn_fd) < 0))
-				error("close(%d): %m", msg->conn_fd);
 
 			END_TIMER;
 			record_rpc_stats(msg, DELTA_TIMER);
-			slurm_free_msg(msg);
 			processed++;
+
+			if (!deferred) {
+				_free_msg(msg);
+				continue;
+			}
+
+			/*
+			 * Hold back the remaining work on this message until
+			 * the locks are released, but don't let a long burst
+			 * starve the senders of their responses.
+			 */
+			list_enqueue(deferred, msg);
+			if (list_count(deferred) >= RPC_QUEUE_MAX_DEFERRED) {
+				unlock_slurmctld(q->locks);
+				_run_post_func(q, deferred);
+				lock_slurmctld(q->locks);
+			}
 		}
 	}
 
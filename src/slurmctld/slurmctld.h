@@ -194,6 +194,14 @@ typedef struct diag_stats {
 	time_t   bf_when_last_cycle;
 
 	uint32_t latency;
+
+	uint32_t node_reg_cnt;
+	uint32_t node_reg_time_max;
+	uint64_t node_reg_time_sum;
+
+	uint64_t acct_policy_cnt;
+	uint32_t acct_policy_time_max;
+	uint64_t acct_policy_time_sum;
 } diag_stats_t;
 
 typedef struct {
@@ -257,6 +265,26 @@ typedef struct node_features {
 extern List active_feature_list;/* list of currently active node features */
 extern List avail_feature_list;	/* list of available node features */
 
+/*
+ * Feature dictionary, with one entry per feature name pointing to its records
+ * in active_feature_list and avail_feature_list. Entries are only valid
+ * while feature_dict_gen is unchanged; it changes when the feature lists are
+ * rebuilt or a feature gains a record.
+ */
+typedef struct {
+	char *name;			/* name of the feature */
+	node_feature_t *active;		/* record in active_feature_list */
+	node_feature_t *avail;		/* record in avail_feature_list */
+} feature_dict_t;
+
+extern uint32_t feature_dict_gen;
+
+/*
+ * Return the feature dictionary entry for a feature name, NULL if neither
+ *	active_feature_list nor avail_feature_list has it
+ */
+extern feature_dict_t *find_feature_dict(const char *name);
+
 /*****************************************************************************\
  *  NODE states and bitmaps
  *
@@ -509,6 +537,8 @@ typedef struct job_feature {
 	bitstr_t *node_bitmap_active;	/* nodes with this feature active */
 	bitstr_t *node_bitmap_avail;	/* nodes with this feature available */
 	uint16_t paren;			/* count of enclosing parenthesis */
+	feature_dict_t *dict_ptr;	/* feature dictionary entry, if any */
+	uint32_t dict_gen;		/* feature_dict_gen dict_ptr is from */
 } job_feature_t;
 
 /*
@@ -773,6 +803,11 @@ struct job_record {
 					    * a limit instead of from
 					    * the request, or if the
 					    * limit was set from admin */
+	uint64_t limit_gen;		/* usage generation of the job's
+					 * associations and QOS when it was
+					 * last held by a pre_select limit,
+					 * 0 if not */
+	part_record_t *limit_part_ptr;	/* partition limit_gen is for */
 	uint16_t mail_type;		/* see MAIL_JOB_* in slurm.h */
 	char *mail_user;		/* user to get e-mail notification */
 	char *mem_per_tres;		/* semicolon delimited list of TRES=# values */
@@ -814,6 +849,9 @@ struct job_record {
 	bool preempt_in_progress;	/* Premption of other jobs in progress
 					 * in order to start this job,
 					 * (Internal use only, don't save) */
+	bool preempt_indexed;		/* in the index of started jobs
+					 * searched for preemption candidates
+					 * (Internal use only, don't save) */
 	uint32_t prep_epilog_cnt;	/* count of epilog async tasks left */
 	uint32_t prep_prolog_cnt;	/* count of prolog async tasks left */
 	bool prep_prolog_failed;	/* any prolog_slurmctld failed */
@@ -840,7 +878,15 @@ struct job_record {
 	struct slurmctld_resv *resv_ptr;/* reservation structure pointer */
 	uint32_t requid;	    	/* requester user ID */
 	char *resp_host;		/* host for srun communications */
+	uint32_t sched_cost_epoch;	/* statistics reset sched_tests and
+					 * sched_usec are counted since
+					 * (Internal use only, don't save) */
 	char *sched_nodes;		/* list of nodes scheduled for job */
+	uint32_t sched_tests;		/* times tested for scheduling
+					 * (Internal use only, don't save) */
+	uint64_t sched_usec;		/* time spent testing it for
+					 * scheduling, in microseconds
+					 * (Internal use only, don't save) */
 	dynamic_plugin_data_t *select_jobinfo;/* opaque data, BlueGene */
 	char *selinux_context;		/* SELinux context */
 	uint32_t site_factor;		/* factor to consider in priority */
@@ -2232,6 +2278,30 @@ extern void reset_node_free_mem(char *node_name, uint64_t free_mem);
  * level IN - clear backfilled_jobs count if set */
 extern void reset_stats(int level);
 
+/*
+ * Charge the time since start, spent by func testing a job for scheduling,
+ * to that job. sdiag reports the pending jobs with the largest totals.
+ * IN job_ptr - job tested
+ * IN sched_name - scheduler testing the job, "main" or "backfill"
+ * IN func - function timed
+ * IN cycle - scheduler cycle count, for the trace file
+ * IN start - when the test started
+ * NOTE: Job write lock must be held
+ */
+extern void sched_cost_add(job_record_t *job_ptr, const char *sched_name,
+			   const char *func, uint32_t cycle,
+			   struct timeval *start);
+
+/*
+ * Drop a job which no longer waits to be scheduled (started, held, ended or
+ * purged) from the costliest pending jobs reported by sdiag.
+ * NOTE: Job write lock must be held
+ */
+extern void sched_cost_remove(job_record_t *job_ptr);
+
+/* Close the scheduling trace file, once the schedulers have stopped */
+extern void sched_cost_fini(void);
+
 /*
  * restore_node_features - Make node and config (from slurm.conf) fields
  *	consistent for Features, Gres and Weight
@@ -40,13 +40,214 @@
 
 #include "src/slurmctld/agent.h"
 #include "src/slurmctld/slurmctld.h"
+#include "src/slurmctld/acct_policy.h"
+#include "src/slurmctld/proc_req.h"
 #include "src/common/list.h"
 #include "src/common/pack.h"
 #include "src/common/xstring.h"
 #include "src/common/slurmdbd_defs.h"
 
+/* Count of the costliest pending jobs reported by sdiag */
+#define SCHED_COST_TOP_CNT 10
+
+/* Schedulers writing to the trace file, see sched_cost_add() */
+#define SCHED_TRACE_MAIN	0
+#define SCHED_TRACE_BACKFILL	1
+#define SCHED_TRACE_CNT		2
+
+typedef struct {
+	uint32_t cnt;
+	uint32_t job_id[SCHED_COST_TOP_CNT];
+	uint32_t tests[SCHED_COST_TOP_CNT];
+	uint64_t usec[SCHED_COST_TOP_CNT];
+} sched_cost_top_t;
+
+static pthread_mutex_t sched_cost_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t sched_cost_epoch = 1;	/* bumped by reset_stats() */
+static sched_cost_top_t sched_cost_top;	/* costliest first */
+static time_t sched_cost_conf_update = 0;
+static char *sched_trace_file = NULL;
+static FILE *sched_trace_fp = NULL;
+static uint32_t sched_trace_cycle[SCHED_TRACE_CNT];
+
 extern int retry_list_size(void);
 
+static void _sched_trace_close(void)
+{
+	if (sched_trace_fp)
+		fclose(sched_trace_fp);
+	sched_trace_fp = NULL;
+	xfree(sched_trace_file);
+}
+
+/* (Re)open the file set by SchedulerParameters=sched_trace_file=<path> */
+static void _sched_trace_config(void)
+{
+	char *tmp_ptr, *path = NULL;
+
+	sched_cost_conf_update = slurm_conf.last_update;
+	if ((tmp_ptr = xstrcasestr(slurm_conf.sched_params,
+				   "sched_trace_file="))) {
+		path = xstrdup(tmp_ptr + 17);
+		if ((tmp_ptr = strchr(path, ',')))
+			tmp_ptr[0] = '\0';
+	}
+	if (!xstrcmp(path, sched_trace_file)) {
+		xfree(path);
+		return;
+	}
+
+	_sched_trace_close();
+	sched_trace_file = path;
+	/* Keep the file out of the scripts slurmctld runs */
+	if (sched_trace_file &&
+	    !(sched_trace_fp = fopen(sched_trace_file, "ae")))
+		error("%s: unable to open %s: %m", __func__, sched_trace_file);
+}
+
+/* Remove the job at index inx of sched_cost_top */
+static void _sched_cost_top_del(int inx)
+{
+	sched_cost_top_t *top = &sched_cost_top;
+
+	top->cnt--;
+	for (int i = inx; i < top->cnt; i++) {
+		top->job_id[i] = top->job_id[i + 1];
+		top->tests[i] = top->tests[i + 1];
+		top->usec[i] = top->usec[i + 1];
+	}
+}
+
+/* Drop the job from sched_cost_top, if listed */
+static void _sched_cost_top_remove(uint32_t job_id)
+{
+	for (int i = 0; i < sched_cost_top.cnt; i++) {
+		if (sched_cost_top.job_id[i] == job_id) {
+			_sched_cost_top_del(i);
+			break;
+		}
+	}
+}
+
+/*
+ * Update the job's place in sched_cost_top. Totals only grow between resets,
+ * so checking each job as it is charged keeps the table exact.
+ */
+static void _sched_cost_top_update(job_record_t *job_ptr)
+{
+	sched_cost_top_t *top = &sched_cost_top;
+	int i;
+
+	_sched_cost_top_remove(job_ptr->job_id);
+
+	/* Started by this test, it no longer waits to be scheduled */
+	if (!IS_JOB_PENDING(job_ptr))
+		return;
+	if ((top->cnt == SCHED_COST_TOP_CNT) &&
+	    (job_ptr->sched_usec <= top->usec[top->cnt - 1]))
+		return;
+
+	/* Insertion sort, costliest first */
+	if (top->cnt < SCHED_COST_TOP_CNT)
+		top->cnt++;
+	for (i = top->cnt - 1;
+	     (i > 0) && (top->usec[i - 1] < job_ptr->sched_usec); i--) {
+		top->job_id[i] = top->job_id[i - 1];
+		top->tests[i] = top->tests[i - 1];
+		top->usec[i] = top->usec[i - 1];
+	}
+	top->job_id[i] = job_ptr->job_id;
+	top->tests[i] = job_ptr->sched_tests;
+	top->usec[i] = job_ptr->sched_usec;
+}
+
+/*
+ * Charge the time spent testing a job for scheduling to that job and append
+ * it to the scheduling trace file, one line per test in the folded stack
+ * format of flame graph tools: "<sched>;cycle=<#>;JobId=<#>;<func> <usec>"
+ * NOTE: Job write lock must be held
+ */
+extern void sched_cost_add(job_record_t *job_ptr, const char *sched_name,
+			   const char *func, uint32_t cycle,
+			   struct timeval *start)
+{
+	struct timeval now;
+	long usec;
+	int sched_inx;
+
+	gettimeofday(&now, NULL);
+	usec = ((now.tv_sec - start->tv_sec) * USEC_IN_SEC) +
+	       (now.tv_usec - start->tv_usec);
+	if (usec < 0)
+		usec = 0;
+
+	slurm_mutex_lock(&sched_cost_mutex);
+	if (job_ptr->sched_cost_epoch != sched_cost_epoch) {
+		job_ptr->sched_cost_epoch = sched_cost_epoch;
+		job_ptr->sched_tests = 0;
+		job_ptr->sched_usec = 0;
+	}
+	job_ptr->sched_tests++;
+	job_ptr->sched_usec += usec;
+	_sched_cost_top_update(job_ptr);
+
+	if (sched_cost_conf_update != slurm_conf.last_update)
+		_sched_trace_config();
+	if (sched_trace_fp) {
+		if (!xstrcmp(sched_name, "backfill"))
+			sched_inx = SCHED_TRACE_BACKFILL;
+		else
+			sched_inx = SCHED_TRACE_MAIN;
+		if (cycle != sched_trace_cycle[sched_inx]) {
+			/* Write out the previous cycle in one piece */
+			fflush(sched_trace_fp);
+			sched_trace_cycle[sched_inx] = cycle;
+		}
+		fprintf(sched_trace_fp, "%s;cycle=%u;JobId=%u;%s %ld\n",
+			sched_name, cycle, job_ptr->job_id, func, usec);
+	}
+	slurm_mutex_unlock(&sched_cost_mutex);
+}
+
+/*
+ * Drop a job which no longer waits to be scheduled (started, held, ended or
+ * purged) from the costliest pending jobs.
+ * NOTE: Job write lock must be held
+ */
+extern void sched_cost_remove(job_record_t *job_ptr)
+{
+	if (!job_ptr->sched_tests)
+		return;	/* never tested, can't be listed */
+
+	slurm_mutex_lock(&sched_cost_mutex);
+	_sched_cost_top_remove(job_ptr->job_id);
+	slurm_mutex_unlock(&sched_cost_mutex);
+}
+
+/* Close the scheduling trace file, once the schedulers have stopped */
+extern void sched_cost_fini(void)
+{
+	slurm_mutex_lock(&sched_cost_mutex);
+	_sched_trace_close();
+	sched_cost_conf_update = slurm_conf.last_update;
+	slurm_mutex_unlock(&sched_cost_mutex);
+}
+
+/* Pack sched_cost_top, without slurmctld locks so sdiag never waits on them */
+static void _pack_sched_cost(buf_t *buffer)
+{
+	sched_cost_top_t top;
+
+	slurm_mutex_lock(&sched_cost_mutex);
+	top = sched_cost_top;
+	slurm_mutex_unlock(&sched_cost_mutex);
+
+	pack32(top.cnt, buffer);
+	pack32_array(top.job_id, top.cnt, buffer);
+	pack32_array(top.tests, top.cnt, buffer);
+	pack64_array(top.usec, top.cnt, buffer);
+}
+
 /* Pack all scheduling statistics */
 extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			  uint16_t protocol_version)
@@ -140,6 +341,22 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			pack32(slurmctld_diag_stats.bf_active, buffer);
 			pack32(slurmctld_diag_stats.backfilled_het_jobs,
 			       buffer);
+
+			if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+				pack32(slurmctld_diag_stats.node_reg_cnt,
+				       buffer);
+				pack32(slurmctld_diag_stats.node_reg_time_max,
+				       buffer);
+				pack64(slurmctld_diag_stats.node_reg_time_sum,
+				       buffer);
+				pack64(slurmctld_diag_stats.acct_policy_cnt,
+				       buffer);
+				pack32(slurmctld_diag_stats.acct_policy_time_max,
+				       buffer);
+				pack64(slurmctld_diag_stats.acct_policy_time_sum,
+				       buffer);
+				_pack_sched_cost(buffer);
+			}
 		}
 	}
 
@@ -180,6 +397,14 @@ extern void reset_stats(int level)
 	slurmctld_diag_stats.bf_cycle_max = 0;
 	slurmctld_diag_stats.bf_last_depth = 0;
 	slurmctld_diag_stats.bf_last_depth_try = 0;
+	reset_node_reg_stats();
+	acct_policy_reset_stats();
+
+	/* Jobs reset their scheduling cost when next tested */
+	slurm_mutex_lock(&sched_cost_mutex);
+	sched_cost_epoch++;
+	memset(&sched_cost_top, 0, sizeof(sched_cost_top));
+	slurm_mutex_unlock(&sched_cost_mutex);
 
 	last_proc_req_start = time(NULL);
 }
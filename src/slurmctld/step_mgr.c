@@ -1070,10 +1070,10 @@ static bitstr_t *_pick_step_nodes(job_record_t *job_ptr,
 		 * Ignore step features if equal to job features.
 		 * FIXME: Add support for AND, OR, etc. here if desired
 		 */
-		node_feature_t *feat_ptr;
-		feat_ptr = list_find_first(active_feature_list,
-					   list_find_feature,
-					   (void *) step_spec->features);
+		feature_dict_t *dict_ptr;
+		node_feature_t *feat_ptr = NULL;
+		if ((dict_ptr = find_feature_dict(step_spec->features)))
+			feat_ptr = dict_ptr->active;
 		if (feat_ptr && feat_ptr->node_bitmap)
 			bit_and(nodes_avail, feat_ptr->node_bitmap);
 		else
@@ -0,0 +1,365 @@
+/*****************************************************************************\
+ *  jag_sampler.c - node wide process sampler shared by all slurmstepds
+ *****************************************************************************
+ *  Copyright (C) 2021 agent <agent@local>
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "config.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "slurm/slurm.h"
+
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_acct_gather.h"
+#include "src/common/slurm_acct_gather_profile.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/timers.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include "src/slurmd/common/jag_sampler.h"
+#include "src/slurmd/slurmd/slurmd.h"
+
+#define JAG_SAMPLER_MAGIC	0x4a414753
+#define JAG_SAMPLER_VERSION	1
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t interval;	/* seconds between samples */
+	uint32_t sample_cnt;
+	time_t sample_time;
+} jag_sampler_hdr_t;
+
+static pthread_mutex_t sampler_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sampler_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t sampler_thread = 0;
+static bool sampler_shutdown = false;
+static int sampler_interval = 0;
+
+static char *_sampler_file(void)
+{
+	return xstrdup_printf("%s/jag_sampler", conf->spooldir);
+}
+
+static int _read_file(const char *path, char *buf, size_t size)
+{
+	int fd, n;
+
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		return -1;
+	n = read(fd, buf, size - 1);
+	(void) close(fd);
+	if (n <= 0)
+		return -1;
+	buf[n] = '\0';
+
+	return n;
+}
+
+/*
+ * Fill sample from /proc/<pid>/stat and /proc/<pid>/io, see proc(5).
+ * Only thread group leaders are listed in /proc so lightweight processes
+ * do not need to be filtered out here.
+ */
+static bool _sample_pid(const char *pid_str, jag_sample_t *sample)
+{
+	char path[PATH_MAX], buf[512], *tmp;
+	long unsigned majflt, utime, stime, vsize;
+	long int rss;
+	int ppid, last_cpu;
+
+	snprintf(path, sizeof(path), "/proc/%s/stat", pid_str);
+	if (_read_file(path, buf, sizeof(buf)) < 0)
+		return false;
+	/* Skip "pid (cmd)", cmd may contain spaces and ')' */
+	if (!(tmp = strrchr(buf, ')')))
+		return false;
+	if (sscanf(tmp + 2,
+		   "%*c %d %*d %*d %*d %*d "
+		   "%*u %*u %*u %lu %*u "
+		   "%lu %lu %*d %*d %*d %*d "
+		   "%*d %*d %*u %lu %ld "
+		   "%*u %*u %*u %*u %*u "
+		   "%*u %*u %*u %*u %*u "
+		   "%*u %*u %*u %*d %d",
+		   &ppid, &majflt, &utime, &stime, &vsize, &rss,
+		   &last_cpu) != 7)
+		return false;
+	if (rss < 0)
+		return false;
+
+	sample->pid = atoi(pid_str);
+	sample->ppid = ppid;
+	sample->last_cpu = last_cpu;
+	sample->utime = utime;
+	sample->stime = stime;
+	sample->majflt = majflt;
+	sample->rss = (uint64_t) rss * getpagesize();
+	sample->vsize = vsize;
+
+	snprintf(path, sizeof(path), "/proc/%s/io", pid_str);
+	if ((_read_file(path, buf, sizeof(buf)) < 0) ||
+	    (sscanf(buf, "rchar: %"PRIu64" wchar: %"PRIu64,
+		    &sample->rchar, &sample->wchar) != 2)) {
+		sample->rchar = INFINITE64;
+		sample->wchar = INFINITE64;
+	}
+
+	return true;
+}
+
+static int _cmp_pid(const void *a, const void *b)
+{
+	const jag_sample_t *sa = a, *sb = b;
+
+	return (sa->pid > sb->pid) - (sa->pid < sb->pid);
+}
+
+/* Write to a new file and rename it so readers never see a partial one */
+static void _write_samples(char *file, char *new_file,
+			   jag_sample_t *samples, uint32_t sample_cnt)
+{
+	jag_sampler_hdr_t hdr = {
+		.magic = JAG_SAMPLER_MAGIC,
+		.version = JAG_SAMPLER_VERSION,
+		.interval = sampler_interval,
+		.sample_cnt = sample_cnt,
+		.sample_time = time(NULL),
+	};
+	int fd;
+
+	if ((fd = open(new_file, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC,
+		       0600)) < 0) {
+		error("%s: open(%s): %m", __func__, new_file);
+		return;
+	}
+	safe_write(fd, &hdr, sizeof(hdr));
+	safe_write(fd, samples, (sample_cnt * sizeof(jag_sample_t)));
+	(void) close(fd);
+
+	if (rename(new_file, file) < 0) {
+		error("%s: rename(%s, %s): %m", __func__, new_file, file);
+		(void) unlink(new_file);
+	}
+	return;
+
+rwfail:
+	error("%s: write(%s): %m", __func__, new_file);
+	(void) close(fd);
+	(void) unlink(new_file);
+}
+
+static void *_sampler_agent(void *arg)
+{
+	char *file = _sampler_file();
+	char *new_file = xstrdup_printf("%s.new", file);
+	jag_sample_t *samples = NULL;
+	uint32_t sample_cnt, sample_max = 0;
+	struct dirent *ent;
+	struct timespec ts = { 0, 0 };
+	DIR *proc;
+	DEF_TIMERS;
+
+	while (true) {
+		START_TIMER;
+		if (!(proc = opendir("/proc"))) {
+			error("%s: opendir(/proc): %m", __func__);
+			goto wait;
+		}
+		sample_cnt = 0;
+		while ((ent = readdir(proc))) {
+			if (!isdigit(ent->d_name[0]))
+				continue;
+			if (sample_cnt == sample_max) {
+				sample_max = MAX(1024, sample_max * 2);
+				xrecalloc(samples, sample_max,
+					  sizeof(jag_sample_t));
+			}
+			if (_sample_pid(ent->d_name, &samples[sample_cnt]))
+				sample_cnt++;
+		}
+		(void) closedir(proc);
+
+		qsort(samples, sample_cnt, sizeof(jag_sample_t), _cmp_pid);
+		_write_samples(file, new_file, samples, sample_cnt);
+		END_TIMER;
+		log_flag(JAG, "%s: sampled %u processes in %s",
+			 __func__, sample_cnt, TIME_STR);
+
+wait:
+		slurm_mutex_lock(&sampler_mutex);
+		if (!sampler_shutdown) {
+			ts.tv_sec = time(NULL) + sampler_interval;
+			slurm_cond_timedwait(&sampler_cond, &sampler_mutex,
+					     &ts);
+		}
+		if (sampler_shutdown) {
+			slurm_mutex_unlock(&sampler_mutex);
+			break;
+		}
+		slurm_mutex_unlock(&sampler_mutex);
+	}
+
+	/* Make the slurmstepds go back to reading /proc themselves */
+	(void) unlink(file);
+	xfree(samples);
+	xfree(new_file);
+	xfree(file);
+
+	return NULL;
+}
+
+extern bool jag_sampler_enabled(void)
+{
+	/* NoShared and UsePss need /proc/<pid>/statm or smaps */
+	return (xstrcasestr(slurm_conf.job_acct_gather_params,
+			    "SharedSampler") &&
+		!xstrcasestr(slurm_conf.job_acct_gather_params, "NoShare") &&
+		!xstrcasestr(slurm_conf.job_acct_gather_params, "UsePss"));
+}
+
+extern void jag_sampler_init(void)
+{
+	if (sampler_thread || !jag_sampler_enabled())
+		return;
+
+	sampler_interval = acct_gather_parse_freq(
+		PROFILE_TASK, slurm_conf.job_acct_gather_freq);
+	if (sampler_interval <= 0) {
+		info("%s: JobAcctGatherFrequency disables task sampling, SharedSampler ignored",
+		     __func__);
+		return;
+	}
+
+	sampler_shutdown = false;
+	slurm_thread_create(&sampler_thread, _sampler_agent, NULL);
+	debug("%s: sampling processes every %d seconds",
+	      __func__, sampler_interval);
+}
+
+extern void jag_sampler_reconfig(void)
+{
+	jag_sampler_fini();
+	jag_sampler_init();
+}
+
+extern void jag_sampler_fini(void)
+{
+	if (!sampler_thread)
+		return;
+
+	slurm_mutex_lock(&sampler_mutex);
+	sampler_shutdown = true;
+	slurm_cond_signal(&sampler_cond);
+	slurm_mutex_unlock(&sampler_mutex);
+
+	pthread_join(sampler_thread, NULL);
+	sampler_thread = 0;
+}
+
+extern jag_samples_t *jag_sampler_open(void)
+{
+	jag_sampler_hdr_t *hdr;
+	jag_samples_t *samples;
+	struct stat st;
+	char *file = _sampler_file();
+	void *map;
+	int fd;
+
+	fd = open(file, O_RDONLY | O_CLOEXEC);
+	xfree(file);
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &st) || (st.st_size < sizeof(jag_sampler_hdr_t))) {
+		(void) close(fd);
+		return NULL;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	(void) close(fd);
+	if (map == MAP_FAILED)
+		return NULL;
+
+	hdr = map;
+	if ((hdr->magic != JAG_SAMPLER_MAGIC) ||
+	    (hdr->version != JAG_SAMPLER_VERSION) ||
+	    (st.st_size < (sizeof(jag_sampler_hdr_t) +
+			   ((size_t) hdr->sample_cnt *
+			    sizeof(jag_sample_t))))) {
+		log_flag(JAG, "%s: invalid sample file", __func__);
+		(void) munmap(map, st.st_size);
+		return NULL;
+	}
+	/* slurmd is gone or stuck, do not report stale usage */
+	if ((time(NULL) - hdr->sample_time) > ((2 * hdr->interval) + 1)) {
+		log_flag(JAG, "%s: samples from %ld are too old",
+			 __func__, (long) hdr->sample_time);
+		(void) munmap(map, st.st_size);
+		return NULL;
+	}
+
+	samples = xmalloc(sizeof(*samples));
+	samples->map = map;
+	samples->map_size = st.st_size;
+	samples->sample_time = hdr->sample_time;
+	samples->sample_cnt = hdr->sample_cnt;
+	samples->samples = (jag_sample_t *) (hdr + 1);
+
+	return samples;
+}
+
+extern jag_sample_t *jag_sampler_find(jag_samples_t *samples, pid_t pid)
+{
+	jag_sample_t key = { .pid = pid };
+
+	return bsearch(&key, samples->samples, samples->sample_cnt,
+		       sizeof(jag_sample_t), _cmp_pid);
+}
+
+extern void jag_sampler_close(jag_samples_t *samples)
+{
+	if (!samples)
+		return;
+
+	(void) munmap(samples->map, samples->map_size);
+	xfree(samples);
+}
@@ -0,0 +1,90 @@
+/*****************************************************************************\
+ *  jag_sampler.h - node wide process sampler shared by all slurmstepds
+ *****************************************************************************
+ *  Copyright (C) 2021 agent <agent@local>
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _JAG_SAMPLER_H
+#define _JAG_SAMPLER_H
+
+#include <inttypes.h>
+#include <sys/types.h>
+
+/*
+ * With JobAcctGatherParams=SharedSampler slurmd reads /proc once per
+ * JobAcctGatherFrequency and publishes one record per process in a file in
+ * the spool directory.  The jobacct_gather plugins in the slurmstepds map
+ * that file instead of reading /proc for each of their processes.
+ */
+
+typedef struct {
+	pid_t pid;
+	pid_t ppid;
+	int last_cpu;
+	uint64_t utime;		/* clock ticks */
+	uint64_t stime;		/* clock ticks */
+	uint64_t majflt;
+	uint64_t rss;		/* bytes */
+	uint64_t vsize;		/* bytes */
+	uint64_t rchar;		/* INFINITE64 if /proc/<pid>/io was unreadable */
+	uint64_t wchar;
+} jag_sample_t;
+
+typedef struct {
+	void *map;
+	size_t map_size;
+	time_t sample_time;
+	uint32_t sample_cnt;
+	jag_sample_t *samples;	/* sorted by pid */
+} jag_samples_t;
+
+/* Return true if JobAcctGatherParams asks for the shared sampler */
+extern bool jag_sampler_enabled(void);
+
+/* slurmd: start, restart after a reconfigure, or stop the sampler thread */
+extern void jag_sampler_init(void);
+extern void jag_sampler_reconfig(void);
+extern void jag_sampler_fini(void);
+
+/*
+ * slurmstepd: map the latest samples.
+ * RET NULL if there are none or they are too old to be used, otherwise the
+ *     samples to be released with jag_sampler_close().
+ */
+extern jag_samples_t *jag_sampler_open(void);
+
+/* Find the sample for pid, NULL if the process was not seen by slurmd */
+extern jag_sample_t *jag_sampler_find(jag_samples_t *samples, pid_t pid);
+
+extern void jag_sampler_close(jag_samples_t *samples);
+
+#endif /* _JAG_SAMPLER_H */
@@ -91,6 +91,7 @@
 #include "src/common/slurm_protocol_interface.h"
 #include "src/common/stepd_api.h"
 #include "src/common/switch.h"
+#include "src/common/timers.h"
 #include "src/common/uid.h"
 #include "src/common/util-net.h"
 #include "src/common/xstring.h"
@@ -262,9 +263,80 @@ static List bcast_libdir_list = NULL;
 
 static pthread_mutex_t waiter_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/*
+ * Pre-started slurmstepds (LaunchParameters=slurmstepd_pool=#). Each one has
+ * been exec'd, has read slurm.conf and loaded its select and auth plugins, and
+ * is blocked reading its launch data from the to_stepd pipe.
+ */
+#define STEPD_POOL_MAX 64
+typedef struct {
+	int to_stepd;		/* write end of slurmstepd's stdin */
+	int to_slurmd;		/* read end of slurmstepd's stdout */
+} stepd_pool_ent_t;
+static pthread_mutex_t stepd_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  stepd_pool_cond  = PTHREAD_COND_INITIALIZER;
+static stepd_pool_ent_t stepd_pool[STEPD_POOL_MAX];
+static int stepd_pool_cnt = 0;
+static int stepd_pool_size = 0;
+static uint32_t stepd_pool_gen = 0;
+static bool stepd_pool_shutdown = false;
+static pthread_t stepd_pool_thread = 0;
+
+/* Per RPC type processing time, reported by "scontrol show slurmd" */
+#define RPC_TYPE_SIZE 50
+static pthread_mutex_t rpc_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint16_t rpc_type_id[RPC_TYPE_SIZE] = { 0 };
+static uint32_t rpc_type_cnt[RPC_TYPE_SIZE] = { 0 };
+static uint64_t rpc_type_time[RPC_TYPE_SIZE] = { 0 };
+static uint32_t rpc_type_time_max[RPC_TYPE_SIZE] = { 0 };
+
+static void _record_rpc_stats(uint16_t msg_type, long delta)
+{
+	slurm_mutex_lock(&rpc_stats_mutex);
+	for (int i = 0; i < RPC_TYPE_SIZE; i++) {
+		if (rpc_type_id[i] == 0)
+			rpc_type_id[i] = msg_type;
+		else if (rpc_type_id[i] != msg_type)
+			continue;
+		rpc_type_cnt[i]++;
+		rpc_type_time[i] += delta;
+		if (delta > rpc_type_time_max[i])
+			rpc_type_time_max[i] = delta;
+		break;
+	}
+	slurm_mutex_unlock(&rpc_stats_mutex);
+}
+
+static void _copy_rpc_stats(slurmd_status_t *resp)
+{
+	int i;
+
+	slurm_mutex_lock(&rpc_stats_mutex);
+	for (i = 0; i < RPC_TYPE_SIZE; i++) {
+		if (rpc_type_id[i] == 0)
+			break;
+	}
+	resp->rpc_type_size = i;
+	if (i) {
+		resp->rpc_type_id = xcalloc(i, sizeof(uint16_t));
+		resp->rpc_type_cnt = xcalloc(i, sizeof(uint32_t));
+		resp->rpc_type_time = xcalloc(i, sizeof(uint64_t));
+		resp->rpc_type_time_max = xcalloc(i, sizeof(uint32_t));
+		memcpy(resp->rpc_type_id, rpc_type_id, i * sizeof(uint16_t));
+		memcpy(resp->rpc_type_cnt, rpc_type_cnt, i * sizeof(uint32_t));
+		memcpy(resp->rpc_type_time, rpc_type_time,
+		       i * sizeof(uint64_t));
+		memcpy(resp->rpc_type_time_max, rpc_type_time_max,
+		       i * sizeof(uint32_t));
+	}
+	slurm_mutex_unlock(&rpc_stats_mutex);
+}
+
 void
 slurmd_req(slurm_msg_t *msg)
 {
+	DEF_TIMERS;
+
 	if (msg == NULL) {
 		if (startup == 0)
 			startup = time(NULL);
@@ -285,6 +357,7 @@ slurmd_req(slurm_msg_t *msg)
 		      __func__);
 
 	debug2("Processing RPC: %s", rpc_num2string(msg->msg_type));
+	START_TIMER;
 	switch (msg->msg_type) {
 	case REQUEST_LAUNCH_PROLOG:
 		_rpc_prolog(msg);
@@ -391,9 +464,10 @@ slurmd_req(slurm_msg_t *msg)
 		error("slurmd_req: invalid request msg type %d",
 		      msg->msg_type);
 		slurm_send_rc_msg(msg, EINVAL);
-		break;
+		return;
 	}
-	return;
+	END_TIMER;
+	_record_rpc_stats(msg->msg_type, DELTA_TIMER);
 }
 
 extern int send_slurmd_conf_lite(int fd, slurmd_conf_t *cf)
@@ -641,6 +715,342 @@ rwfail:
 	return errno;
 }
 
+/*
+ * Send the slurmstepd its initialization data, then wait for it to send an
+ * "ok" message and acknowledge it.
+ */
+static int _handshake_slurmstepd(int to_stepd, int to_slurmd, uint16_t type,
+				 void *req, slurm_addr_t *cli,
+				 slurm_addr_t *self, const hostset_t step_hset,
+				 uint16_t protocol_version)
+{
+	int rc = SLURM_SUCCESS;
+#if (SLURMSTEPD_MEMCHECK == 0)
+	int i;
+	time_t start_time = time(NULL);
+#endif
+
+	if ((rc = _send_slurmstepd_init(to_stepd, type, req, cli, self,
+					step_hset, protocol_version)) != 0) {
+		error("Unable to init slurmstepd");
+		return rc;
+	}
+
+	/* If running under valgrind/memcheck, this pipe doesn't work
+	 * correctly so just skip it. */
+#if (SLURMSTEPD_MEMCHECK == 0)
+	i = read(to_slurmd, &rc, sizeof(int));
+	if (i < 0) {
+		error("%s: Can not read return code from slurmstepd "
+		      "got %d: %m", __func__, i);
+		rc = SLURM_ERROR;
+	} else if (i != sizeof(int)) {
+		error("%s: slurmstepd failed to send return code "
+		      "got %d: %m", __func__, i);
+		rc = SLURM_ERROR;
+	} else {
+		int delta_time = time(NULL) - start_time;
+		int cc;
+		if (delta_time > 5) {
+			info("Warning: slurmstepd startup took %d sec, "
+			     "possible file system problem or full "
+			     "memory", delta_time);
+		}
+		if (rc != SLURM_SUCCESS)
+			error("slurmstepd return code %d: %s",
+			      rc, slurm_strerror(rc));
+
+		cc = SLURM_SUCCESS;
+		cc = write(to_stepd, &cc, sizeof(int));
+		if (cc != sizeof(int)) {
+			error("%s: failed to send ack to stepd %d: %m",
+			      __func__, cc);
+		}
+	}
+#endif
+	return rc;
+}
+
+/*
+ * Called in the forked child. Fork again and exec the slurmstepd in the
+ * grandchild with to_stepd[0] as its stdin and to_slurmd[1] as its stdout.
+ * Never returns.
+ */
+static void _exec_slurmstepd(char *const argv[], int to_stepd[2],
+			     int to_slurmd[2]) __attribute__((noreturn));
+static void _exec_slurmstepd(char *const argv[], int to_stepd[2],
+			     int to_slurmd[2])
+{
+	pid_t pid;
+	int i;
+	int failed = 0;
+
+	/*
+	 * Child forks and exits
+	 */
+	if (setsid() < 0) {
+		error("%s: setsid: %m", __func__);
+		failed = 1;
+	}
+	if ((pid = fork()) < 0) {
+		error("%s: Unable to fork grandchild: %m", __func__);
+		failed = 2;
+	} else if (pid > 0) { /* child */
+		_exit(0);
+	}
+
+	/*
+	 * Just in case we (or someone we are linking to)
+	 * opened a file and didn't do a close on exec.  This
+	 * is needed mostly to protect us against libs we link
+	 * to that don't set the flag as we should already be
+	 * setting it for those that we open.  The number 256
+	 * is an arbitrary number based off test7.9.
+	 */
+	for (i=3; i<256; i++) {
+		(void) fcntl(i, F_SETFD, FD_CLOEXEC);
+	}
+
+	/*
+	 * Grandchild exec's the slurmstepd
+	 *
+	 * If the slurmd is being shutdown/restarted before
+	 * the pipe happens the old conf->lfd could be reused
+	 * and if we close it the dup2 below will fail.
+	 */
+	if ((to_stepd[0] != conf->lfd)
+	    && (to_slurmd[1] != conf->lfd))
+		close(conf->lfd);
+
+	if (close(to_stepd[1]) < 0)
+		error("close write to_stepd in grandchild: %m");
+	if (close(to_slurmd[0]) < 0)
+		error("close read to_slurmd in parent: %m");
+
+	(void) close(STDIN_FILENO); /* ignore return */
+	if (dup2(to_stepd[0], STDIN_FILENO) == -1) {
+		error("dup2 over STDIN_FILENO: %m");
+		_exit(1);
+	}
+	fd_set_close_on_exec(to_stepd[0]);
+	(void) close(STDOUT_FILENO); /* ignore return */
+	if (dup2(to_slurmd[1], STDOUT_FILENO) == -1) {
+		error("dup2 over STDOUT_FILENO: %m");
+		_exit(1);
+	}
+	fd_set_close_on_exec(to_slurmd[1]);
+	(void) close(STDERR_FILENO); /* ignore return */
+	if (dup2(devnull, STDERR_FILENO) == -1) {
+		error("dup2 /dev/null to STDERR_FILENO: %m");
+		_exit(1);
+	}
+	fd_set_noclose_on_exec(STDERR_FILENO);
+	log_fini();
+	if (!failed) {
+		execvp(argv[0], argv);
+		error("exec of slurmstepd failed: %m");
+	}
+	_exit(2);
+}
+
+/* Return the LaunchParameters=slurmstepd_pool=# setting */
+static int _stepd_pool_conf_size(void)
+{
+#if (SLURMSTEPD_MEMCHECK == 0)
+	char *tmp_ptr;
+	int size;
+
+	if (!(tmp_ptr = xstrcasestr(slurm_conf.launch_params,
+				    "slurmstepd_pool=")))
+		return 0;
+
+	size = atoi(tmp_ptr + 16);
+	if ((size < 0) || (size > STEPD_POOL_MAX)) {
+		error("Invalid LaunchParameters slurmstepd_pool=%d, using %d",
+		      size, STEPD_POOL_MAX);
+		size = (size < 0) ? 0 : STEPD_POOL_MAX;
+	}
+	return size;
+#else
+	/* Pre-started slurmstepds are not run under valgrind/memcheck */
+	return 0;
+#endif
+}
+
+static void _stepd_pool_close(stepd_pool_ent_t *ent)
+{
+	if (close(ent->to_stepd) < 0)
+		error("close write to_stepd of pooled slurmstepd: %m");
+	if (close(ent->to_slurmd) < 0)
+		error("close read to_slurmd of pooled slurmstepd: %m");
+}
+
+/*
+ * Start a slurmstepd which initializes itself and then blocks reading its
+ * launch data from the to_stepd pipe.
+ */
+static int _stepd_pool_spawn(stepd_pool_ent_t *ent)
+{
+	char *const argv[2] = { (char *)conf->stepd_loc, NULL };
+	int to_stepd[2] = {-1, -1};
+	int to_slurmd[2] = {-1, -1};
+	pid_t pid;
+
+	if (pipe(to_stepd) < 0) {
+		error("%s: pipe failed: %m", __func__);
+		return SLURM_ERROR;
+	}
+	if (pipe(to_slurmd) < 0) {
+		error("%s: pipe failed: %m", __func__);
+		close(to_stepd[0]);
+		close(to_stepd[1]);
+		return SLURM_ERROR;
+	}
+
+	if ((pid = fork()) < 0) {
+		error("%s: fork: %m", __func__);
+		close(to_stepd[0]);
+		close(to_stepd[1]);
+		close(to_slurmd[0]);
+		close(to_slurmd[1]);
+		return SLURM_ERROR;
+	} else if (pid == 0) {
+		_exec_slurmstepd(argv, to_stepd, to_slurmd);
+	}
+
+	if (close(to_stepd[0]) < 0)
+		error("Unable to close read to_stepd in parent: %m");
+	if (close(to_slurmd[1]) < 0)
+		error("Unable to close write to_slurmd in parent: %m");
+	fd_set_close_on_exec(to_stepd[1]);
+	fd_set_close_on_exec(to_slurmd[0]);
+
+	/* Reap child */
+	if (waitpid(pid, NULL, 0) < 0)
+		error("Unable to reap slurmd child process");
+
+	ent->to_stepd = to_stepd[1];
+	ent->to_slurmd = to_slurmd[0];
+	return SLURM_SUCCESS;
+}
+
+/* Keep stepd_pool filled up to stepd_pool_size entries */
+static void *_stepd_pool_agent(void *arg)
+{
+	stepd_pool_ent_t ent;
+	struct timespec ts = {0, 0};
+	uint32_t gen;
+	int rc;
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	while (!stepd_pool_shutdown) {
+		if (stepd_pool_cnt >= stepd_pool_size) {
+			slurm_cond_wait(&stepd_pool_cond, &stepd_pool_mutex);
+			continue;
+		}
+		gen = stepd_pool_gen;
+		slurm_mutex_unlock(&stepd_pool_mutex);
+
+		rc = _stepd_pool_spawn(&ent);
+
+		slurm_mutex_lock(&stepd_pool_mutex);
+		if (rc != SLURM_SUCCESS) {
+			/* Back off rather than spin on fork/pipe failures */
+			ts.tv_sec = time(NULL) + 1;
+			slurm_cond_timedwait(&stepd_pool_cond,
+					     &stepd_pool_mutex, &ts);
+		} else if (stepd_pool_shutdown || (gen != stepd_pool_gen) ||
+			   (stepd_pool_cnt >= stepd_pool_size)) {
+			/* Started with an outdated configuration */
+			_stepd_pool_close(&ent);
+		} else {
+			stepd_pool[stepd_pool_cnt++] = ent;
+		}
+	}
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	return NULL;
+}
+
+/*
+ * Take a pre-started slurmstepd out of the pool.
+ * RET true if one was available, false if the caller must fork its own.
+ */
+static bool _stepd_pool_get(stepd_pool_ent_t *ent)
+{
+	struct pollfd pfd;
+	bool found = false;
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	while (!found && stepd_pool_cnt) {
+		*ent = stepd_pool[--stepd_pool_cnt];
+
+		/*
+		 * A live slurmstepd still holds the write end of the
+		 * to_slurmd pipe open. Skip any that have died.
+		 */
+		pfd.fd = ent->to_slurmd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if ((poll(&pfd, 1, 0) == 0) || !pfd.revents) {
+			found = true;
+		} else {
+			debug("%s: discarding dead pooled slurmstepd",
+			      __func__);
+			_stepd_pool_close(ent);
+		}
+	}
+	if (stepd_pool_size)
+		slurm_cond_signal(&stepd_pool_cond);
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	return found;
+}
+
+/* Close all pooled slurmstepds, they exit when they see EOF */
+static void _stepd_pool_purge(void)
+{
+	while (stepd_pool_cnt)
+		_stepd_pool_close(&stepd_pool[--stepd_pool_cnt]);
+	stepd_pool_gen++;
+}
+
+extern void stepd_pool_init(void)
+{
+	slurm_mutex_lock(&stepd_pool_mutex);
+	stepd_pool_size = _stepd_pool_conf_size();
+	stepd_pool_shutdown = false;
+	if (!stepd_pool_thread)
+		slurm_thread_create(&stepd_pool_thread, _stepd_pool_agent,
+				    NULL);
+	slurm_mutex_unlock(&stepd_pool_mutex);
+}
+
+extern void stepd_pool_reconfig(void)
+{
+	slurm_mutex_lock(&stepd_pool_mutex);
+	_stepd_pool_purge();
+	stepd_pool_size = _stepd_pool_conf_size();
+	slurm_cond_signal(&stepd_pool_cond);
+	slurm_mutex_unlock(&stepd_pool_mutex);
+}
+
+extern void stepd_pool_fini(void)
+{
+	slurm_mutex_lock(&stepd_pool_mutex);
+	stepd_pool_shutdown = true;
+	slurm_cond_signal(&stepd_pool_cond);
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	if (stepd_pool_thread) {
+		pthread_join(stepd_pool_thread, NULL);
+		stepd_pool_thread = 0;
+	}
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	_stepd_pool_purge();
+	slurm_mutex_unlock(&stepd_pool_mutex);
+}
 
 /*
  * Fork and exec the slurmstepd, then send the slurmstepd its
@@ -649,6 +1059,9 @@ rwfail:
  * the slurmstepd has created and begun listening on its unix
  * domain socket.
  *
+ * If LaunchParameters=slurmstepd_pool is configured and a pre-started
+ * slurmstepd is available, it is used instead of forking a new one.
+ *
  * Note that this code forks twice and it is the grandchild that
  * becomes the slurmstepd process, so the slurmstepd's parent process
  * will be init, not slurmd.
@@ -661,14 +1074,29 @@ _forkexec_slurmstepd(uint16_t type, void *req,
 	pid_t pid;
 	int to_stepd[2] = {-1, -1};
 	int to_slurmd[2] = {-1, -1};
+	stepd_pool_ent_t pooled;
 
-	if (pipe(to_stepd) < 0 || pipe(to_slurmd) < 0) {
-		error("%s: pipe failed: %m", __func__);
+	if (_add_starting_step(type, req)) {
+		error("%s: failed in _add_starting_step: %m", __func__);
 		return SLURM_ERROR;
 	}
 
-	if (_add_starting_step(type, req)) {
-		error("%s: failed in _add_starting_step: %m", __func__);
+	if (_stepd_pool_get(&pooled)) {
+		int rc;
+
+		debug2("%s: using pre-started slurmstepd", __func__);
+		rc = _handshake_slurmstepd(pooled.to_stepd, pooled.to_slurmd,
+					   type, req, cli, self, step_hset,
+					   protocol_version);
+		if (_remove_starting_step(type, req))
+			error("Error cleaning up starting_step list");
+		_stepd_pool_close(&pooled);
+		return rc;
+	}
+
+	if (pipe(to_stepd) < 0 || pipe(to_slurmd) < 0) {
+		error("%s: pipe failed: %m", __func__);
+		_remove_starting_step(type, req);
 		return SLURM_ERROR;
 	}
 
@@ -681,11 +1109,7 @@ _forkexec_slurmstepd(uint16_t type, void *req,
 		_remove_starting_step(type, req);
 		return SLURM_ERROR;
 	} else if (pid > 0) {
-		int rc = SLURM_SUCCESS;
-#if (SLURMSTEPD_MEMCHECK == 0)
-		int i;
-		time_t start_time = time(NULL);
-#endif
+		int rc;
 		/*
 		 * Parent sends initialization data to the slurmstepd
 		 * over the to_stepd pipe, and waits for the return code
@@ -696,47 +1120,10 @@ _forkexec_slurmstepd(uint16_t type, void *req,
 		if (close(to_slurmd[1]) < 0)
 			error("Unable to close write to_slurmd in parent: %m");
 
-		if ((rc = _send_slurmstepd_init(to_stepd[1], type,
-						req, cli, self,
-						step_hset,
-						protocol_version)) != 0) {
-			error("Unable to init slurmstepd");
-			goto done;
-		}
+		rc = _handshake_slurmstepd(to_stepd[1], to_slurmd[0], type,
+					   req, cli, self, step_hset,
+					   protocol_version);
 
-		/* If running under valgrind/memcheck, this pipe doesn't work
-		 * correctly so just skip it. */
-#if (SLURMSTEPD_MEMCHECK == 0)
-		i = read(to_slurmd[0], &rc, sizeof(int));
-		if (i < 0) {
-			error("%s: Can not read return code from slurmstepd "
-			      "got %d: %m", __func__, i);
-			rc = SLURM_ERROR;
-		} else if (i != sizeof(int)) {
-			error("%s: slurmstepd failed to send return code "
-			      "got %d: %m", __func__, i);
-			rc = SLURM_ERROR;
-		} else {
-			int delta_time = time(NULL) - start_time;
-			int cc;
-			if (delta_time > 5) {
-				info("Warning: slurmstepd startup took %d sec, "
-				     "possible file system problem or full "
-				     "memory", delta_time);
-			}
-			if (rc != SLURM_SUCCESS)
-				error("slurmstepd return code %d: %s",
-				      rc, slurm_strerror(rc));
-
-			cc = SLURM_SUCCESS;
-			cc = write(to_stepd[1], &cc, sizeof(int));
-			if (cc != sizeof(int)) {
-				error("%s: failed to send ack to stepd %d: %m",
-				      __func__, cc);
-			}
-		}
-#endif
-	done:
 		if (_remove_starting_step(type, req))
 			error("Error cleaning up starting_step list");
 
@@ -823,75 +1210,8 @@ _forkexec_slurmstepd(uint16_t type, void *req,
 		/* no memory checking, default */
 		char *const argv[2] = { (char *)conf->stepd_loc, NULL};
 #endif
-		int i;
-		int failed = 0;
-
-		/*
-		 * Child forks and exits
-		 */
-		if (setsid() < 0) {
-			error("%s: setsid: %m", __func__);
-			failed = 1;
-		}
-		if ((pid = fork()) < 0) {
-			error("%s: Unable to fork grandchild: %m", __func__);
-			failed = 2;
-		} else if (pid > 0) { /* child */
-			_exit(0);
-		}
-
-		/*
-		 * Just in case we (or someone we are linking to)
-		 * opened a file and didn't do a close on exec.  This
-		 * is needed mostly to protect us against libs we link
-		 * to that don't set the flag as we should already be
-		 * setting it for those that we open.  The number 256
-		 * is an arbitrary number based off test7.9.
-		 */
-		for (i=3; i<256; i++) {
-			(void) fcntl(i, F_SETFD, FD_CLOEXEC);
-		}
 
-		/*
-		 * Grandchild exec's the slurmstepd
-		 *
-		 * If the slurmd is being shutdown/restarted before
-		 * the pipe happens the old conf->lfd could be reused
-		 * and if we close it the dup2 below will fail.
-		 */
-		if ((to_stepd[0] != conf->lfd)
-		    && (to_slurmd[1] != conf->lfd))
-			close(conf->lfd);
-
-		if (close(to_stepd[1]) < 0)
-			error("close write to_stepd in grandchild: %m");
-		if (close(to_slurmd[0]) < 0)
-			error("close read to_slurmd in parent: %m");
-
-		(void) close(STDIN_FILENO); /* ignore return */
-		if (dup2(to_stepd[0], STDIN_FILENO) == -1) {
-			error("dup2 over STDIN_FILENO: %m");
-			_exit(1);
-		}
-		fd_set_close_on_exec(to_stepd[0]);
-		(void) close(STDOUT_FILENO); /* ignore return */
-		if (dup2(to_slurmd[1], STDOUT_FILENO) == -1) {
-			error("dup2 over STDOUT_FILENO: %m");
-			_exit(1);
-		}
-		fd_set_close_on_exec(to_slurmd[1]);
-		(void) close(STDERR_FILENO); /* ignore return */
-		if (dup2(devnull, STDERR_FILENO) == -1) {
-			error("dup2 /dev/null to STDERR_FILENO: %m");
-			_exit(1);
-		}
-		fd_set_noclose_on_exec(STDERR_FILENO);
-		log_fini();
-		if (!failed) {
-			execvp(argv[0], argv);
-			error("exec of slurmstepd failed: %m");
-		}
-		_exit(2);
+		_exec_slurmstepd(argv, to_stepd, to_slurmd);
 	}
 }
 
@@ -3477,6 +3797,7 @@ static void _rpc_daemon_status(slurm_msg_t *msg)
 	resp->slurmd_debug       = conf->debug_level;
 	resp->slurmd_logfile     = xstrdup(conf->logfile);
 	resp->version            = xstrdup(SLURM_VERSION_STRING);
+	_copy_rpc_stats(resp);
 
 	slurm_msg_t_copy(&resp_msg, msg);
 	resp_msg.msg_type = RESPONSE_SLURMD_STATUS;
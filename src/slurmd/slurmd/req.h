@@ -59,6 +59,14 @@ void gids_cache_purge(void);
 /* Add record for every launched job so we know they are ready for suspend */
 extern void record_launched_jobs(void);
 
+/*
+ * Start, refresh (after slurm.conf changes) and stop the pool of pre-started
+ * slurmstepd processes configured with LaunchParameters=slurmstepd_pool=#
+ */
+extern void stepd_pool_init(void);
+extern void stepd_pool_reconfig(void);
+extern void stepd_pool_fini(void);
+
 void file_bcast_init(void);
 void file_bcast_purge(void);
 
@@ -101,12 +101,14 @@
 #include "src/common/stepd_api.h"
 #include "src/common/switch.h"
 #include "src/common/uid.h"
+#include "src/common/workq.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 #include "src/common/xsignal.h"
 #include "src/common/cgroup.h"
 
 #include "src/slurmd/common/core_spec_plugin.h"
+#include "src/slurmd/common/jag_sampler.h"
 #include "src/slurmd/common/job_container_plugin.h"
 #include "src/slurmd/common/proctrack.h"
 #include "src/slurmd/common/run_script.h"
@@ -122,6 +124,12 @@
 
 #define MAX_THREADS		256
 
+/*
+ * Number of persistent threads receiving RPCs. RPCs which may block are
+ * handed off to their own thread (see _rpc_may_block()).
+ */
+#define CONN_WORKER_CNT		64
+
 #define _free_and_set(__dst, __src)		\
 	do {					\
 		xfree(__dst); __dst = __src;	\
@@ -150,8 +158,11 @@ static pthread_mutex_t fork_mutex     = PTHREAD_MUTEX_INITIALIZER;
 typedef struct connection {
 	int fd;
 	slurm_addr_t *cli_addr;
+	slurm_msg_t *msg;
 } conn_t;
 
+static workq_t *conn_workq = NULL;
+
 /*
  * Global data for resource specialization
  */
@@ -203,7 +214,8 @@ static void      _resource_spec_fini(void);
 static int       _resource_spec_init(void);
 static int       _restore_cred_state(slurm_cred_ctx_t ctx);
 static void      _select_spec_cores(void);
-static void     *_service_connection(void *);
+static void      _service_connection(void *);
+static void     *_service_msg(void *);
 static int       _set_slurmd_spooldir(const char *dir);
 static int       _set_topo_info(void);
 static int       _set_work_dir(void);
@@ -215,6 +227,7 @@ static void      _usage(void);
 static void      _usr_handler(int);
 static int       _validate_and_convert_cpu_list(void);
 static void      _wait_for_all_threads(int secs);
+static void      _write_conf_snapshot(void);
 
 /**************************************************************************\
  * To test for memory leaks, set MEMORY_LEAK_DEBUG to 1 using
@@ -380,11 +393,15 @@ main (int argc, char **argv)
 	_install_fork_handlers();
 	slurm_conf_install_fork_handlers();
 	record_launched_jobs();
+	_write_conf_snapshot();
+	stepd_pool_init();
+	jag_sampler_init();
 
 	run_script_health_check();
 
 	slurm_thread_create_detached(NULL, _registration_engine, NULL);
 
+	conn_workq = new_workq(CONN_WORKER_CNT);
 	_msg_engine();
 
 	/*
@@ -397,6 +414,10 @@ main (int argc, char **argv)
 		      slurm_conf.slurmd_pidfile);
 
 	_wait_for_all_threads(120);
+	quiesce_workq(conn_workq);
+	FREE_NULL_WORKQ(conn_workq);
+	stepd_pool_fini();
+	jag_sampler_fini();
 	_slurmd_fini();
 	_destroy_conf();
 	slurm_cred_fini();	/* must be after _destroy_conf() */
@@ -553,19 +574,65 @@ static void _handle_connection(int fd, slurm_addr_t *cli)
 	fd_set_close_on_exec(fd);
 
 	_increment_thd_count();
-	slurm_thread_create_detached(NULL, _service_connection, arg);
+	if (workq_add_work(conn_workq, _service_connection, arg,
+			   "service_connection")) {
+		error("%s: unable to queue connection: %m", __func__);
+		close(fd);
+		xfree(arg->cli_addr);
+		xfree(arg);
+		_decrement_thd_count();
+	}
 }
 
-static void *
-_service_connection(void *arg)
+/*
+ * Return true if processing msg could block the calling thread for a long
+ * time (forking slurmstepd, running prolog/epilog or other scripts, talking
+ * to a slurmstepd which may hang, waiting on job termination or on forwarded
+ * messages).
+ */
+static bool _rpc_may_block(slurm_msg_t *msg)
+{
+	if (msg->forward_struct)
+		return true;
+
+	switch (msg->msg_type) {
+	case REQUEST_ACCT_GATHER_ENERGY:
+	case REQUEST_DAEMON_STATUS:
+	case REQUEST_PING:
+		return false;
+	default:
+		return true;
+	}
+}
+
+/* Release the connection and the message received on it */
+static void _close_connection(conn_t *con)
+{
+	slurm_msg_t *msg = con->msg;
+
+	if ((msg->conn_fd >= 0) && close(msg->conn_fd) < 0)
+		error ("close(%d): %m", con->fd);
+
+	xfree(con->cli_addr);
+	xfree(con);
+	debug2("Finish processing RPC: %s", rpc_num2string(msg->msg_type));
+	slurm_free_msg(msg);
+	_decrement_thd_count();
+}
+
+/* Receive an RPC on one of the conn_workq threads */
+static void _service_connection(void *arg)
 {
 	conn_t *con = (conn_t *) arg;
-	slurm_msg_t *msg = xmalloc(sizeof(slurm_msg_t));
 	int rc = SLURM_SUCCESS;
 
 	debug3("in the service_connection");
-	slurm_msg_t_init(msg);
-	if ((rc = slurm_receive_msg_and_forward(con->fd, con->cli_addr, msg))
+	con->msg = xmalloc(sizeof(slurm_msg_t));
+	slurm_msg_t_init(con->msg);
+	if ((rc = slurm_receive_msg_and_forward(con->fd, con->cli_addr,
+						con->msg,
+						slurm_conf.msg_timeout *
+						MSEC_IN_SEC))
 	   != SLURM_SUCCESS) {
 		error("service_connection: slurm_receive_msg: %m");
 		/*
@@ -573,22 +640,29 @@ _service_connection(void *arg)
 		 * to are taken care of and sent back. This way the control
 		 * also has a better idea what happened to us
 		 */
-		slurm_send_rc_msg(msg, rc);
-		goto cleanup;
+		slurm_send_rc_msg(con->msg, rc);
+		_close_connection(con);
+		return;
 	}
-	debug2("Start processing RPC: %s", rpc_num2string(msg->msg_type));
 
-	slurmd_req(msg);
+	if (_rpc_may_block(con->msg)) {
+		/* Don't tie up the worker pool, finish on our own thread */
+		slurm_thread_create_detached(NULL, _service_msg, con);
+		return;
+	}
 
-cleanup:
-	if ((msg->conn_fd >= 0) && close(msg->conn_fd) < 0)
-		error ("close(%d): %m", con->fd);
+	(void) _service_msg(con);
+}
+
+/* Process a received RPC, then release the connection */
+static void *_service_msg(void *arg)
+{
+	conn_t *con = (conn_t *) arg;
+
+	debug2("Start processing RPC: %s", rpc_num2string(con->msg->msg_type));
+	slurmd_req(con->msg);
+	_close_connection(con);
 
-	xfree(con->cli_addr);
-	xfree(con);
-	debug2("Finish processing RPC: %s", rpc_num2string(msg->msg_type));
-	slurm_free_msg(msg);
-	_decrement_thd_count();
 	return NULL;
 }
 
@@ -1166,6 +1240,9 @@ _reconfigure(void)
 	FREE_NULL_LIST(gres_list);
 
 	_build_conf_buf();
+	_write_conf_snapshot();
+	stepd_pool_reconfig();
+	jag_sampler_reconfig();
 
 	send_registration_msg(SLURM_SUCCESS, false);
 
@@ -1179,6 +1256,46 @@ _reconfigure(void)
 	 */
 }
 
+/*
+ * With SlurmdParameters=conf_snapshot save the parsed slurm.conf, so that
+ * slurmstepd and commands run on this node can load it instead of parsing
+ * slurm.conf again. slurm.conf may be shared by all the nodes, so the
+ * snapshot is written in the node's own SlurmdSpoolDir. When running
+ * configless it goes next to the cached slurm.conf, where commands look for
+ * it, and write_configs_to_conf_cache() clears the old one.
+ */
+static void _write_conf_snapshot(void)
+{
+	static char *written = NULL;	/* snapshot written by this slurmd */
+	bool enabled = xstrcasestr(slurm_conf.slurmd_params, "conf_snapshot");
+	char *snapshot;
+
+	if (conf->conf_cache)
+		snapshot = xstrdup_printf("%s.snapshot", conf->conffile);
+	else
+		snapshot = xstrdup_printf("%s/slurm.conf.snapshot",
+					  conf->spooldir);
+
+	if (enabled && (slurm_conf_snapshot_write(snapshot) == SLURM_SUCCESS)) {
+		debug("%s: wrote %s", __func__, snapshot);
+		setenv("SLURM_CONF_SNAPSHOT", snapshot, 1);
+		if (written && xstrcmp(written, snapshot))
+			(void) unlink(written);
+		xfree(written);
+		written = snapshot;
+		return;
+	}
+
+	if (enabled)
+		verbose("Unable to write slurm.conf snapshot %s", snapshot);
+	/* Only remove a snapshot written by this slurmd */
+	if (written)
+		(void) unlink(written);
+	xfree(written);
+	unsetenv("SLURM_CONF_SNAPSHOT");
+	xfree(snapshot);
+}
+
 static void
 _print_conf(void)
 {
@@ -56,6 +56,7 @@
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <termios.h>
 #include <unistd.h>
 
@@ -423,13 +424,20 @@ _client_read(eio_obj_t *obj, List objs)
 
 /*
  * Write outgoing packed messages to the client socket.
+ *
+ * Up to STDIO_MAX_IOV queued messages are gathered into a single writev(),
+ * so a task writing a lot of output does not cost one syscall per
+ * MAX_MSG_LEN bytes.  Messages not fully written are put back at the head of
+ * the queue, the first one possibly partially sent in client->out_msg.
  */
 static int
 _client_write(eio_obj_t *obj, List objs)
 {
 	struct client_io_info *client = (struct client_io_info *) obj->arg;
-	void *buf;
-	int n;
+	struct io_buf *msgs[STDIO_MAX_IOV];
+	struct iovec iov[STDIO_MAX_IOV];
+	int cnt = 0, i;
+	ssize_t n;
 
 	xassert(client->magic == CLIENT_IO_MAGIC);
 
@@ -452,35 +460,49 @@ _client_write(eio_obj_t *obj, List objs)
 
 	debug5("  client->out_remaining = %d", client->out_remaining);
 
+	msgs[0] = client->out_msg;
+	iov[0].iov_base = client->out_msg->data +
+		(client->out_msg->length - client->out_remaining);
+	iov[0].iov_len = client->out_remaining;
+	for (cnt = 1; cnt < STDIO_MAX_IOV; cnt++) {
+		if (!(msgs[cnt] = list_dequeue(client->msg_queue)))
+			break;
+		iov[cnt].iov_base = msgs[cnt]->data;
+		iov[cnt].iov_len = msgs[cnt]->length;
+	}
+
 	/*
-	 * Write message to socket.
+	 * Write messages to socket.
 	 */
-	buf = client->out_msg->data +
-		(client->out_msg->length - client->out_remaining);
 again:
-	if ((n = write(obj->fd, buf, client->out_remaining)) < 0) {
+	if ((n = writev(obj->fd, iov, cnt)) < 0) {
 		if (errno == EINTR) {
 			goto again;
 		} else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
 			debug5("_client_write returned EAGAIN");
-			return SLURM_SUCCESS;
+			n = 0;
 		} else {
 			client->out_eof = true;
+			for (i = 1; i < cnt; i++)
+				_free_outgoing_msg(msgs[i], client->job);
 			_free_all_outgoing_msgs(client->msg_queue, client->job);
 			return SLURM_SUCCESS;
 		}
 	}
-	if (n < client->out_remaining) {
-		error("Only wrote %d of %d bytes to socket",
-		      n, client->out_remaining);
-	} else
-		debug5("Wrote %d bytes to socket", n);
-	client->out_remaining -= n;
-	if (client->out_remaining > 0)
-		return SLURM_SUCCESS;
+	debug5("Wrote %zd bytes of %d messages to socket", n, cnt);
 
-	_free_outgoing_msg(client->out_msg, client->job);
+	/* Release what was sent, requeue what was not in the same order */
+	for (i = 0; (i < cnt) && ((size_t) n >= iov[i].iov_len); i++) {
+		n -= iov[i].iov_len;
+		_free_outgoing_msg(msgs[i], client->job);
+	}
 	client->out_msg = NULL;
+	if (i < cnt) {
+		for (int j = cnt - 1; j > i; j--)
+			list_push(client->msg_queue, msgs[j]);
+		client->out_msg = msgs[i];
+		client->out_remaining = iov[i].iov_len - n;
+	}
 
 	return SLURM_SUCCESS;
 }
@@ -505,69 +527,77 @@ _local_file_writable(eio_obj_t *obj)
 
 /*
  * The slurmstepd writes I/O to a file, possibly adding a label.
+ * Drain up to STDIO_MAX_IOV queued messages per call instead of going back
+ * to poll() between each MAX_MSG_LEN chunk.
  */
 static int
 _local_file_write(eio_obj_t *obj, List objs)
 {
 	struct client_io_info *client = (struct client_io_info *) obj->arg;
 	void *buf;
-	int n;
+	int n, cnt;
 	struct slurm_io_header header;
 	buf_t *header_tmp_buf;
 
 	xassert(client->magic == CLIENT_IO_MAGIC);
-	/*
-	 * If we aren't already in the middle of sending a message, get the
-	 * next message from the queue.
-	 */
-	if (client->out_msg == NULL) {
-		client->out_msg = list_dequeue(client->msg_queue);
+
+	for (cnt = 0; cnt < STDIO_MAX_IOV; cnt++) {
+		/*
+		 * If we aren't already in the middle of sending a message,
+		 * get the next message from the queue.
+		 */
 		if (client->out_msg == NULL) {
-			return SLURM_SUCCESS;
+			client->out_msg = list_dequeue(client->msg_queue);
+			if (client->out_msg == NULL) {
+				return SLURM_SUCCESS;
+			}
+			client->out_remaining = client->out_msg->length -
+						io_hdr_packed_size();
 		}
-		client->out_remaining = client->out_msg->length -
-					io_hdr_packed_size();
-	}
 
-	/*
-	 * This code to make a buffer, fill it, unpack its contents, and free
-	 * it is just used to read the header to get the global task id.
-	 */
-	header_tmp_buf = create_buf(client->out_msg->data,
-				    client->out_msg->length);
-	if (!header_tmp_buf) {
-		fatal("Failure to allocate memory for a message header");
-		return SLURM_ERROR;	/* Fix CLANG false positive error */
-	}
-	io_hdr_unpack(&header, header_tmp_buf);
-	header_tmp_buf->head = NULL;	/* CLANG false positive bug here */
-	free_buf(header_tmp_buf);
+		/*
+		 * This code to make a buffer, fill it, unpack its contents,
+		 * and free it is just used to read the header to get the
+		 * global task id.
+		 */
+		header_tmp_buf = create_buf(client->out_msg->data,
+					    client->out_msg->length);
+		if (!header_tmp_buf) {
+			fatal("Failure to allocate memory for a message header");
+			return SLURM_ERROR;	/* Fix CLANG false positive error */
+		}
+		io_hdr_unpack(&header, header_tmp_buf);
+		header_tmp_buf->head = NULL;	/* CLANG false positive bug here */
+		free_buf(header_tmp_buf);
 
-	/*
-	 * A zero-length message indicates the end of a stream from one
-	 * of the tasks.  Just free the message and return.
-	 */
-	if (header.length == 0) {
-		_free_outgoing_msg(client->out_msg, client->job);
-		client->out_msg = NULL;
-		return SLURM_SUCCESS;
-	}
+		/*
+		 * A zero-length message indicates the end of a stream from
+		 * one of the tasks.  Just free the message and continue.
+		 */
+		if (header.length == 0) {
+			_free_outgoing_msg(client->out_msg, client->job);
+			client->out_msg = NULL;
+			continue;
+		}
 
-	/* Write the message to the file. */
-	buf = client->out_msg->data +
-		(client->out_msg->length - client->out_remaining);
-	n = write_labelled_message(obj->fd, buf, client->out_remaining,
-				   header.gtaskid, client->job->het_job_offset,
-				   client->job->het_job_task_offset,
-				   client->labelio, client->taskid_width);
-	if (n < 0) {
-		client->out_eof = true;
-		_free_all_outgoing_msgs(client->msg_queue, client->job);
-		return SLURM_ERROR;
-	}
+		/* Write the message to the file. */
+		buf = client->out_msg->data +
+			(client->out_msg->length - client->out_remaining);
+		n = write_labelled_message(obj->fd, buf, client->out_remaining,
+					   header.gtaskid,
+					   client->job->het_job_offset,
+					   client->job->het_job_task_offset,
+					   client->labelio,
+					   client->taskid_width);
+		if (n < 0) {
+			client->out_eof = true;
+			_free_all_outgoing_msgs(client->msg_queue, client->job);
+			return SLURM_ERROR;
+		}
 
-	client->out_remaining -= n;
-	if (client->out_remaining == 0) {
+		client->out_remaining -= n;
+		if (client->out_remaining > 0)
+			break;
 		_free_outgoing_msg(client->out_msg, client->job);
 		client->out_msg = NULL;
 	}
@@ -708,7 +738,7 @@ _create_task_out_eio(int fd, uint16_t type,
 	out->gtaskid = task->gtid;
 	out->ltaskid = task->id;
 	out->job = job;
-	out->buf = cbuf_create(MAX_MSG_LEN, MAX_MSG_LEN*4);
+	out->buf = cbuf_create(MAX_MSG_LEN, STDIO_MAX_TASK_BUF);
 	out->eof = false;
 	out->eof_msg_sent = false;
 	if (cbuf_opt_set(out->buf, CBUF_OPT_OVERWRITE, CBUF_NO_DROP) == -1)
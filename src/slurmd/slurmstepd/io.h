@@ -50,6 +50,16 @@
 #define STDIO_MAX_FREE_BUF 1024
 #define STDIO_MAX_MSG_CACHE 128
 
+/*
+ * The buffer holding a task's stdout or stderr starts at MAX_MSG_LEN and only
+ * grows up to STDIO_MAX_TASK_BUF for tasks writing faster than we can send, so
+ * that a single read() drains many messages worth of output.
+ */
+#define STDIO_MAX_TASK_BUF (MAX_MSG_LEN * 64)
+
+/* Maximum number of queued messages sent to a client with a single writev() */
+#define STDIO_MAX_IOV 64
+
 struct io_buf {
 	int ref_count;
 	uint32_t length;
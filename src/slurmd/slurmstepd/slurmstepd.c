@@ -40,6 +40,7 @@
 
 #include "config.h"
 
+#include <poll.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <sys/mman.h>
@@ -77,6 +78,7 @@
 #include "src/slurmd/slurmstepd/slurmstepd.h"
 #include "src/slurmd/slurmstepd/slurmstepd_job.h"
 
+static bool _wait_for_slurmd(int sock);
 static int _init_from_slurmd(int sock, char **argv, slurm_addr_t **_cli,
 			     slurm_addr_t **_self, slurm_msg_t **_msg);
 
@@ -133,6 +135,14 @@ main (int argc, char **argv)
 	if (slurm_auth_init(NULL) != SLURM_SUCCESS)
 		fatal( "failed to initialize authentication plugin" );
 
+	/*
+	 * With LaunchParameters=slurmstepd_pool we may have been started
+	 * ahead of any launch. Exit quietly if slurmd closes the pipe
+	 * instead of sending one (reconfigure or shutdown).
+	 */
+	if (!_wait_for_slurmd(STDIN_FILENO))
+		exit(0);
+
 	/* Receive job parameters from the slurmd */
 	_init_from_slurmd(STDIN_FILENO, argv, &cli, &self, &msg);
 
@@ -505,6 +515,22 @@ static void _set_job_log_prefix(slurm_step_id_t *step_id)
 	log_set_fpfx(&buf);
 }
 
+/*
+ * Block until slurmd sends the launch data.
+ * RET false if slurmd closed the pipe without sending anything.
+ */
+static bool _wait_for_slurmd(int sock)
+{
+	struct pollfd pfd = { .fd = sock, .events = POLLIN };
+
+	while (poll(&pfd, 1, -1) < 0) {
+		if ((errno != EINTR) && (errno != EAGAIN))
+			return true;	/* let the read report the error */
+	}
+
+	return (pfd.revents & POLLIN);
+}
+
 /*
  *  This function handles the initialization information from slurmd
  *  sent by _send_slurmstepd_init() in src/slurmd/slurmd/req.c.
@@ -0,0 +1,107 @@
+/*****************************************************************************\
+ *  bitstring-bench.c - time the bulk bitstring operations with each of the
+ *  word kernels supported by this CPU.
+ *
+ *  Built by "make check" but not run as a test. Usage:
+ *	bitstring-bench [iterations]
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "src/common/bitstring.h"
+
+static volatile int64_t sink;
+
+static double _now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1e9) + ts.tv_nsec;
+}
+
+/* Run one operation "iters" times and report ns per call */
+#define BENCH(_name, _stmt) do {					\
+	double start = _now_ns();					\
+	for (int _i = 0; _i < iters; _i++) {				\
+		_stmt;							\
+	}								\
+	printf("  %-16s %10.1f ns/op\n", _name,			\
+	       (_now_ns() - start) / iters);				\
+} while (0)
+
+static void _bench_width(int nbits, int iters)
+{
+	bitstr_t *b1 = bit_alloc(nbits), *b2 = bit_alloc(nbits);
+	bitstr_t *b3 = bit_alloc(nbits), *last = bit_alloc(nbits);
+	int i;
+
+	srandom(nbits);
+	for (i = 0; i < nbits; i++) {
+		if (random() & 1)
+			bit_set(b1, i);
+		else
+			bit_set(b2, i);	/* disjoint from b1 */
+	}
+	bit_set(last, nbits - 1);
+
+	printf(" %d bits:\n", nbits);
+	BENCH("bit_and", bit_copybits(b3, b1); bit_and(b3, b2));
+	BENCH("bit_or", bit_copybits(b3, b1); bit_or(b3, b2));
+	BENCH("bit_and_not", bit_copybits(b3, b1); bit_and_not(b3, b2));
+	BENCH("bit_copybits", bit_copybits(b3, b1));
+	BENCH("bit_set_count", sink += bit_set_count(b1));
+	BENCH("bit_overlap", sink += bit_overlap(b1, b2));
+	BENCH("bit_overlap_any", sink += bit_overlap_any(b1, b2));
+	BENCH("bit_super_set", sink += bit_super_set(b1, b1));
+	BENCH("bit_ffs", sink += bit_ffs(last));
+
+	bit_free(b1);
+	bit_free(b2);
+	bit_free(b3);
+	bit_free(last);
+}
+
+int main(int argc, char **argv)
+{
+	char *sets[] = { "generic", "popcnt", "avx2", "avx512", NULL };
+	int widths[] = { 10000, 30000, 100000, 0 };
+	int iters = 20000;
+
+	if (argc > 1)
+		iters = atoi(argv[1]);
+	if (iters < 1)
+		iters = 1;
+
+	printf("Default word kernels: %s\n", bit_kernels_name());
+	for (int j = 0; sets[j]; j++) {
+		if (bit_kernels_select(sets[j]))
+			continue;	/* Not supported by this CPU */
+		printf("Word kernels %s:\n", sets[j]);
+		for (int w = 0; widths[w]; w++)
+			_bench_width(widths[w], iters);
+	}
+	bit_kernels_select(NULL);
+
+	return 0;
+}
@@ -193,6 +193,86 @@ main(int argc, char *argv[])
 		TEST(bit_equal(bs, bs2), "bitstring");
 	}
 
+	note("Testing word kernels (%s)", bit_kernels_name());
+	{
+		char *sets[] = { "generic", "popcnt", "avx2", "avx512", NULL };
+		int nbits = 10007, i, j, cnt1, cnt2, both;
+
+		for (j = 0; sets[j]; j++) {
+			bitstr_t *bs1 = bit_alloc(nbits);
+			bitstr_t *bs2 = bit_alloc(nbits);
+			bitstr_t *bs3;
+
+			if (bit_kernels_select(sets[j]) != 0)
+				continue;	/* Not supported by this CPU */
+			note("Word kernels %s", sets[j]);
+
+			srandom(j + 1);
+			cnt1 = cnt2 = both = 0;
+			for (i = 0; i < nbits; i++) {
+				int in1 = !(random() % 3), in2 = !(random() % 5);
+				if (in1) {
+					bit_set(bs1, i);
+					cnt1++;
+				}
+				if (in2) {
+					bit_set(bs2, i);
+					cnt2++;
+				}
+				if (in1 && in2)
+					both++;
+			}
+			TEST(bit_set_count(bs1) == cnt1, "kernel count");
+			TEST(bit_overlap(bs1, bs2) == both, "kernel overlap");
+			TEST(bit_overlap_any(bs1, bs2), "kernel overlap_any");
+			TEST(bit_set_count_range(bs1, 3, nbits - 5) ==
+			     (cnt1 - bit_test(bs1, 0) - bit_test(bs1, 1) -
+			      bit_test(bs1, 2) - bit_test(bs1, nbits - 5) -
+			      bit_test(bs1, nbits - 4) - bit_test(bs1, nbits - 3) -
+			      bit_test(bs1, nbits - 2) - bit_test(bs1, nbits - 1)),
+			     "kernel count_range");
+
+			bs3 = bit_copy(bs1);
+			bit_and(bs3, bs2);
+			TEST(bit_set_count(bs3) == both, "kernel and");
+			TEST(bit_super_set(bs3, bs1), "kernel super_set");
+			TEST(!bit_super_set(bs1, bs3), "kernel !super_set");
+			bit_and_not(bs3, bs2);
+			TEST(bit_set_count(bs3) == 0, "kernel and_not");
+			TEST(bit_ffs(bs3) == -1, "kernel ffs empty");
+			bit_set(bs3, nbits - 70);
+			TEST(bit_ffs(bs3) == nbits - 70, "kernel ffs");
+			TEST(!bit_overlap_any(bs3, bs2) ==
+			     !bit_test(bs2, nbits - 70), "kernel overlap_any");
+			bit_or(bs3, bs1);
+			TEST(bit_set_count(bs3) ==
+			     cnt1 + !bit_test(bs1, nbits - 70), "kernel or");
+
+			bit_free(bs1);
+			bit_free(bs2);
+			bit_free(bs3);
+		}
+		bit_kernels_select(NULL);
+	}
+
+	note("Testing caller allocated bitstrings");
+	{
+		bitstr_t words[BITSTR_WORDS(130)], *bs;
+		uint64_t allocs = bit_alloc_count();
+
+		bs = bit_init(words, 130);
+		TEST(bit_size(bs) == 130, "bit_init size");
+		TEST(bit_ffs(bs) == -1, "bit_init clear");
+		bit_nset(bs, 60, 129);
+		TEST(bit_set_count(bs) == 70, "bit_init nset");
+		TEST(bit_alloc_count() == allocs, "bit_init no allocation");
+
+		bs = bit_copy(bs);
+		TEST(bit_alloc_count() == allocs + 1, "bit_alloc_count copy");
+		TEST(bit_equal(bs, (bitstr_t *) words), "bit_init copy");
+		bit_free(bs);
+	}
+
 	totals();
 	return failed;
 }